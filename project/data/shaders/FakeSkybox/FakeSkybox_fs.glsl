@@ -9,7 +9,8 @@ struct Material
 	vec3 Diffuse;
 
 	bool TextureDiffuseEnabled;
-	sampler2D TextureDiffuse;
+	sampler2DArray TextureDiffuse; // Single layer unless packed into an array
+	int TextureDiffuseLayer;
 };
 
 // Obj
@@ -26,6 +27,6 @@ void main()
 	FragColor = vec4(0.0f);
 	if (u_Material.TextureDiffuseEnabled) 
 	{
-		FragColor = vec4(texture(u_Material.TextureDiffuse, TexCoords).rgb * u_Material.Diffuse, 1.0f);
+		FragColor = vec4(texture(u_Material.TextureDiffuse, vec3(TexCoords, u_Material.TextureDiffuseLayer)).rgb * u_Material.Diffuse, 1.0f);
 	}
 }
\ No newline at end of file
@@ -7,12 +7,16 @@ struct Material
 	vec3 Diffuse;
 	vec3 Specular; // Unused
 	
-	sampler2D TextureAmbient; // Unused
+	// Textures are arrays, plain ones have a single layer
+	sampler2DArray TextureAmbient; // Unused
 	bool TextureAmbientEnabled; // Unused
-	sampler2D TextureDiffuse;
+	int TextureAmbientLayer; // Unused
+	sampler2DArray TextureDiffuse;
 	bool TextureDiffuseEnabled;
-	sampler2D TextureSpecular; // Unused
+	int TextureDiffuseLayer;
+	sampler2DArray TextureSpecular; // Unused
 	bool TextureSpecularEnabled; // Unused
+	int TextureSpecularLayer; // Unused
 
 	float Shininess; // Unused
 };
@@ -29,6 +33,6 @@ out vec4 FragColor;
 void main()
 {
 	if (u_Material.TextureDiffuseEnabled)
-		FragColor = vec4(texture(u_Material.TextureDiffuse, TexCoords).rgb * u_Material.Diffuse, 1.0f);
+		FragColor = vec4(texture(u_Material.TextureDiffuse, vec3(TexCoords, u_Material.TextureDiffuseLayer)).rgb * u_Material.Diffuse, 1.0f);
 	else FragColor = vec4(u_Material.Diffuse, 1.0f);
 }
\ No newline at end of file
@@ -4,7 +4,6 @@
 precision highp float;
 
 #define DIRECTIONAL_LIGHTS_MAX 1
-#define POINT_LIGHTS_MAX 10
 
 // Type definitions
 struct Material
@@ -13,12 +12,16 @@ struct Material
 	vec3 Diffuse;
 	vec3 Specular;
 	
-	sampler2D TextureAmbient;
+	// Textures are arrays, plain ones have a single layer
+	sampler2DArray TextureAmbient;
 	bool TextureAmbientEnabled;
-	sampler2D TextureDiffuse;
+	int TextureAmbientLayer;
+	sampler2DArray TextureDiffuse;
 	bool TextureDiffuseEnabled;
-	sampler2D TextureSpecular;
+	int TextureDiffuseLayer;
+	sampler2DArray TextureSpecular;
 	bool TextureSpecularEnabled;
+	int TextureSpecularLayer;
 
 	float Shininess;
 };
@@ -36,22 +39,39 @@ struct DirectionalLight
 struct PointLight
 {
 	vec3 Position;
-	float Intensity;
+	float Range; // Zero lights everything
 
+	float Intensity;
 	vec3 Ambient;
 	vec3 Diffuse;
 	vec3 Specular;
+};
 
-	// TODO: Attenuation
+// Shared blocks
+layout (std140) uniform Camera
+{
+	mat4 u_View;
+	mat4 u_Projection;
+	vec3 u_ViewPosition;
 };
 
+// Must match LightsBlock in LightManager.h
+layout (std140) uniform Lights
+{
+	int u_DirectionalLightCount;
+	int u_PointLightCount;
+	uvec4 u_ClusterCount;
+	vec4 u_ClusterDepth; // Near, far, slice scale, slice bias
+	DirectionalLight u_DirectionalLights[DIRECTIONAL_LIGHTS_MAX];
+};
+
+// Shared textures, point lights are four texels each, the grid holds offset and count per cluster
+uniform samplerBuffer u_LightData;
+uniform usamplerBuffer u_ClusterGrid;
+uniform usamplerBuffer u_ClusterLights;
+
 // Uniforms
 uniform Material u_Material;
-uniform vec3 u_ViewPosition;
-uniform int u_DirectionalLightCount;
-uniform DirectionalLight u_DirectionalLights[DIRECTIONAL_LIGHTS_MAX];
-uniform int u_PointLightCount;
-uniform PointLight u_PointLights[POINT_LIGHTS_MAX];
 
 // Input vars
 in vec3 Normal;
@@ -78,23 +98,63 @@ void ProcessDirectionalLight(in int index, in vec3 normal, in vec3 viewDirection
 	specular += s * u_DirectionalLights[index].Specular * u_DirectionalLights[index].Intensity;
 }
 
-void ProcessPointLight(in int index, in vec3 normal, in vec3 viewDirection, inout vec3 ambient, inout vec3 diffuse, inout vec3 specular) 
+PointLight FetchPointLight(in int index)
 {
-	vec3 lightDirection = normalize(u_PointLights[index].Position - WorldPos);
+	vec4 t0 = texelFetch(u_LightData, index * 4 + 0);
+	vec4 t1 = texelFetch(u_LightData, index * 4 + 1);
+
+	PointLight light;
+	light.Position = t0.xyz;
+	light.Range = t0.w;
+	light.Ambient = t1.xyz;
+	light.Intensity = t1.w;
+	light.Diffuse = texelFetch(u_LightData, index * 4 + 2).xyz;
+	light.Specular = texelFetch(u_LightData, index * 4 + 3).xyz;
+
+	return light;
+}
+
+int GetCluster()
+{
+	// Same grid as LightClusters, x and y in screen space, z in exponential depth slices
+	vec4 viewPos = u_View * vec4(WorldPos, 1.0f);
+	vec4 clipPos = u_Projection * viewPos;
+	vec2 ndc = clamp(clipPos.xy / clipPos.w, -1.0f, 0.9999f);
+
+	float depth = max(-viewPos.z, u_ClusterDepth.x);
+	uint x = uint((ndc.x * 0.5f + 0.5f) * float(u_ClusterCount.x));
+	uint y = uint((ndc.y * 0.5f + 0.5f) * float(u_ClusterCount.y));
+	uint z = uint(clamp(log(depth) * u_ClusterDepth.z + u_ClusterDepth.w, 0.0f, float(u_ClusterCount.z - 1u)));
 
-	// TODO: Attenuation
+	return int(x + u_ClusterCount.x * (y + u_ClusterCount.y * z));
+}
+
+void ProcessPointLight(in int index, in vec3 normal, in vec3 viewDirection, inout vec3 ambient, inout vec3 diffuse, inout vec3 specular) 
+{
+	PointLight light = FetchPointLight(index);
+	vec3 toLight = light.Position - WorldPos;
+	vec3 lightDirection = normalize(toLight);
+
+	// Windowed falloff so ranged lights reach zero at the edge of their cluster bounds
+	float intensity = light.Intensity;
+	if (light.Range > 0.0f)
+	{
+		float r = length(toLight) / light.Range;
+		float window = clamp(1.0f - r * r * r * r, 0.0f, 1.0f);
+		intensity *= window * window;
+	}
 
 	// Ambient
-	ambient += u_PointLights[index].Ambient * u_PointLights[index].Intensity;
+	ambient += light.Ambient * intensity;
 
 	// Diffuse
 	float d = max(0.0f, dot(normal, lightDirection));
-	diffuse += d * u_PointLights[index].Diffuse * u_PointLights[index].Intensity;
+	diffuse += d * light.Diffuse * intensity;
 
 	// Specular
 	vec3 reflectDirection = reflect(-lightDirection, normal);
     float s = pow(max(0.0f, dot(viewDirection, reflectDirection)), u_Material.Shininess);
-	specular += s * u_PointLights[index].Specular * u_PointLights[index].Intensity;
+	specular += s * light.Specular * intensity;
 }
 
 void main()
@@ -112,19 +172,20 @@ void main()
 	for (int i = 0; i < u_DirectionalLightCount; i++)
 		ProcessDirectionalLight(i, normal, viewDirection, ambient, diffuse, specular);
 
-	// Apply point lights
-	for (int i = 0; i < u_PointLightCount; i++)
-		ProcessPointLight(i, normal, viewDirection, ambient, diffuse, specular);
+	// Apply point lights of this cluster only
+	uvec2 cluster = texelFetch(u_ClusterGrid, GetCluster()).xy;
+	for (uint i = 0u; i < cluster.y; i++)
+		ProcessPointLight(int(texelFetch(u_ClusterLights, int(cluster.x + i)).x), normal, viewDirection, ambient, diffuse, specular);
 
 	// Update colors with material properties
 	if (u_Material.TextureAmbientEnabled)
-		ambient *= texture(u_Material.TextureAmbient, TexCoords).rgb * u_Material.Ambient;
+		ambient *= texture(u_Material.TextureAmbient, vec3(TexCoords, u_Material.TextureAmbientLayer)).rgb * u_Material.Ambient;
 	else ambient *= u_Material.Ambient;
 	if (u_Material.TextureDiffuseEnabled)
-		diffuse *= texture(u_Material.TextureDiffuse, TexCoords).rgb * u_Material.Diffuse;
+		diffuse *= texture(u_Material.TextureDiffuse, vec3(TexCoords, u_Material.TextureDiffuseLayer)).rgb * u_Material.Diffuse;
 	else diffuse *= u_Material.Diffuse;
 	if (u_Material.TextureSpecularEnabled)
-		specular *= texture(u_Material.TextureSpecular, TexCoords).rgb * u_Material.Specular;
+		specular *= texture(u_Material.TextureSpecular, vec3(TexCoords, u_Material.TextureSpecularLayer)).rgb * u_Material.Specular;
 	else specular *= u_Material.Specular;
 
 	// Set color
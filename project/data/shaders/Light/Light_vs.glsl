@@ -8,10 +8,16 @@ layout (location = 0) in vec3 a_Pos;
 layout (location = 1) in vec3 a_Normal;
 layout (location = 2) in vec2 a_TexCoords;
 
+// Shared blocks
+layout (std140) uniform Camera
+{
+	mat4 u_View;
+	mat4 u_Projection;
+	vec3 u_ViewPosition;
+};
+
 // Input uniforms
 uniform mat4 u_Transform;
-uniform mat4 u_View;
-uniform mat4 u_Projection;
 
 // Output vars
 out vec3 Normal;
@@ -0,0 +1,41 @@
+#version 410 core
+
+// Set precisions
+precision highp float;
+
+// Attributes
+layout (location = 0) in vec3 a_Pos;
+layout (location = 1) in vec3 a_Normal;
+layout (location = 2) in vec2 a_TexCoords;
+
+// Instance attributes
+layout (location = 3) in vec3 a_StarPosition;
+layout (location = 4) in float a_StarScaleRate;
+layout (location = 5) in vec2 a_StarSize; // Min, max
+
+// Shared blocks
+layout (std140) uniform Camera
+{
+	mat4 u_View;
+	mat4 u_Projection;
+	vec3 u_ViewPosition;
+};
+
+// Input uniforms
+uniform mat4 u_Transform;
+uniform float u_Time; // Seconds
+
+// Output vars
+out vec2 TexCoords;
+
+void main()
+{
+	// Make star "twinkle"
+	float size = a_StarSize.x + sin(u_Time * a_StarScaleRate) * a_StarSize.y;
+
+	// Set vertex position
+	gl_Position = u_Projection * u_View * u_Transform * vec4(a_Pos * size + a_StarPosition, 1.0f);
+	
+	// Set output vars
+	TexCoords = a_TexCoords;
+}
\ No newline at end of file
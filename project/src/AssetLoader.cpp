@@ -0,0 +1,70 @@
+#include "AssetLoader.h"
+
+AssetLoader::AssetLoader(JobSystem *jobSystem)
+	: m_JobSystem(jobSystem), m_Pending(0)
+{
+}
+
+void AssetLoader::Load(JobFunction work, JobFunction complete, JobCounter *counter)
+{
+	m_Pending.fetch_add(1, std::memory_order_acq_rel);
+	if (counter)
+		counter->Increment();
+
+	// Counters are decremented along with queuing the completion, under the lock so the
+	// completion cannot run and free the counter before it was decremented
+	m_JobSystem->Run([this, work, complete, counter]()
+	{
+		work();
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Completions.push_back(complete);
+
+		if (counter)
+			counter->Decrement();
+	}, &m_Counter);
+}
+
+unsigned int AssetLoader::Update()
+{
+	if (m_JobSystem->GetWorkerCount() == 0)
+		m_JobSystem->Wait(&m_Counter);
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Running.swap(m_Completions);
+	}
+
+	// Completions may start new loads
+	const auto count = static_cast<unsigned int>(m_Running.size());
+	for (auto &complete : m_Running)
+		complete();
+
+	m_Running.clear();
+	m_Pending.fetch_sub(count, std::memory_order_acq_rel);
+
+	return count;
+}
+
+void AssetLoader::Wait(JobCounter *counter)
+{
+	m_JobSystem->Wait(counter);
+	Update();
+}
+
+void AssetLoader::WaitAll()
+{
+	// Completions can queue more loads
+	while (GetPendingCount() > 0)
+		Wait(&m_Counter);
+}
+
+unsigned int AssetLoader::GetPendingCount() const
+{
+	return m_Pending.load(std::memory_order_acquire);
+}
+
+JobSystem *AssetLoader::GetJobSystem() const
+{
+	return m_JobSystem;
+}
\ No newline at end of file
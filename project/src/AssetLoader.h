@@ -0,0 +1,48 @@
+#pragma once
+
+#include "JobSystem.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// Runs the file reading and decoding part of asset loads on the job system and hands the
+// rest back to the GL thread, which creates the GL objects when it calls Update.
+// Without workers the loads run on the GL thread during Update
+class AssetLoader
+{
+	JobSystem *m_JobSystem;
+	JobCounter m_Counter; // Loads still working
+
+	std::mutex m_Mutex;
+	std::vector<JobFunction> m_Completions;
+	std::vector<JobFunction> m_Running; // GL thread only
+	std::atomic<unsigned int> m_Pending; // Loads not completed yet
+
+public:
+	explicit AssetLoader(JobSystem *jobSystem);
+	~AssetLoader() = default;
+
+	// No copying/moving
+	AssetLoader(const AssetLoader &) = delete;
+	AssetLoader &operator=(const AssetLoader &) = delete;
+
+	AssetLoader(const AssetLoader &&) = delete;
+	AssetLoader &operator=(const AssetLoader &&) = delete;
+
+	// Runs work on any thread, then complete on the GL thread. Neither may throw, failures
+	// are recorded by work for complete to report. The counter is done once complete is queued
+	void Load(JobFunction work, JobFunction complete, JobCounter *counter = nullptr);
+
+	// Runs the completions queued so far, call once per frame on the GL thread.
+	// Returns the number of loads completed
+	unsigned int Update();
+
+	// Helps with loads until the counter is done, then runs the queued completions
+	void Wait(JobCounter *counter);
+
+	// Completes every load, call before destroying what the loads refer to
+	void WaitAll();
+
+	unsigned int GetPendingCount() const;
+	JobSystem *GetJobSystem() const;
+};
\ No newline at end of file
@@ -0,0 +1,364 @@
+#include "Benchmark.h"
+#include "JobSystem.h"
+#include "Object.h"
+#include "Memory.h"
+#include "Log.h"
+#include "Transform.h"
+#include "TransformSystem.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/quaternion.hpp>
+
+typedef std::chrono::high_resolution_clock BenchmarkClock;
+
+static double getElapsedMs(const BenchmarkClock::time_point &start)
+{
+	return std::chrono::duration<double, std::milli>(BenchmarkClock::now() - start).count();
+}
+
+// Copy of the original block tracker, kept to compare against
+namespace Legacy
+{
+	struct Block
+	{
+		std::string TypeName;
+		size_t TypeHash;
+		uint64_t Size;
+		const void *Data;
+	};
+
+	std::map<void *, Block> g_MemoryBlocks;
+	uint64_t g_MemoryAllocated;
+	std::mutex g_MemoryMutex;
+
+	void *MemoryAllocate(const std::string &name, size_t hash, uint64_t size)
+	{
+		g_MemoryMutex.lock();
+
+		const auto ptr = malloc(size);
+		memset(ptr, 0, size);
+
+		g_MemoryAllocated += size;
+		g_MemoryBlocks.insert({ ptr, { name, hash, size, ptr } });
+		g_MemoryMutex.unlock();
+
+		return ptr;
+	}
+
+	void MemoryFree(void *ptr)
+	{
+		g_MemoryMutex.lock();
+
+		const auto it = g_MemoryBlocks.find(ptr);
+		free(ptr);
+
+		g_MemoryAllocated -= it->second.Size;
+		g_MemoryBlocks.erase(it);
+
+		g_MemoryMutex.unlock();
+	}
+}
+
+// Type used to tag benchmark allocations
+struct MemoryBenchmarkObject
+{
+};
+
+// Sizes seen in a typical scene (Value, ShaderVariable, MaterialVariable, Model, etc.)
+static const uint64_t kBenchmarkSizes[] = { 8, 16, 24, 48, 64, 80, 96, 128, 200, 256 };
+static const size_t kBenchmarkSizeCount = sizeof(kBenchmarkSizes) / sizeof(kBenchmarkSizes[0]);
+
+template<typename TAllocate, typename TFree>
+static void runMemoryWorkload(unsigned int iterations, unsigned int batchSize, TAllocate allocate, TFree release)
+{
+	std::vector<void *> blocks(batchSize);
+	for (unsigned int i = 0; i < iterations; i++)
+	{
+		for (unsigned int j = 0; j < batchSize; j++)
+			blocks[j] = allocate(kBenchmarkSizes[(i + j) % kBenchmarkSizeCount]);
+
+		// Free in a different order than allocated
+		for (unsigned int j = 0; j < batchSize; j += 2)
+			release(blocks[j]);
+		for (unsigned int j = 1; j < batchSize; j += 2)
+			release(blocks[j]);
+	}
+}
+
+template<typename TAllocate, typename TFree>
+static double timeMemoryWorkload(unsigned int iterations, unsigned int batchSize, unsigned int threadCount, TAllocate allocate, TFree release)
+{
+	const auto start = BenchmarkClock::now();
+
+	std::vector<std::thread> threads;
+	for (unsigned int i = 0; i < threadCount; i++)
+		threads.emplace_back([=]() { runMemoryWorkload(iterations, batchSize, allocate, release); });
+	for (auto &t : threads)
+		t.join();
+
+	return getElapsedMs(start);
+}
+
+void BenchmarkMemory(unsigned int iterations, unsigned int batchSize, unsigned int threadCount)
+{
+	const auto name = typeid(MemoryBenchmarkObject).name();
+	const auto hash = typeid(MemoryBenchmarkObject).hash_code();
+	const auto operations = static_cast<double>(iterations) * batchSize * threadCount * 2;
+
+	const auto legacyMs = timeMemoryWorkload(iterations, batchSize, threadCount,
+		[=](uint64_t size) { return Legacy::MemoryAllocate(name, hash, size); },
+		[](void *ptr) { Legacy::MemoryFree(ptr); });
+
+	const auto poolMs = timeMemoryWorkload(iterations, batchSize, threadCount,
+		[=](uint64_t size) { return MemoryAllocate(name, hash, size); },
+		[](void *ptr) { MemoryFree(ptr); });
+
+	LOG_INFO("Benchmark", "Memory (%u threads, %u x %u): map %.2fms (%.1fns/op), pool %.2fms (%.1fns/op), %.2fx",
+		threadCount, iterations, batchSize, legacyMs, legacyMs * 1000000.0 / operations,
+		poolMs, poolMs * 1000000.0 / operations, legacyMs / poolMs);
+}
+
+// Copy of the original eager transform, every setter walks the parent chain twice
+namespace Legacy
+{
+	class Transform
+	{
+		glm::vec3 m_Position;
+		glm::quat m_Rotation;
+		glm::vec3 m_Scale;
+		glm::mat4 m_Matrix;
+		Transform *m_Parent;
+
+		static void applyRotation(const Transform *transform, glm::mat4 &matrix)
+		{
+			if (transform->m_Parent)
+				applyRotation(transform->m_Parent, matrix);
+			matrix *= glm::toMat4(transform->m_Rotation);
+		}
+
+		static void applyPosition(const Transform *transform, glm::mat4 &matrix)
+		{
+			if (transform->m_Parent)
+				applyPosition(transform->m_Parent, matrix);
+			matrix = glm::translate(matrix, transform->m_Position);
+		}
+
+		void update()
+		{
+			glm::mat4 rotationTransform(1.0f);
+			applyRotation(this, rotationTransform);
+
+			glm::mat4 positionTransform(1.0f);
+			applyPosition(this, positionTransform);
+
+			m_Matrix = rotationTransform;
+			m_Matrix[3] = positionTransform[3];
+			m_Matrix = glm::scale(m_Matrix, m_Scale);
+		}
+
+	public:
+		Transform(Transform *parent = nullptr)
+			: m_Position(0.0f), m_Rotation(0.0f, 0.0f, 0.0f, 0.0f), m_Scale(1.0f), m_Matrix(1.0f), m_Parent(parent)
+		{
+		}
+
+		void SetPosition(const glm::vec3 &position)
+		{
+			m_Position = position;
+			update();
+		}
+
+		void SetScale(const glm::vec3 &scale)
+		{
+			m_Scale = scale;
+			update();
+		}
+
+		void SetRotation(const glm::vec3 &v, float radians)
+		{
+			m_Rotation = glm::toQuat(glm::rotate(glm::mat4(1.0f), radians, v));
+			update();
+		}
+
+		const glm::mat4 &GetMatrix() const
+		{
+			return m_Matrix;
+		}
+	};
+}
+
+// Every node is moved, rotated and scaled each frame, then every matrix is read as the renderer would
+template<typename TTransform>
+static double timeTransformWorkload(std::vector<TTransform> &transforms, unsigned int frames)
+{
+	const auto start = BenchmarkClock::now();
+
+	float checksum = 0.0f;
+	for (unsigned int frame = 0; frame < frames; frame++)
+	{
+		const auto t = static_cast<float>(frame);
+		for (auto &transform : transforms)
+		{
+			transform.SetPosition(glm::vec3(t, 0.0f, 1.0f));
+			transform.SetRotation(glm::vec3(0.0f, 1.0f, 0.0f), t * 0.01f);
+			transform.SetScale(glm::vec3(1.0f));
+		}
+
+		for (const auto &transform : transforms)
+			checksum += transform.GetMatrix()[3][0];
+	}
+
+	const auto elapsed = getElapsedMs(start);
+
+	// Keep the reads from being optimized out
+	if (checksum == -1.0f)
+		LOG_TRACE("Benchmark", "Checksum %f", checksum);
+
+	return elapsed;
+}
+
+// Builds nodeCount / depth chains of the given depth under one root, parents come before children
+template<typename TTransform>
+static void createTransformHierarchy(std::vector<TTransform> &transforms, unsigned int nodeCount, unsigned int depth)
+{
+	transforms.reserve(nodeCount + 1);
+	transforms.emplace_back();
+
+	const auto chains = std::max(1u, nodeCount / depth);
+	for (unsigned int i = 0; i < chains; i++)
+	{
+		auto parent = &transforms[0];
+		for (unsigned int j = 0; j < depth; j++)
+		{
+			transforms.emplace_back(parent);
+			parent = &transforms.back();
+		}
+	}
+}
+
+void BenchmarkTransforms(unsigned int nodeCount, unsigned int depth, unsigned int frames)
+{
+	std::vector<Legacy::Transform> legacyTransforms;
+	createTransformHierarchy(legacyTransforms, nodeCount, depth);
+	const auto legacyMs = timeTransformWorkload(legacyTransforms, frames);
+
+	std::vector<Transform> transforms;
+	createTransformHierarchy(transforms, nodeCount, depth);
+	const auto lazyMs = timeTransformWorkload(transforms, frames);
+
+	LOG_INFO("Benchmark", "Transforms (%u nodes, depth %u, %u frames): eager %.2fms (%.3fms/frame), lazy %.2fms (%.3fms/frame), %.2fx",
+		nodeCount, depth, frames, legacyMs, legacyMs / frames, lazyMs, lazyMs / frames, legacyMs / lazyMs);
+}
+
+void BenchmarkTransformSystem(unsigned int rootCount, unsigned int childCount, unsigned int frames)
+{
+	TransformSystem system(rootCount * (childCount + 1));
+	std::vector<TransformHandle> handles;
+	for (unsigned int i = 0; i < rootCount; i++)
+	{
+		const auto root = system.Create();
+		handles.push_back(root);
+		for (unsigned int j = 0; j < childCount; j++)
+			handles.push_back(system.Create(root));
+	}
+
+	// First update sorts the hierarchy
+	system.Update();
+
+	// Animate every transform, then update all world matrices in one pass
+	double setMs = 0.0;
+	double updateMs = 0.0;
+	for (unsigned int frame = 0; frame < frames; frame++)
+	{
+		const auto rotation = glm::angleAxis(frame * 0.01f, glm::vec3(0.0f, 1.0f, 0.0f));
+		const auto position = glm::vec3(static_cast<float>(frame), 0.0f, 1.0f);
+
+		auto start = BenchmarkClock::now();
+		for (const auto handle : handles)
+		{
+			system.SetPosition(handle, position);
+			system.SetRotation(handle, rotation);
+		}
+		setMs += getElapsedMs(start);
+
+		start = BenchmarkClock::now();
+		system.Update();
+		updateMs += getElapsedMs(start);
+	}
+
+	LOG_INFO("Benchmark", "Transform system (%u transforms, %u frames): set %.3fms/frame, update %.3fms/frame",
+		static_cast<unsigned int>(handles.size()), frames, setMs / frames, updateMs / frames);
+}
+
+// Same work as a star without a model, twinkles by writing its own transform only since
+// matrices must not be resolved during parallel updates
+class BenchmarkStar : public Object
+{
+	Transform m_Transform;
+	float m_ScaleRate;
+
+public:
+	BenchmarkStar(float scaleRate)
+		: Object("BenchmarkStar"), m_ScaleRate(scaleRate)
+	{
+		m_Transform.SetPosition(glm::vec3(scaleRate, 0.0f, 1.0f));
+	}
+
+	void Update(float time, float deltaTime) override
+	{
+		m_Transform.SetScale(glm::vec3(0.5f + sin(time / 1000.0f * m_ScaleRate) * 2.0f));
+	}
+};
+
+void BenchmarkJobs(unsigned int objectCount, unsigned int frames)
+{
+	const auto root = New<Object>("Root");
+	for (unsigned int i = 0; i < objectCount; i++)
+		root->CreateChild<BenchmarkStar>(1.0f + static_cast<float>(i % 100) / 50.0f);
+
+	// Serial baseline, then every worker count up to the hardware
+	const auto hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	double serialMs = 0.0;
+	for (unsigned int workers = 0; workers < hardwareThreads; workers = workers ? workers * 2 : 1)
+	{
+		JobSystem jobSystem(workers);
+		root->SetParallelUpdate(workers ? &jobSystem : nullptr);
+
+		const auto start = BenchmarkClock::now();
+		for (unsigned int frame = 0; frame < frames; frame++)
+			root->Update(frame * 16.0f, 16.0f);
+		const auto ms = getElapsedMs(start) / frames;
+
+		if (!workers)
+			serialMs = ms;
+
+		LOG_INFO("Benchmark", "Object update (%u objects, %u workers): %.3fms/frame, %.2fx", objectCount, workers, ms, serialMs / ms);
+	}
+
+	root->SetParallelUpdate(nullptr);
+	Delete(root);
+}
+
+void RunBenchmarks()
+{
+	LOG_INFO("Benchmark", "Running benchmarks...");
+
+	BenchmarkMemory(1000, 1000, 1);
+	BenchmarkMemory(1000, 1000, 4);
+
+	// Wide and deep 10k node hierarchies
+	BenchmarkTransforms(10000, 1, 10);
+	BenchmarkTransforms(10000, 100, 10);
+
+	// 100k animated transforms
+	BenchmarkTransformSystem(1000, 99, 100);
+
+	// 100k stars updated with more and more workers
+	BenchmarkJobs(100000, 100);
+}
\ No newline at end of file
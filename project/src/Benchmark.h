@@ -0,0 +1,9 @@
+#pragma once
+
+// Micro benchmarks, enabled by defining RUN_BENCHMARKS in Main.cpp
+void RunBenchmarks();
+
+void BenchmarkMemory(unsigned int iterations, unsigned int batchSize, unsigned int threadCount);
+void BenchmarkTransforms(unsigned int nodeCount, unsigned int depth, unsigned int frames);
+void BenchmarkTransformSystem(unsigned int rootCount, unsigned int childCount, unsigned int frames);
+void BenchmarkJobs(unsigned int objectCount, unsigned int frames);
\ No newline at end of file
@@ -0,0 +1,352 @@
+#include "BoundingVolumeHierarchy.h"
+#include <algorithm>
+#include <cfloat>
+
+BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+	: m_Cost(0.0f), m_BuildCost(0.0f), m_Dirty(false)
+{
+}
+
+unsigned int BoundingVolumeHierarchy::build(unsigned int parent, unsigned int first, unsigned int count)
+{
+	const auto index = static_cast<unsigned int>(m_Nodes.size());
+
+	TreeNode node;
+	node.Parent = parent;
+	node.Right = 0;
+	node.First = first;
+	node.Count = count;
+
+	BoundingBox centroidBounds;
+	for (unsigned int i = first; i < first + count; i++)
+	{
+		node.Bounds.Add(m_Items[m_ItemOrder[i]].Bounds);
+		centroidBounds.Add(m_Centroids[m_ItemOrder[i]]);
+	}
+
+	m_Nodes.push_back(node);
+
+	if (count <= BVH_LEAF_SIZE)
+	{
+		for (unsigned int i = first; i < first + count; i++)
+			m_Items[m_ItemOrder[i]].Leaf = index;
+
+		m_Cost += node.Bounds.GetSurfaceArea() * count;
+		return index;
+	}
+
+	m_Cost += node.Bounds.GetSurfaceArea();
+
+	// Split along the axis the centroids spread the most
+	const auto extents = centroidBounds.Max - centroidBounds.Min;
+	auto axis = 0;
+	if (extents.y > extents[axis])
+		axis = 1;
+	if (extents.z > extents[axis])
+		axis = 2;
+
+	const auto begin = m_ItemOrder.begin() + first;
+	const auto end = begin + count;
+	auto leftCount = count / 2;
+
+	if (extents[axis] > 0.0f)
+	{
+		// Bin centroids and pick the split with the lowest surface area cost
+		const auto binScale = BVH_SAH_BINS / extents[axis];
+		const auto binMin = centroidBounds.Min[axis];
+		const auto getBin = [&](unsigned int item)
+		{
+			const auto bin = static_cast<int>((m_Centroids[item][axis] - binMin) * binScale);
+			return (std::min)(bin, BVH_SAH_BINS - 1);
+		};
+
+		BoundingBox binBounds[BVH_SAH_BINS];
+		unsigned int binCounts[BVH_SAH_BINS] = {};
+		for (auto it = begin; it != end; ++it)
+		{
+			const auto bin = getBin(*it);
+			binBounds[bin].Add(m_Items[*it].Bounds);
+			binCounts[bin]++;
+		}
+
+		// Sweep from the right so every split knows the cost of its right side
+		float rightCosts[BVH_SAH_BINS] = {};
+		BoundingBox rightBounds;
+		unsigned int rightCount = 0;
+		for (auto i = BVH_SAH_BINS - 1; i > 0; i--)
+		{
+			rightBounds.Add(binBounds[i]);
+			rightCount += binCounts[i];
+			rightCosts[i] = rightBounds.GetSurfaceArea() * rightCount;
+		}
+
+		auto bestCost = FLT_MAX;
+		auto bestSplit = 0;
+		BoundingBox leftBounds;
+		unsigned int leftBinCount = 0;
+		for (auto i = 1; i < BVH_SAH_BINS; i++)
+		{
+			leftBounds.Add(binBounds[i - 1]);
+			leftBinCount += binCounts[i - 1];
+
+			const auto cost = leftBounds.GetSurfaceArea() * leftBinCount + rightCosts[i];
+			if (leftBinCount > 0 && leftBinCount < count && cost < bestCost)
+			{
+				bestCost = cost;
+				bestSplit = i;
+			}
+		}
+
+		if (bestSplit > 0)
+		{
+			const auto middle = std::partition(begin, end, [&](unsigned int item) { return getBin(item) < bestSplit; });
+			leftCount = static_cast<unsigned int>(middle - begin);
+		}
+		else
+		{
+			// Every centroid fell into one bin, fall back to the median
+			std::nth_element(begin, begin + leftCount, end,
+				[&](unsigned int a, unsigned int b) { return m_Centroids[a][axis] < m_Centroids[b][axis]; });
+		}
+	}
+
+	// The left child always directly follows its parent
+	build(index, first, leftCount);
+	const auto right = build(index, first + leftCount, count - leftCount);
+	m_Nodes[index].Right = right;
+
+	return index;
+}
+
+void BoundingVolumeHierarchy::refit(unsigned int leaf)
+{
+	auto index = leaf;
+	for (;;)
+	{
+		auto &node = m_Nodes[index];
+
+		BoundingBox bounds;
+		if (node.Right == 0)
+		{
+			for (unsigned int i = node.First; i < node.First + node.Count; i++)
+				bounds.Add(m_Items[m_ItemOrder[i]].Bounds);
+		}
+		else
+		{
+			bounds = m_Nodes[index + 1].Bounds;
+			bounds.Add(m_Nodes[node.Right].Bounds);
+		}
+
+		// Boxes above did not change either
+		if (bounds == node.Bounds)
+			return;
+
+		const auto weight = node.Right == 0 ? static_cast<float>(node.Count) : 1.0f;
+		m_Cost += (bounds.GetSurfaceArea() - node.Bounds.GetSurfaceArea()) * weight;
+		node.Bounds = bounds;
+
+		if (index == 0)
+			return;
+
+		index = node.Parent;
+	}
+}
+
+float BoundingVolumeHierarchy::getCost() const
+{
+	// Expected boxes tested by a random query, relative to the root
+	if (m_Nodes.empty())
+		return 0.0f;
+
+	const auto rootArea = m_Nodes[0].Bounds.GetSurfaceArea();
+	return rootArea > 0.0f ? m_Cost / rootArea : 0.0f;
+}
+
+void BoundingVolumeHierarchy::Reset(unsigned int count)
+{
+	Item item;
+	item.Unbounded = false;
+	item.Leaf = 0;
+
+	m_Items.assign(count, item);
+	m_Dirty = true;
+}
+
+void BoundingVolumeHierarchy::SetBounds(unsigned int index, const BoundingBox &bounds)
+{
+	auto &item = m_Items[index];
+	if (item.Unbounded)
+	{
+		// Joins the tree
+		item.Unbounded = false;
+		m_Dirty = true;
+	}
+	else if (bounds == item.Bounds)
+		return;
+
+	item.Bounds = bounds;
+	if (!m_Dirty)
+		refit(item.Leaf);
+}
+
+void BoundingVolumeHierarchy::SetUnbounded(unsigned int index)
+{
+	auto &item = m_Items[index];
+	if (item.Unbounded)
+		return;
+
+	item.Unbounded = true;
+	item.Bounds = BoundingBox();
+	m_Dirty = true;
+}
+
+void BoundingVolumeHierarchy::Update()
+{
+	if (m_Dirty || getCost() > m_BuildCost * BVH_REBUILD_RATIO)
+		Rebuild();
+}
+
+void BoundingVolumeHierarchy::Rebuild()
+{
+	const auto count = static_cast<unsigned int>(m_Items.size());
+
+	m_ItemOrder.clear();
+	m_Unbounded.clear();
+	m_Centroids.resize(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if (m_Items[i].Unbounded)
+		{
+			m_Unbounded.push_back(i);
+			continue;
+		}
+
+		m_ItemOrder.push_back(i);
+		m_Centroids[i] = m_Items[i].Bounds.GetCenter();
+	}
+
+	m_Nodes.clear();
+	m_Nodes.reserve(2 * m_ItemOrder.size() / BVH_LEAF_SIZE + 1);
+	m_Cost = 0.0f;
+
+	if (!m_ItemOrder.empty())
+		build(0, 0, static_cast<unsigned int>(m_ItemOrder.size()));
+
+	m_BuildCost = getCost();
+	m_Dirty = false;
+}
+
+const std::vector<BoundingVolumeQueryResult> &BoundingVolumeHierarchy::Query(const BoundingFrustum &frustum)
+{
+	m_Results.clear();
+
+	if (!m_Nodes.empty())
+	{
+		m_Stack.clear();
+		m_Stack.push_back(0);
+
+		while (!m_Stack.empty())
+		{
+			const auto &node = m_Nodes[m_Stack.back()];
+			const auto index = m_Stack.back();
+			m_Stack.pop_back();
+
+			const auto containment = frustum.Contains(node.Bounds);
+			if (containment == kContainmentType_Disjoint)
+				continue;
+
+			if (containment == kContainmentType_Contains || node.Right == 0)
+			{
+				// Whole range without testing further, leaves test their items
+				const auto inside = containment == kContainmentType_Contains;
+				for (unsigned int i = node.First; i < node.First + node.Count; i++)
+				{
+					const auto item = m_ItemOrder[i];
+					const auto itemContainment = inside ? kContainmentType_Contains : frustum.Contains(m_Items[item].Bounds);
+					if (itemContainment != kContainmentType_Disjoint && !m_Items[item].Bounds.IsEmpty())
+						m_Results.push_back({ item, itemContainment == kContainmentType_Contains });
+				}
+				continue;
+			}
+
+			m_Stack.push_back(node.Right);
+			m_Stack.push_back(index + 1);
+		}
+	}
+
+	for (auto item : m_Unbounded)
+		m_Results.push_back({ item, false });
+
+	return m_Results;
+}
+
+bool BoundingVolumeHierarchy::Raycast(const Ray &ray, unsigned int &index, float &distance)
+{
+	auto closest = FLT_MAX;
+	auto hit = false;
+
+	if (m_Nodes.empty())
+		return false;
+
+	m_Stack.clear();
+	m_Stack.push_back(0);
+
+	while (!m_Stack.empty())
+	{
+		const auto &node = m_Nodes[m_Stack.back()];
+		const auto nodeIndex = m_Stack.back();
+		m_Stack.pop_back();
+
+		// Skip boxes starting beyond the closest hit so far
+		float near, far;
+		if (!node.Bounds.Intersects(ray, near, far) || near > closest)
+			continue;
+
+		if (node.Right == 0)
+		{
+			for (unsigned int i = node.First; i < node.First + node.Count; i++)
+			{
+				const auto item = m_ItemOrder[i];
+				if (m_Items[item].Bounds.Intersects(ray, near, far) && near >= 0.0f && near < closest)
+				{
+					closest = near;
+					index = item;
+					hit = true;
+				}
+			}
+			continue;
+		}
+
+		// Visit the nearer child first so the other one is more likely to be skipped
+		float leftNear, rightNear;
+		const auto left = nodeIndex + 1;
+		const auto right = node.Right;
+		const auto leftHit = m_Nodes[left].Bounds.Intersects(ray, leftNear, far);
+		const auto rightHit = m_Nodes[right].Bounds.Intersects(ray, rightNear, far);
+
+		if (leftHit && rightHit)
+		{
+			m_Stack.push_back(leftNear < rightNear ? right : left);
+			m_Stack.push_back(leftNear < rightNear ? left : right);
+		}
+		else if (leftHit)
+			m_Stack.push_back(left);
+		else if (rightHit)
+			m_Stack.push_back(right);
+	}
+
+	if (hit)
+		distance = closest;
+
+	return hit;
+}
+
+unsigned int BoundingVolumeHierarchy::GetItemCount() const
+{
+	return static_cast<unsigned int>(m_Items.size());
+}
+
+unsigned int BoundingVolumeHierarchy::GetNodeCount() const
+{
+	return static_cast<unsigned int>(m_Nodes.size());
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Bounds.h"
+#include <vector>
+
+#ifndef BVH_LEAF_SIZE
+#define BVH_LEAF_SIZE 4 // Items per leaf before splitting
+#endif
+
+#ifndef BVH_SAH_BINS
+#define BVH_SAH_BINS 12 // Centroid bins evaluated per split
+#endif
+
+#ifndef BVH_REBUILD_RATIO
+#define BVH_REBUILD_RATIO 2.0f // Rebuild once refitting made the tree this much more expensive to traverse
+#endif
+
+struct BoundingVolumeQueryResult
+{
+	unsigned int Index;
+	bool Inside; // Fully inside the frustum
+};
+
+// Binary tree of boxes over a list of items identified by their index. Built with the
+// surface area heuristic, moving items only refit the boxes above them until the tree
+// got too loose and is rebuilt. Items with empty bounds are never returned, unbounded
+// items are not part of the tree and always pass frustum queries.
+// Not thread safe
+class BoundingVolumeHierarchy
+{
+	// Stored depth first, the left child directly follows its parent and every
+	// subtree covers a contiguous range of m_ItemOrder
+	struct TreeNode
+	{
+		BoundingBox Bounds;
+		unsigned int Parent;
+		unsigned int Right; // Zero for leaves
+		unsigned int First;
+		unsigned int Count;
+	};
+
+	struct Item
+	{
+		BoundingBox Bounds;
+		bool Unbounded;
+		unsigned int Leaf;
+	};
+
+	std::vector<TreeNode> m_Nodes;
+	std::vector<Item> m_Items;
+	std::vector<unsigned int> m_ItemOrder; // Item indices sorted by leaf
+	std::vector<unsigned int> m_Unbounded;
+
+	float m_Cost; // Surface area of internal nodes plus leaves weighted by their item count
+	float m_BuildCost; // Cost relative to the root surface area after the last build
+	bool m_Dirty;
+
+	// Scratch space
+	std::vector<glm::vec3> m_Centroids;
+	std::vector<unsigned int> m_Stack;
+	std::vector<BoundingVolumeQueryResult> m_Results;
+
+	unsigned int build(unsigned int parent, unsigned int first, unsigned int count);
+	void refit(unsigned int leaf);
+	float getCost() const;
+
+public:
+	BoundingVolumeHierarchy();
+
+	// No copying/moving
+	BoundingVolumeHierarchy(const BoundingVolumeHierarchy &) = delete;
+	BoundingVolumeHierarchy &operator=(const BoundingVolumeHierarchy &) = delete;
+
+	BoundingVolumeHierarchy(const BoundingVolumeHierarchy &&) = delete;
+	BoundingVolumeHierarchy &operator=(const BoundingVolumeHierarchy &&) = delete;
+
+	// Replaces every item, the tree is rebuilt on the next update
+	void Reset(unsigned int count);
+
+	void SetBounds(unsigned int index, const BoundingBox &bounds);
+	void SetUnbounded(unsigned int index);
+
+	// Rebuilds after a reset or once the tree degraded
+	void Update();
+	void Rebuild();
+
+	// Items touching the frustum, valid until the next query
+	const std::vector<BoundingVolumeQueryResult> &Query(const BoundingFrustum &frustum);
+
+	// Closest item the ray enters, items containing the origin are ignored.
+	// Returns false if nothing was hit
+	bool Raycast(const Ray &ray, unsigned int &index, float &distance);
+
+	unsigned int GetItemCount() const;
+	unsigned int GetNodeCount() const;
+};
\ No newline at end of file
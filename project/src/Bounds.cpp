@@ -0,0 +1,176 @@
+#include "Bounds.h"
+#include <cfloat>
+
+Ray::Ray()
+	: Origin(0.0f), Direction(0.0f, 0.0f, -1.0f)
+{
+}
+
+Ray::Ray(const glm::vec3 &origin, const glm::vec3 &direction)
+	: Origin(origin), Direction(direction)
+{
+}
+
+glm::vec3 Ray::GetPoint(float distance) const
+{
+	return Origin + Direction * distance;
+}
+
+BoundingBox::BoundingBox()
+	: Min(FLT_MAX), Max(-FLT_MAX)
+{
+}
+
+BoundingBox::BoundingBox(const glm::vec3 &min, const glm::vec3 &max)
+	: Min(min), Max(max)
+{
+}
+
+bool BoundingBox::IsEmpty() const
+{
+	return Min.x > Max.x || Min.y > Max.y || Min.z > Max.z;
+}
+
+glm::vec3 BoundingBox::GetCenter() const
+{
+	return (Min + Max) * 0.5f;
+}
+
+glm::vec3 BoundingBox::GetExtents() const
+{
+	return (Max - Min) * 0.5f;
+}
+
+void BoundingBox::Add(const glm::vec3 &point)
+{
+	Min = glm::min(Min, point);
+	Max = glm::max(Max, point);
+}
+
+void BoundingBox::Add(const BoundingBox &box)
+{
+	if (box.IsEmpty())
+		return;
+
+	Min = glm::min(Min, box.Min);
+	Max = glm::max(Max, box.Max);
+}
+
+BoundingBox BoundingBox::Transform(const glm::mat4 &matrix) const
+{
+	if (IsEmpty())
+		return BoundingBox();
+
+	// Transformed center plus the extents projected on each world axis
+	const auto center = glm::vec3(matrix * glm::vec4(GetCenter(), 1.0f));
+	const auto extents = GetExtents();
+	const auto worldExtents = glm::abs(glm::vec3(matrix[0])) * extents.x + glm::abs(glm::vec3(matrix[1])) * extents.y +
+		glm::abs(glm::vec3(matrix[2])) * extents.z;
+
+	return BoundingBox(center - worldExtents, center + worldExtents);
+}
+
+float BoundingBox::GetSurfaceArea() const
+{
+	if (IsEmpty())
+		return 0.0f;
+
+	const auto size = Max - Min;
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+bool BoundingBox::Intersects(const Ray &ray, float &near, float &far) const
+{
+	if (IsEmpty())
+		return false;
+
+	// Slab test, axis parallel rays divide to infinity and are rejected by the comparisons
+	const auto inverse = 1.0f / ray.Direction;
+	const auto t0 = (Min - ray.Origin) * inverse;
+	const auto t1 = (Max - ray.Origin) * inverse;
+	const auto tMin = glm::min(t0, t1);
+	const auto tMax = glm::max(t0, t1);
+
+	near = glm::max(glm::max(tMin.x, tMin.y), tMin.z);
+	far = glm::min(glm::min(tMax.x, tMax.y), tMax.z);
+	return far >= near && far >= 0.0f;
+}
+
+bool BoundingBox::operator==(const BoundingBox &other) const
+{
+	return Min == other.Min && Max == other.Max;
+}
+
+bool BoundingBox::operator!=(const BoundingBox &other) const
+{
+	return !(*this == other);
+}
+
+BoundingFrustum::BoundingFrustum()
+	: m_Planes(), m_PlaneCount(0)
+{
+}
+
+BoundingFrustum::BoundingFrustum(const glm::mat4 &viewProjection)
+	: m_Planes(), m_PlaneCount(0)
+{
+	// Rows of the matrix, glm is column major
+	glm::vec4 rows[4];
+	for (unsigned int i = 0; i < 4; i++)
+		rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+	const glm::vec4 planes[kPlane_Count] = {
+		rows[3] + rows[0], // Left
+		rows[3] - rows[0], // Right
+		rows[3] + rows[1], // Bottom
+		rows[3] - rows[1], // Top
+		rows[3] + rows[2], // Near
+		rows[3] - rows[2] // Far
+	};
+
+	for (const auto &plane : planes)
+	{
+		// Skip degenerate planes such as the far plane of an infinite projection
+		const auto length = glm::length(glm::vec3(plane));
+		if (length > FLT_EPSILON)
+			m_Planes[m_PlaneCount++] = plane / length;
+	}
+}
+
+ContainmentType BoundingFrustum::Contains(const glm::vec3 &point) const
+{
+	for (unsigned int i = 0; i < m_PlaneCount; i++)
+	{
+		if (glm::dot(glm::vec3(m_Planes[i]), point) + m_Planes[i].w < 0.0f)
+			return kContainmentType_Disjoint;
+	}
+
+	return kContainmentType_Contains;
+}
+
+ContainmentType BoundingFrustum::Contains(const BoundingBox &box) const
+{
+	if (box.IsEmpty())
+		return kContainmentType_Disjoint;
+
+	auto result = kContainmentType_Contains;
+	for (unsigned int i = 0; i < m_PlaneCount; i++)
+	{
+		const auto normal = glm::vec3(m_Planes[i]);
+		const auto distance = m_Planes[i].w;
+
+		// Corner furthest along the normal, if it is behind the plane the whole box is
+		const auto positive = glm::vec3(normal.x >= 0.0f ? box.Max.x : box.Min.x, normal.y >= 0.0f ? box.Max.y : box.Min.y,
+			normal.z >= 0.0f ? box.Max.z : box.Min.z);
+		if (glm::dot(normal, positive) + distance < 0.0f)
+			return kContainmentType_Disjoint;
+
+		// Opposite corner behind the plane means the box straddles it
+		const auto negative = glm::vec3(normal.x >= 0.0f ? box.Min.x : box.Max.x, normal.y >= 0.0f ? box.Min.y : box.Max.y,
+			normal.z >= 0.0f ? box.Min.z : box.Max.z);
+		if (glm::dot(normal, negative) + distance < 0.0f)
+			result = kContainmentType_Intersects;
+	}
+
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+enum ContainmentType
+{
+	kContainmentType_Disjoint,
+	kContainmentType_Intersects,
+	kContainmentType_Contains
+};
+
+struct Ray
+{
+	glm::vec3 Origin;
+	glm::vec3 Direction; // Normalized
+
+	Ray();
+	Ray(const glm::vec3 &origin, const glm::vec3 &direction);
+
+	glm::vec3 GetPoint(float distance) const;
+};
+
+// Axis aligned, empty until a point is added
+struct BoundingBox
+{
+	glm::vec3 Min;
+	glm::vec3 Max;
+
+	BoundingBox();
+	BoundingBox(const glm::vec3 &min, const glm::vec3 &max);
+
+	bool IsEmpty() const;
+	glm::vec3 GetCenter() const;
+	glm::vec3 GetExtents() const; // Half size
+
+	void Add(const glm::vec3 &point);
+	void Add(const BoundingBox &box);
+
+	// Box around this box after transforming it
+	BoundingBox Transform(const glm::mat4 &matrix) const;
+
+	float GetSurfaceArea() const;
+
+	// Distances where the ray enters and leaves the box, near is negative if the origin is inside
+	bool Intersects(const Ray &ray, float &near, float &far) const;
+
+	bool operator==(const BoundingBox &other) const;
+	bool operator!=(const BoundingBox &other) const;
+};
+
+// Six planes facing inwards, extracted from a view projection matrix
+class BoundingFrustum
+{
+	enum Plane
+	{
+		kPlane_Left,
+		kPlane_Right,
+		kPlane_Bottom,
+		kPlane_Top,
+		kPlane_Near,
+		kPlane_Far,
+
+		kPlane_Count
+	};
+
+	glm::vec4 m_Planes[kPlane_Count]; // Normal, distance
+	unsigned int m_PlaneCount; // Infinite projections have no far plane
+
+public:
+	BoundingFrustum();
+	explicit BoundingFrustum(const glm::mat4 &viewProjection);
+
+	ContainmentType Contains(const glm::vec3 &point) const;
+	ContainmentType Contains(const BoundingBox &box) const;
+};
\ No newline at end of file
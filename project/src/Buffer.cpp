@@ -98,6 +98,19 @@ void Buffer::Copy(const Buffer &buffer)
 	m_Size = buffer.m_Size;
 }
 
+void Buffer::SetData(unsigned int offset, size_t size, const void *data)
+{
+	if (m_Mapped)
+		THROW_EXCEPTION(BufferMapException, "Cannot set data of buffer that is currently mapped");
+
+	glBindBuffer(m_Target, m_ID);
+
+	// Orphan the old storage when replacing everything so we don't wait on draws still using it
+	if (offset == 0 && size == m_Size)
+		glBufferData(m_Target, m_Size, data, m_Usage);
+	else glBufferSubData(m_Target, offset, size, data);
+}
+
 const void *Buffer::Map(unsigned int offset, size_t size, Access access)
 {
 	if (m_Mapped)
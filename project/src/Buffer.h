@@ -15,6 +15,7 @@ public:
 
 		kTarget_ArrayBuffer = GL_ARRAY_BUFFER,
 		kTarget_ElementArrayBuffer = GL_ELEMENT_ARRAY_BUFFER,
+		kTarget_PixelUnpackBuffer = GL_PIXEL_UNPACK_BUFFER,
 		kTarget_QueryBuffer = GL_QUERY_BUFFER,
 		kTarget_TextureBuffer = GL_TEXTURE_BUFFER,
 		kTarget_UniformBuffer = GL_UNIFORM_BUFFER,
@@ -32,6 +33,8 @@ public:
 		kUsage_DynamicDraw = GL_DYNAMIC_DRAW,
 		kUsage_DynamicRead = GL_DYNAMIC_READ,
 		kUsage_DynamicCopy = GL_DYNAMIC_COPY,
+
+		kUsage_StreamDraw = GL_STREAM_DRAW,
 	};
 
 	enum Access
@@ -73,6 +76,7 @@ public:
 
 	void Bind(Target target = kTarget_None);
 	void Copy(const Buffer &buffer);
+	void SetData(unsigned int offset, size_t size, const void *data);
 
 	const void *Map(unsigned int offset, size_t size, Access access = kAccess_ReadWrite);
 	void Unmap(unsigned int offset, size_t size);
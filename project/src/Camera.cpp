@@ -6,17 +6,12 @@
 
 Camera::Camera(float fov, float near, float far, float aspectRatio, GraphicsManager *graphicsManager)
 	: m_GraphicsManager(graphicsManager), m_FOV(fov), m_NearPlane(near), m_FarPlane(far), m_AspectRatio(aspectRatio), m_ClearColor(0.0f), 
-	m_ClearDepth(1.0f), m_ClearMode(kCameraClearMode_None), m_ProjectionMatrix(0.0f), m_ViewMatrix(0.0f)
+	m_ClearDepth(1.0f), m_ClearMode(kCameraClearMode_None), m_ProjectionMatrix(0.0f), m_ViewMatrix(0.0f), m_Block(kShaderBlockBinding_Camera), m_RenderStats()
 {
 }
 
 Camera::~Camera() = default;
 
-void Camera::AddShader(Shader *shader)
-{
-	m_Shaders.push_back(shader);
-}
-
 const glm::vec4 &Camera::GetClearColor() const
 {
 	return m_ClearColor;
@@ -102,6 +97,30 @@ const glm::mat4x4 &Camera::GetViewMatrix() const
 	return m_ViewMatrix;
 }
 
+const BoundingFrustum &Camera::GetBoundingFrustum() const
+{
+	return m_Frustum;
+}
+
+Ray Camera::ScreenPointToRay(float x, float y, float width, float height) const
+{
+	const auto ndcX = 2.0f * x / width - 1.0f;
+	const auto ndcY = 1.0f - 2.0f * y / height;
+
+	// Unproject a point on the near plane and one halfway in depth, which stays finite for infinite projections
+	const auto inverse = glm::inverse(m_ProjectionMatrix * m_ViewMatrix);
+	const auto nearPoint = inverse * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+	const auto farPoint = inverse * glm::vec4(ndcX, ndcY, 0.0f, 1.0f);
+
+	const auto origin = glm::vec3(nearPoint) / nearPoint.w;
+	return Ray(origin, glm::normalize(glm::vec3(farPoint) / farPoint.w - origin));
+}
+
+const RenderStats &Camera::GetRenderStats() const
+{
+	return m_RenderStats;
+}
+
 void Camera::Update(float deltaTime)
 {
 	// Set view matrix from transform
@@ -111,6 +130,9 @@ void Camera::Update(float deltaTime)
 	if (m_FarPlane < 0.0f)
 		m_ProjectionMatrix = glm::infinitePerspective(glm::radians(m_FOV), m_AspectRatio, m_NearPlane);
 	else m_ProjectionMatrix = glm::perspective(glm::radians(m_FOV), m_AspectRatio, m_NearPlane, m_FarPlane);
+
+	// World space frustum for culling
+	m_Frustum = BoundingFrustum(m_ProjectionMatrix * m_ViewMatrix);
 }
 
 void Camera::Render(Node *node, float deltaTime, bool clear)
@@ -136,26 +158,43 @@ void Camera::Render(Node *node, float deltaTime, bool clear)
 		}
 	}
 
+	// Objects may have changed state directly since the last frame
+	m_GraphicsManager->Reset();
+
 	// Create render context
+	RenderQueue queue;
 	RenderContext rc{};
 	rc.GraphicsManager = m_GraphicsManager;
 	rc.Camera = this;
+	rc.Queue = &queue;
 	rc.ViewMatrix = m_ViewMatrix;
 	rc.ProjectionMatrix = m_ProjectionMatrix;
 	rc.TransformMatrix = glm::mat4(0.0f);
-
-	// Update shaders
-	for (const auto &s : m_Shaders)
-	{
-		s->Use();
-		const auto viewVar = s->GetVariable("u_View");
-		const auto projVar = s->GetVariable("u_Projection");
-			
-		viewVar->SetMat4(m_ViewMatrix);
-		projVar->SetMat4(m_ProjectionMatrix);
-	}
+	rc.Frustum = m_Frustum;
+	rc.FrustumInside = false;
+	rc.ViewPosition = m_Transform.GetPosition();
+	rc.LodScale = 1.0f / glm::tan(glm::radians(m_FOV) * 0.5f);
+
+	// Update camera block, one upload for every shader
+	CameraBlock block{};
+	block.View = m_ViewMatrix;
+	block.Projection = m_ProjectionMatrix;
+	block.ViewPosition = m_Transform.GetPosition();
+
+	m_Block.SetData(block);
+	m_Block.Bind();
 	
-	// Render nodes
+	// Queue nodes, subtrees outside the frustum are skipped
 	if (node->IsActive())
+	{
+		node->UpdateBounds();
 		node->Render(&rc);
+	}
+
+	// Draw sorted by state
+	queue.Submit(m_GraphicsManager);
+	m_RenderStats = queue.GetStats();
+	m_RenderStats.NodesVisible = rc.NodesVisible;
+	m_RenderStats.NodesCulled = rc.NodesCulled;
+	m_RenderStats.TrianglesWithoutLod = m_RenderStats.Triangles + rc.LodTrianglesSaved;
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include "Transform.h"
 #include "Node.h"
+#include "RenderQueue.h"
+#include "UniformBuffer.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 
@@ -13,6 +15,15 @@ enum CameraClearMode
 	kCameraClearMode_Both = GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT
 };
 
+// Must match the std140 Camera block in the shaders
+struct CameraBlock
+{
+	glm::mat4 View;
+	glm::mat4 Projection;
+	glm::vec3 ViewPosition;
+	float Padding;
+};
+
 class Camera
 {
 	GraphicsManager *m_GraphicsManager;
@@ -29,16 +40,17 @@ class Camera
 	Transform m_Transform;
 	glm::mat4 m_ProjectionMatrix;
 	glm::mat4 m_ViewMatrix;
+	BoundingFrustum m_Frustum;
+
+	// Shared with all shaders through the camera block
+	UniformBuffer<CameraBlock> m_Block;
 
-	// Shaders
-	std::vector<Shader *> m_Shaders;
+	RenderStats m_RenderStats; // Of the last frame
 
 public:
 	Camera(float fov, float near, float far, float aspectRatio, GraphicsManager *graphicsManager);
 	~Camera();
 
-	void AddShader(Shader *shader);
-
 	const glm::vec4 &GetClearColor() const;
 	void SetClearColor(const glm::vec4 &color);
 
@@ -64,6 +76,12 @@ public:
 
 	const glm::mat4 &GetProjectionMatrix() const;
 	const glm::mat4 &GetViewMatrix() const;
+	const BoundingFrustum &GetBoundingFrustum() const;
+
+	// Ray from the near plane through a window position, y points down
+	Ray ScreenPointToRay(float x, float y, float width, float height) const;
+
+	const RenderStats &GetRenderStats() const;
 
 	void Update(float deltaTime);
 	void Render(Node *node, float deltaTime, bool clear = true);
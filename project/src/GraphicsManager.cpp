@@ -1,11 +1,35 @@
 #include "GraphicsManager.h"
+#include "Log.h"
+#include "Memory.h"
 #include "ShaderUtil.h"
 #include "TextureUtil.h"
+#include <chrono>
 #include <utility>
 
+struct TextureLoad
+{
+	TextureImage *Image; // Handed to the streamer
+	std::string Error; // Set if decoding failed
+};
+
+struct TextureArrayLoad
+{
+	std::vector<TextureImage *> Images; // Handed to the streamer, null if no layer loaded
+};
+
 GraphicsManager::GraphicsManager(std::string dataPath)
-	: m_DataPath(std::move(dataPath))
+	: m_DataPath(std::move(dataPath)), m_ActiveShader(nullptr), m_ActiveVertexArray(nullptr), m_ActiveVertexBuffer(nullptr), 
+	m_ActiveIndexBuffer(nullptr), m_ActiveInstanceBuffer(nullptr), m_TextureUnits(), m_TextureUseCount(0), 
+	m_TextureBindCount(0), m_TextureRequestCount(0)
 {
+	// Arrays are only created once used
+	for (auto &pair : FindTextureArrays(m_DataPath + "/textures"))
+	{
+		for (unsigned int i = 0; i < pair.second.size(); i++)
+			m_TextureLayers.emplace(pair.second[i], TextureLayer{ pair.first, i });
+
+		m_TextureArrays.emplace(pair.first, TextureArray{ std::move(pair.second), nullptr });
+	}
 }
 
 GraphicsManager::~GraphicsManager()
@@ -18,9 +42,92 @@ GraphicsManager::~GraphicsManager()
 
 	// Destroy textures
 	for (auto &pair : m_Textures)
-		DestroyTexture(pair.second);
+		destroyTexture(pair.second);
 
 	m_Textures.clear();
+
+	for (auto &pair : m_TextureArrays)
+	{
+		if (pair.second.Array)
+			destroyTexture(pair.second.Array);
+	}
+
+	m_TextureArrays.clear();
+	m_TextureLayers.clear();
+}
+
+void GraphicsManager::destroyTexture(Texture *texture)
+{
+	// Uploads still pending must not reach the deleted texture
+	m_TextureStreamer.Remove(texture);
+	DestroyTexture(texture);
+}
+
+void GraphicsManager::loadTexture(Texture *texture, const std::string &name, AssetLoader *loader)
+{
+	const auto path = m_DataPath + "/textures";
+
+	// Decode on a worker, upload once done. A texture that fails keeps the placeholder
+	const auto load = New<TextureLoad>();
+	load->Image = New<TextureImage>();
+	loader->Load([path, name, load, loader]()
+	{
+		try
+		{
+			DecodeTextureFromFile(path, name, *load->Image, loader->GetJobSystem());
+		}
+		catch (std::exception &ex)
+		{
+			load->Error = ex.what();
+		}
+	}, [this, name, load, texture]()
+	{
+		if (load->Error.empty())
+			m_TextureStreamer.Add(texture, load->Image, name);
+		else
+		{
+			LOG_ERROR("Graphics", "Unable to load texture %s: %s", name.c_str(), load->Error.c_str());
+			Delete(load->Image);
+		}
+
+		Delete(load);
+	});
+}
+
+void GraphicsManager::loadTextureArray(Texture *texture, const std::vector<std::string> &names, AssetLoader *loader)
+{
+	const auto path = m_DataPath + "/textures";
+	if (!loader)
+	{
+		std::vector<TextureImage *> images;
+		DecodeTextureArrayFromFiles(path, names, images);
+		for (unsigned int i = 0; i < images.size(); i++)
+		{
+			if (!images[i])
+				continue;
+
+			UploadTextureImage(texture, *images[i], i);
+			Delete(images[i]);
+		}
+		return;
+	}
+
+	// Layers are decoded together so they all get one format, the array keeps the placeholder until
+	// every layer is uploaded
+	const auto load = New<TextureArrayLoad>();
+	loader->Load([path, names, load, loader]()
+	{
+		DecodeTextureArrayFromFiles(path, names, load->Images, loader->GetJobSystem());
+	}, [this, names, load, texture]()
+	{
+		for (unsigned int i = 0; i < load->Images.size(); i++)
+		{
+			if (load->Images[i])
+				m_TextureStreamer.Add(texture, load->Images[i], names[i], i);
+		}
+
+		Delete(load);
+	});
 }
 
 Shader *GraphicsManager::GetShader(const std::string &name)
@@ -30,9 +137,14 @@ Shader *GraphicsManager::GetShader(const std::string &name)
 	if ((it = m_Shaders.find(name)) != m_Shaders.end())
 		return it->second;
 
-	// Compile shader
-	const auto shader = LoadShaderFromFile(m_DataPath + "/shaders", name);
-	shader->Compile();
+	// Compile shader, or load the program binary cached by an earlier launch
+	const auto startTime = std::chrono::steady_clock::now();
+	const auto path = m_DataPath + "/shaders";
+	const auto shader = LoadShaderFromFile(path, name);
+	const auto cached = shader->Compile(path + "/" + name + "/" + name + SHADER_CACHE_EXTENSION);
+
+	LOG_INFO("Graphics", "%s shader %s in %.2f ms", cached ? "Loaded cached" : "Compiled", name.c_str(),
+		std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count());
 
 	// Store shader
 	m_Shaders.emplace(name, shader);
@@ -40,15 +152,41 @@ Shader *GraphicsManager::GetShader(const std::string &name)
 	return shader;
 }
 
-Texture *GraphicsManager::GetTexture(const std::string &name)
+Texture *GraphicsManager::GetTexture(const std::string &name, AssetLoader *loader, unsigned int *layer)
 {
+	if (layer)
+		*layer = 0;
+
+	// Layers load along with the rest of their array
+	const auto member = m_TextureLayers.find(name);
+	if (member != m_TextureLayers.end())
+	{
+		if (layer)
+			*layer = member->second.Layer;
+
+		auto &array = m_TextureArrays.at(member->second.Array);
+		if (!array.Array)
+		{
+			array.Array = CreatePlaceholderTexture(static_cast<unsigned int>(array.Layers.size()));
+			loadTextureArray(array.Array, array.Layers, loader);
+		}
+
+		return array.Array;
+	}
+
 	// Check if it is already loaded
 	std::map<std::string, Texture *>::iterator it;
 	if ((it = m_Textures.find(name)) != m_Textures.end())
 		return it->second;
 
 	// Load texture
-	const auto texture = LoadTextureFromFile(m_DataPath + "/textures", name);
+	Texture *texture;
+	if (loader)
+	{
+		texture = CreatePlaceholderTexture();
+		loadTexture(texture, name, loader);
+	}
+	else texture = LoadTextureFromFile(m_DataPath + "/textures", name);
 
 	// Store texture
 	m_Textures.emplace(name, texture);
@@ -56,7 +194,47 @@ Texture *GraphicsManager::GetTexture(const std::string &name)
 	return texture;
 }
 
-// TODO: Integrate
+TextureStreamer *GraphicsManager::GetTextureStreamer()
+{
+	return &m_TextureStreamer;
+}
+
+size_t GraphicsManager::GetTextureMemorySize() const
+{
+	size_t size = 0;
+	for (const auto &pair : m_Textures)
+		size += pair.second->GetMemorySize();
+
+	for (const auto &pair : m_TextureArrays)
+	{
+		if (pair.second.Array)
+			size += pair.second.Array->GetMemorySize();
+	}
+
+	return size;
+}
+
+void GraphicsManager::Update()
+{
+	m_TextureStreamer.Update();
+
+	// Replaced images were deleted and unbound, their names may be reused
+	for (auto &unit : m_TextureUnits)
+	{
+		if (unit.Target && unit.Target->GetID() != unit.ID)
+			unit = {};
+	}
+}
+
+void GraphicsManager::Reset()
+{
+	m_ActiveShader = nullptr;
+	m_ActiveVertexArray = nullptr;
+	m_ActiveVertexBuffer = nullptr;
+	m_ActiveIndexBuffer = nullptr;
+	m_ActiveInstanceBuffer = nullptr;
+}
+
 void GraphicsManager::UseShader(Shader *shader)
 {
 	if (shader == m_ActiveShader)
@@ -73,6 +251,11 @@ void GraphicsManager::Bind(VertexArray *va)
 
 	m_ActiveVertexArray = va;
 	va->Bind();
+
+	// Buffer bindings are part of the vertex array state
+	m_ActiveVertexBuffer = nullptr;
+	m_ActiveIndexBuffer = nullptr;
+	m_ActiveInstanceBuffer = nullptr;
 }
 
 void GraphicsManager::Bind(VertexBuffer<void> *vb)
@@ -92,3 +275,54 @@ void GraphicsManager::Bind(IndexBuffer *ib)
 	m_ActiveIndexBuffer = ib;
 	ib->Bind();
 }
+
+void GraphicsManager::Bind(InstanceBuffer<void> *ib)
+{
+	if (ib == m_ActiveInstanceBuffer)
+		return;
+
+	m_ActiveInstanceBuffer = ib;
+	ib->Bind();
+}
+
+unsigned int GraphicsManager::Bind(Texture *texture)
+{
+	m_TextureRequestCount++;
+	m_TextureUseCount++;
+
+	// Textures of the material being applied were just used and are never replaced
+	unsigned int index = 0;
+	for (unsigned int i = 0; i < GRAPHICS_TEXTURE_UNITS; i++)
+	{
+		if (m_TextureUnits[i].Target == texture)
+		{
+			index = i;
+			break;
+		}
+
+		if (m_TextureUnits[i].LastUse < m_TextureUnits[index].LastUse)
+			index = i;
+	}
+
+	auto &unit = m_TextureUnits[index];
+	unit.LastUse = m_TextureUseCount;
+	if (unit.Target == texture && unit.ID == texture->GetID())
+		return index;
+
+	unit.Target = texture;
+	unit.ID = texture->GetID();
+	texture->Activate(static_cast<uint8_t>(index));
+	m_TextureBindCount++;
+
+	return index;
+}
+
+unsigned int GraphicsManager::GetTextureBindCount() const
+{
+	return m_TextureBindCount;
+}
+
+unsigned int GraphicsManager::GetTextureRequestCount() const
+{
+	return m_TextureRequestCount;
+}
\ No newline at end of file
@@ -1,20 +1,59 @@
 #pragma once
 
+#include "AssetLoader.h"
 #include "Shader.h"
 #include "Texture.h"
+#include "TextureStreamer.h"
 #include "Vertex.h"
+#include <cstdint>
 #include <map>
+#include <vector>
+
+#ifndef GRAPHICS_TEXTURE_UNITS
+#define GRAPHICS_TEXTURE_UNITS TEXTURE_EDIT_UNIT // Units handed to material textures, the edit and shared units follow
+#endif
 
 class GraphicsManager
 {
+	struct TextureArray
+	{
+		std::vector<std::string> Layers; // Texture names
+		Texture *Array; // Created once any layer is requested
+	};
+
+	struct TextureLayer
+	{
+		std::string Array;
+		unsigned int Layer;
+	};
+
+	struct TextureUnit
+	{
+		Texture *Target; // Null if free
+		GLuint ID; // Of the target when it was bound, streaming replaces it
+		uint64_t LastUse;
+	};
+
 	std::string m_DataPath;
 	std::map<std::string, Shader *> m_Shaders;
 	std::map<std::string, Texture *> m_Textures;
+	std::map<std::string, TextureArray> m_TextureArrays;
+	std::map<std::string, TextureLayer> m_TextureLayers; // Textures packed into an array
+	TextureStreamer m_TextureStreamer;
 
 	Shader *m_ActiveShader;
 	VertexArray *m_ActiveVertexArray;
 	VertexBuffer<void> *m_ActiveVertexBuffer;
 	IndexBuffer *m_ActiveIndexBuffer;
+	InstanceBuffer<void> *m_ActiveInstanceBuffer;
+	TextureUnit m_TextureUnits[GRAPHICS_TEXTURE_UNITS];
+	uint64_t m_TextureUseCount; // Orders the units by last use
+	unsigned int m_TextureBindCount;
+	unsigned int m_TextureRequestCount;
+
+	void destroyTexture(Texture *texture);
+	void loadTexture(Texture *texture, const std::string &name, AssetLoader *loader);
+	void loadTextureArray(Texture *texture, const std::vector<std::string> &names, AssetLoader *loader);
 
 public:
 	GraphicsManager(std::string dataPath);
@@ -28,17 +67,45 @@ public:
 	GraphicsManager &operator=(const GraphicsManager &&) = delete;
 	
 	Shader *GetShader(const std::string &name);
-	Texture *GetTexture(const std::string &name);
+
+	// With a loader the texture is a placeholder until the image was decoded on a worker
+	// and streamed in by Update. Textures packed into an array return the array, their
+	// layer is written to layer
+	Texture *GetTexture(const std::string &name, AssetLoader *loader = nullptr, unsigned int *layer = nullptr);
+	TextureStreamer *GetTextureStreamer();
+	size_t GetTextureMemorySize() const; // Estimated video memory of every texture
+
+	// Streams texture uploads within the budget, call once per frame
+	void Update();
+
+	// Forget cached bindings, call when state was changed outside of the manager. Texture
+	// units are kept, textures are only changed on the edit unit outside of the manager
+	void Reset();
 
 	void UseShader(Shader *shader);
 
 	void Bind(VertexArray *va);
 	void Bind(VertexBuffer<void> *vb);
 	void Bind(IndexBuffer *ib);
+	void Bind(InstanceBuffer<void> *ib);
+
+	// Returns the unit holding the texture. Textures stay on their unit until it is needed
+	// for another one, the unit used the longest time ago is replaced
+	unsigned int Bind(Texture *texture);
+
+	// Since startup, requests include textures already on a unit
+	unsigned int GetTextureBindCount() const;
+	unsigned int GetTextureRequestCount() const;
 
 	template<typename TVertex>
 	void Bind(VertexBuffer<TVertex> *vb)
 	{
 		Bind(reinterpret_cast<VertexBuffer<void> *>(vb));
 	}
+
+	template<typename TInstance>
+	void Bind(InstanceBuffer<TInstance> *ib)
+	{
+		Bind(reinterpret_cast<InstanceBuffer<void> *>(ib));
+	}
 }; 
\ No newline at end of file
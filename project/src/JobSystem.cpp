@@ -0,0 +1,176 @@
+#include "JobSystem.h"
+
+// Queue of the current thread, only valid for the job system that started it
+static thread_local const JobSystem *t_JobSystem = nullptr;
+static thread_local unsigned int t_JobQueueIndex = 0;
+
+JobCounter::JobCounter()
+	: m_Count(0)
+{
+}
+
+unsigned int JobCounter::GetCount() const
+{
+	return m_Count.load(std::memory_order_acquire);
+}
+
+bool JobCounter::IsDone() const
+{
+	return GetCount() == 0;
+}
+
+void JobCounter::Increment()
+{
+	m_Count.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void JobCounter::Decrement()
+{
+	m_Count.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+JobSystem::JobSystem(unsigned int workerCount)
+	: m_PendingJobs(0), m_Shutdown(false)
+{
+	// Queue 0 belongs to threads outside the pool
+	for (unsigned int i = 0; i < workerCount + 1; i++)
+		m_Queues.emplace_back(new Queue());
+
+	for (unsigned int i = 0; i < workerCount; i++)
+		m_Threads.emplace_back(&JobSystem::workerMain, this, i + 1);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_WakeMutex);
+		m_Shutdown = true;
+	}
+	m_WakeCondition.notify_all();
+
+	for (auto &t : m_Threads)
+		t.join();
+}
+
+unsigned int JobSystem::getQueueIndex() const
+{
+	return t_JobSystem == this ? t_JobQueueIndex : 0;
+}
+
+void JobSystem::push(unsigned int queueIndex, Job job, bool deferred)
+{
+	{
+		// Deferred jobs go to the far end so the owner picks other work first
+		auto &queue = *m_Queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		if (deferred)
+			queue.Jobs.push_front(std::move(job));
+		else queue.Jobs.push_back(std::move(job));
+	}
+
+	m_PendingJobs.fetch_add(1, std::memory_order_release);
+
+	// Lock so a worker between its check and its wait does not miss the notification
+	{
+		std::lock_guard<std::mutex> lock(m_WakeMutex);
+	}
+	m_WakeCondition.notify_one();
+}
+
+bool JobSystem::pop(unsigned int queueIndex, Job &job)
+{
+	// Owners take the newest job, it is most likely still in cache
+	auto &queue = *m_Queues[queueIndex];
+	std::lock_guard<std::mutex> lock(queue.Mutex);
+	if (queue.Jobs.empty())
+		return false;
+
+	job = std::move(queue.Jobs.back());
+	queue.Jobs.pop_back();
+	return true;
+}
+
+bool JobSystem::steal(unsigned int queueIndex, Job &job)
+{
+	// Thieves take the oldest job, usually the largest remaining piece of work
+	const auto count = static_cast<unsigned int>(m_Queues.size());
+	for (unsigned int i = 1; i < count; i++)
+	{
+		auto &queue = *m_Queues[(queueIndex + i) % count];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		if (queue.Jobs.empty())
+			continue;
+
+		job = std::move(queue.Jobs.front());
+		queue.Jobs.pop_front();
+		return true;
+	}
+
+	return false;
+}
+
+bool JobSystem::tryRun(unsigned int queueIndex)
+{
+	Job job;
+	if (!pop(queueIndex, job) && !steal(queueIndex, job))
+		return false;
+
+	m_PendingJobs.fetch_sub(1, std::memory_order_acq_rel);
+
+	// Defer until the dependency is done
+	if (job.Dependency && !job.Dependency->IsDone())
+	{
+		push(queueIndex, std::move(job), true);
+		return false;
+	}
+
+	job.Function();
+
+	if (job.Counter)
+		job.Counter->m_Count.fetch_sub(1, std::memory_order_acq_rel);
+
+	return true;
+}
+
+void JobSystem::workerMain(unsigned int queueIndex)
+{
+	t_JobSystem = this;
+	t_JobQueueIndex = queueIndex;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_WakeMutex);
+			m_WakeCondition.wait(lock, [this] { return m_Shutdown || m_PendingJobs.load(std::memory_order_acquire) > 0; });
+			if (m_Shutdown)
+				return;
+		}
+
+		if (!tryRun(queueIndex))
+			std::this_thread::yield();
+	}
+}
+
+unsigned int JobSystem::GetWorkerCount() const
+{
+	return static_cast<unsigned int>(m_Threads.size());
+}
+
+void JobSystem::Run(JobFunction function, JobCounter *counter, JobCounter *dependency)
+{
+	if (counter)
+		counter->m_Count.fetch_add(1, std::memory_order_acq_rel);
+
+	push(getQueueIndex(), { std::move(function), counter, dependency });
+}
+
+void JobSystem::Wait(JobCounter *counter)
+{
+	// Help out instead of blocking, this also makes waiting inside a job safe
+	const auto queueIndex = getQueueIndex();
+	while (!counter->IsDone())
+	{
+		if (!tryRun(queueIndex))
+			std::this_thread::yield();
+	}
+}
\ No newline at end of file
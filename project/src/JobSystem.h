@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Counts unfinished jobs, a job can wait on one before it starts
+class JobCounter
+{
+	friend class JobSystem;
+
+	std::atomic<unsigned int> m_Count;
+
+public:
+	JobCounter();
+
+	// No copying/moving
+	JobCounter(const JobCounter &) = delete;
+	JobCounter &operator=(const JobCounter &) = delete;
+
+	JobCounter(const JobCounter &&) = delete;
+	JobCounter &operator=(const JobCounter &&) = delete;
+
+	unsigned int GetCount() const;
+	bool IsDone() const;
+
+	// For work tracked outside of the jobs run with this counter
+	void Increment();
+	void Decrement();
+};
+
+typedef std::function<void()> JobFunction;
+
+// Fixed worker pool, every thread owns a deque and steals from the others when empty.
+// Threads that are not workers share queue 0 and only run jobs while waiting
+class JobSystem
+{
+	struct Job
+	{
+		JobFunction Function;
+		JobCounter *Counter; // Optional, decremented when the job finishes
+		JobCounter *Dependency; // Optional, the job is deferred until it is done
+	};
+
+	struct Queue
+	{
+		std::mutex Mutex;
+		std::deque<Job> Jobs;
+	};
+
+	std::vector<std::unique_ptr<Queue>> m_Queues;
+	std::vector<std::thread> m_Threads;
+
+	std::mutex m_WakeMutex;
+	std::condition_variable m_WakeCondition;
+	std::atomic<unsigned int> m_PendingJobs;
+	bool m_Shutdown;
+
+	unsigned int getQueueIndex() const;
+	void push(unsigned int queueIndex, Job job, bool deferred = false);
+	bool pop(unsigned int queueIndex, Job &job);
+	bool steal(unsigned int queueIndex, Job &job);
+	bool tryRun(unsigned int queueIndex);
+	void workerMain(unsigned int queueIndex);
+
+public:
+	// Defaults to one worker less than the hardware threads, zero runs every job on the waiting thread
+	explicit JobSystem(unsigned int workerCount = (std::max)(std::thread::hardware_concurrency(), 1u) - 1);
+	~JobSystem();
+
+	// No copying/moving
+	JobSystem(const JobSystem &) = delete;
+	JobSystem &operator=(const JobSystem &) = delete;
+
+	JobSystem(const JobSystem &&) = delete;
+	JobSystem &operator=(const JobSystem &&) = delete;
+
+	unsigned int GetWorkerCount() const;
+
+	void Run(JobFunction function, JobCounter *counter = nullptr, JobCounter *dependency = nullptr);
+
+	// Runs queued jobs on the calling thread until the counter is done
+	void Wait(JobCounter *counter);
+
+	// Splits [0, count) into ranges of at most grainSize and waits for all of them,
+	// function is called as function(begin, end)
+	template<typename TFunction>
+	void ParallelFor(unsigned int count, unsigned int grainSize, const TFunction &function)
+	{
+		if (grainSize == 0)
+			grainSize = 1;
+
+		// Not worth a job
+		if (m_Threads.empty() || count <= grainSize)
+		{
+			function(0u, count);
+			return;
+		}
+
+		JobCounter counter;
+		for (unsigned int begin = 0; begin < count; begin += grainSize)
+		{
+			const auto end = (std::min)(begin + grainSize, count);
+			Run([&function, begin, end]() { function(begin, end); }, &counter);
+		}
+
+		Wait(&counter);
+	}
+};
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include "LightClusters.h"
+#include <algorithm>
+#include <cmath>
+
+LightClusters::LightClusters(JobSystem *jobSystem)
+	: m_Projection(0.0f), m_Near(0.0f), m_Far(0.0f), m_SliceScale(0.0f), m_SliceBias(0.0f), m_JobSystem(jobSystem)
+{
+	m_Bounds.resize(LIGHT_CLUSTER_COUNT);
+	m_ClusterCounts.resize(LIGHT_CLUSTER_COUNT);
+	m_ClusterLights.resize(LIGHT_CLUSTER_COUNT * LIGHT_CLUSTER_LIGHTS_MAX);
+	m_Grid.resize(LIGHT_CLUSTER_COUNT);
+}
+
+LightClusters::~LightClusters()
+{
+}
+
+void LightClusters::buildBounds(const glm::mat4 &projection, float near, float far)
+{
+	m_Projection = projection;
+	m_Near = near;
+	m_Far = far;
+
+	const auto logRatio = std::log(far / near);
+	m_SliceScale = LIGHT_CLUSTER_Z / logRatio;
+	m_SliceBias = -LIGHT_CLUSTER_Z * std::log(near) / logRatio;
+
+	// View space x = ndc.x * depth / P[0][0], same for y
+	const auto scaleX = 1.0f / projection[0][0];
+	const auto scaleY = 1.0f / projection[1][1];
+
+	for (unsigned int z = 0; z < LIGHT_CLUSTER_Z; z++)
+	{
+		const auto nearDepth = near * std::pow(far / near, static_cast<float>(z) / LIGHT_CLUSTER_Z);
+		const auto farDepth = near * std::pow(far / near, static_cast<float>(z + 1) / LIGHT_CLUSTER_Z);
+
+		for (unsigned int y = 0; y < LIGHT_CLUSTER_Y; y++)
+		{
+			const auto minY = -1.0f + 2.0f * y / LIGHT_CLUSTER_Y;
+			const auto maxY = -1.0f + 2.0f * (y + 1) / LIGHT_CLUSTER_Y;
+
+			for (unsigned int x = 0; x < LIGHT_CLUSTER_X; x++)
+			{
+				const auto minX = -1.0f + 2.0f * x / LIGHT_CLUSTER_X;
+				const auto maxX = -1.0f + 2.0f * (x + 1) / LIGHT_CLUSTER_X;
+
+				// Bounds of the frustum segment, the sides widen with depth
+				auto &bounds = m_Bounds[x + LIGHT_CLUSTER_X * (y + LIGHT_CLUSTER_Y * z)];
+				bounds.Min.x = std::min(minX * nearDepth, minX * farDepth) * scaleX;
+				bounds.Max.x = std::max(maxX * nearDepth, maxX * farDepth) * scaleX;
+				bounds.Min.y = std::min(minY * nearDepth, minY * farDepth) * scaleY;
+				bounds.Max.y = std::max(maxY * nearDepth, maxY * farDepth) * scaleY;
+				bounds.Min.z = -farDepth;
+				bounds.Max.z = -nearDepth;
+			}
+		}
+	}
+}
+
+unsigned int LightClusters::getSlice(float depth) const
+{
+	if (depth <= m_Near)
+		return 0;
+
+	const auto slice = static_cast<int>(std::log(depth) * m_SliceScale + m_SliceBias);
+	return std::min(std::max(slice, 0), LIGHT_CLUSTER_Z - 1);
+}
+
+void LightClusters::assignSlices(unsigned int begin, unsigned int end)
+{
+	// Every cluster is written by exactly one job
+	for (unsigned int z = begin; z < end; z++)
+	{
+		for (const auto &light : m_Lights)
+		{
+			if (z < light.MinSlice || z > light.MaxSlice)
+				continue;
+
+			for (unsigned int y = 0; y < LIGHT_CLUSTER_Y; y++)
+			{
+				for (unsigned int x = 0; x < LIGHT_CLUSTER_X; x++)
+				{
+					const auto cluster = x + LIGHT_CLUSTER_X * (y + LIGHT_CLUSTER_Y * z);
+
+					// Sphere against cluster bounds, unbounded lights always pass
+					if (light.Range > 0.0f)
+					{
+						const auto &bounds = m_Bounds[cluster];
+						const auto closest = glm::clamp(light.Position, bounds.Min, bounds.Max);
+						const auto delta = closest - light.Position;
+						if (glm::dot(delta, delta) > light.Range * light.Range)
+							continue;
+					}
+
+					auto &count = m_ClusterCounts[cluster];
+					if (count < LIGHT_CLUSTER_LIGHTS_MAX)
+						m_ClusterLights[cluster * LIGHT_CLUSTER_LIGHTS_MAX + count++] = light.Index;
+				}
+			}
+		}
+	}
+}
+
+void LightClusters::Assign(const glm::mat4 &view, const glm::mat4 &projection, float near, float far, const LightClusterSphere *lights, unsigned int count)
+{
+	// Negative far planes are infinite projections
+	far = far < 0.0f ? LIGHT_CLUSTER_FAR : std::min(far, LIGHT_CLUSTER_FAR);
+	if (projection != m_Projection || near != m_Near || far != m_Far)
+		buildBounds(projection, near, far);
+
+	// Transform lights into view space and find their slice range
+	m_Lights.clear();
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const auto &sphere = lights[i];
+
+		ViewLight light;
+		light.Position = glm::vec3(view * glm::vec4(sphere.Position, 1.0f));
+		light.Range = sphere.Range;
+		light.Index = i;
+
+		if (sphere.Range > 0.0f)
+		{
+			const auto depth = -light.Position.z;
+			if (depth + sphere.Range < m_Near || depth - sphere.Range > m_Far)
+				continue;
+
+			light.MinSlice = getSlice(depth - sphere.Range);
+			light.MaxSlice = getSlice(depth + sphere.Range);
+		}
+		else
+		{
+			light.MinSlice = 0;
+			light.MaxSlice = LIGHT_CLUSTER_Z - 1;
+		}
+
+		m_Lights.push_back(light);
+	}
+
+	std::fill(m_ClusterCounts.begin(), m_ClusterCounts.end(), 0);
+
+	if (!m_Lights.empty())
+	{
+		m_JobSystem->ParallelFor(LIGHT_CLUSTER_Z, LIGHT_CLUSTER_JOB_SLICES, [this](unsigned int begin, unsigned int end)
+		{
+			assignSlices(begin, end);
+		});
+	}
+
+	// Compact into one index list, the grid holds offset and count per cluster
+	m_Indices.clear();
+	for (unsigned int i = 0; i < LIGHT_CLUSTER_COUNT; i++)
+	{
+		const auto clusterCount = m_ClusterCounts[i];
+		m_Grid[i] = glm::uvec2(m_Indices.size(), clusterCount);
+
+		const auto begin = m_ClusterLights.begin() + i * LIGHT_CLUSTER_LIGHTS_MAX;
+		m_Indices.insert(m_Indices.end(), begin, begin + clusterCount);
+	}
+}
+
+const std::vector<glm::uvec2> &LightClusters::GetGrid() const
+{
+	return m_Grid;
+}
+
+const std::vector<unsigned int> &LightClusters::GetIndices() const
+{
+	return m_Indices;
+}
+
+float LightClusters::GetNear() const
+{
+	return m_Near;
+}
+
+float LightClusters::GetFar() const
+{
+	return m_Far;
+}
+
+float LightClusters::GetSliceScale() const
+{
+	return m_SliceScale;
+}
+
+float LightClusters::GetSliceBias() const
+{
+	return m_SliceBias;
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "JobSystem.h"
+#include <vector>
+#include <glm/glm.hpp>
+
+// Cluster grid over the view frustum, slices are exponential in depth
+#ifndef LIGHT_CLUSTER_X
+#define LIGHT_CLUSTER_X 16
+#endif
+
+#ifndef LIGHT_CLUSTER_Y
+#define LIGHT_CLUSTER_Y 9
+#endif
+
+#ifndef LIGHT_CLUSTER_Z
+#define LIGHT_CLUSTER_Z 24
+#endif
+
+#define LIGHT_CLUSTER_COUNT (LIGHT_CLUSTER_X * LIGHT_CLUSTER_Y * LIGHT_CLUSTER_Z)
+
+#ifndef LIGHT_CLUSTER_LIGHTS_MAX
+#define LIGHT_CLUSTER_LIGHTS_MAX 128 // Per cluster, further lights are dropped
+#endif
+
+#ifndef LIGHT_CLUSTER_FAR
+#define LIGHT_CLUSTER_FAR 2000.0f // Depth covered by the grid, lights and fragments beyond are not clustered
+#endif
+
+#ifndef LIGHT_CLUSTER_JOB_SLICES
+#define LIGHT_CLUSTER_JOB_SLICES 1 // Depth slices per job, idle workers steal the rest
+#endif
+
+// Sphere of influence of a point light, a range of 0 reaches every cluster
+struct LightClusterSphere
+{
+	glm::vec3 Position;
+	float Range;
+};
+
+// Assigns point lights to clusters on the CPU, slices are split between jobs
+class LightClusters
+{
+	struct ViewLight
+	{
+		glm::vec3 Position; // View space
+		float Range;
+		unsigned int MinSlice;
+		unsigned int MaxSlice;
+		unsigned int Index;
+	};
+
+	struct Bounds
+	{
+		glm::vec3 Min;
+		glm::vec3 Max;
+	};
+
+	// Cluster bounds, rebuilt when the projection changes
+	std::vector<Bounds> m_Bounds;
+	glm::mat4 m_Projection;
+	float m_Near;
+	float m_Far;
+	float m_SliceScale;
+	float m_SliceBias;
+
+	std::vector<ViewLight> m_Lights;
+	std::vector<unsigned int> m_ClusterCounts;
+	std::vector<unsigned int> m_ClusterLights; // LIGHT_CLUSTER_LIGHTS_MAX per cluster
+
+	// Output
+	std::vector<glm::uvec2> m_Grid; // Offset, count per cluster
+	std::vector<unsigned int> m_Indices;
+
+	JobSystem *m_JobSystem;
+
+	void buildBounds(const glm::mat4 &projection, float near, float far);
+	unsigned int getSlice(float depth) const;
+	void assignSlices(unsigned int begin, unsigned int end);
+
+public:
+	explicit LightClusters(JobSystem *jobSystem);
+	~LightClusters();
+
+	// No copying/moving
+	LightClusters(const LightClusters &) = delete;
+	LightClusters &operator=(const LightClusters &) = delete;
+
+	LightClusters(const LightClusters &&) = delete;
+	LightClusters &operator=(const LightClusters &&) = delete;
+
+	void Assign(const glm::mat4 &view, const glm::mat4 &projection, float near, float far, const LightClusterSphere *lights, unsigned int count);
+
+	const std::vector<glm::uvec2> &GetGrid() const;
+	const std::vector<unsigned int> &GetIndices() const;
+
+	float GetNear() const;
+	float GetFar() const;
+
+	// Slice = log(depth) * scale + bias
+	float GetSliceScale() const;
+	float GetSliceBias() const;
+};
\ No newline at end of file
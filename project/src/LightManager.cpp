@@ -1,5 +1,6 @@
 #include "LightManager.h"
-#include <map>
+#include "Camera.h"
+#include <chrono>
 
 ILight::ILight(std::string name, unsigned int type, Object *parent)
 	: Object(std::move(name), parent), m_Type(type), m_Intensity(0.0f), m_Ambient(0.0f), m_Diffuse(0.0f), m_Specular(0.0f)
@@ -66,23 +67,23 @@ void DirectionalLight::SetDirection(const glm::vec3 &direction)
 	m_Direction = direction;
 }
 
-void DirectionalLight::SetCount(Shader * shader, unsigned int count)
+void DirectionalLight::Apply(LightData &data)
 {
-	shader->GetVariable(kLightVar_DirectionalLightCount)->SetInt(count);
-}
+	auto &block = data.Block;
+	if (block.DirectionalLightCount >= LIGHTS_DIRECTIONAL_MAX)
+		return;
 
-void DirectionalLight::Apply(Shader *shader, unsigned int index)
-{
-	shader->GetVariable(LIGHT_GET_BLOCK_VARIABLE(kLightVar_DirectionalLights, index, "Direction"))->SetVec3(m_Direction);
-	shader->GetVariable(LIGHT_GET_BLOCK_VARIABLE(kLightVar_DirectionalLights, index, "Intensity"))->SetFloat(m_Intensity);
+	auto &light = block.DirectionalLights[block.DirectionalLightCount++];
+	light.Direction = m_Direction;
+	light.Intensity = m_Intensity;
 
-	shader->GetVariable(LIGHT_GET_BLOCK_VARIABLE(kLightVar_DirectionalLights, index, "Ambient"))->SetVec3(m_Ambient);
-	shader->GetVariable(LIGHT_GET_BLOCK_VARIABLE(kLightVar_DirectionalLights, index, "Diffuse"))->SetVec3(m_Diffuse);
-	shader->GetVariable(LIGHT_GET_BLOCK_VARIABLE(kLightVar_DirectionalLights, index, "Specular"))->SetVec3(m_Specular);
+	light.Ambient = m_Ambient;
+	light.Diffuse = m_Diffuse;
+	light.Specular = m_Specular;
 }
 
 PointLight::PointLight(Object *parent)
-	: ILight("PointLight", kLightType_Point, parent), m_Position(0.0f)
+	: ILight("PointLight", kLightType_Point, parent), m_Position(0.0f), m_Range(0.0f)
 {
 }
 
@@ -96,19 +97,37 @@ void PointLight::SetPosition(const glm::vec3 &position)
 	m_Position = position;
 }
 
-void PointLight::SetCount(Shader * shader, unsigned int count)
+float PointLight::GetRange() const
+{
+	return m_Range;
+}
+
+void PointLight::SetRange(float range)
 {
-	shader->GetVariable(kLightVar_PointLightCount)->SetInt(count);
+	m_Range = range;
 }
 
-void PointLight::Apply(Shader *shader, unsigned int index)
+void PointLight::Apply(LightData &data)
 {
-	shader->GetVariable(LIGHT_GET_BLOCK_VARIABLE(kLightVar_PointLights, index, "Position"))->SetVec3(m_Position);
-	shader->GetVariable(LIGHT_GET_BLOCK_VARIABLE(kLightVar_PointLights, index, "Intensity"))->SetFloat(m_Intensity);
+	PointLightData light{};
+	light.Position = m_Position;
+	light.Range = m_Range;
+	light.Intensity = m_Intensity;
+
+	light.Ambient = m_Ambient;
+	light.Diffuse = m_Diffuse;
+	light.Specular = m_Specular;
 
-	shader->GetVariable(LIGHT_GET_BLOCK_VARIABLE(kLightVar_PointLights, index, "Ambient"))->SetVec3(m_Ambient);
-	shader->GetVariable(LIGHT_GET_BLOCK_VARIABLE(kLightVar_PointLights, index, "Diffuse"))->SetVec3(m_Diffuse);
-	shader->GetVariable(LIGHT_GET_BLOCK_VARIABLE(kLightVar_PointLights, index, "Specular"))->SetVec3(m_Specular);
+	data.PointLights.push_back(light);
+	data.PointLightSpheres.push_back({ m_Position, m_Range });
+	data.Block.PointLightCount++;
+}
+
+LightManager::LightManager(JobSystem *jobSystem)
+	: m_Block(kShaderBlockBinding_Lights), m_LightBuffer(TextureBuffer::kFormat_RGBA32F, sizeof(PointLightData)),
+	m_GridBuffer(TextureBuffer::kFormat_RG32UI, sizeof(glm::uvec2) * LIGHT_CLUSTER_COUNT),
+	m_IndexBuffer(TextureBuffer::kFormat_R32UI, sizeof(unsigned int)), m_Clusters(jobSystem), m_Stats()
+{
 }
 
 LightManager::~LightManager()
@@ -118,40 +137,48 @@ LightManager::~LightManager()
 	m_Lights.clear();
 }
 
-void LightManager::Apply(Shader *shader, const glm::vec3 &viewPosition)
+void LightManager::Apply(Camera *camera)
 {
-	// Use shader
-	shader->Use();
-
-	// Set view position
-	shader->GetVariable(kLightVar_ViewPosition)->SetVec3(viewPosition);
-
-	std::map<unsigned int, unsigned int> typeCount;
-	
+	LightData data{};
 	for (const auto &l : m_Lights)
 	{
 		// Ignore inactive lights
 		if (!l->IsActive())
 			continue;
 
-		// Increase index of active light
-		const auto idx = typeCount[l->GetType()];
-		++typeCount[l->GetType()];
-
-		// Apply light to shader
-		l->Apply(shader, idx);
+		l->Apply(data);
 	}
 
-	// Store counts in shader
-	for (const auto &p : typeCount)
-	{
-		for (const auto &l : m_Lights)
-		{
-			if (l->GetType() == p.first)
-			{
-				l->SetCount(shader, p.second);
-				break;
-			}
-		}
-	}
+	// Assign point lights to the clusters of the camera frustum
+	const auto start = std::chrono::high_resolution_clock::now();
+	m_Clusters.Assign(camera->GetViewMatrix(), camera->GetProjectionMatrix(), camera->GetNearPlane(), camera->GetFarPlane(),
+		data.PointLightSpheres.data(), data.PointLightSpheres.size());
+	const auto end = std::chrono::high_resolution_clock::now();
+
+	auto &block = data.Block;
+	block.ClusterCount = glm::uvec4(LIGHT_CLUSTER_X, LIGHT_CLUSTER_Y, LIGHT_CLUSTER_Z, 0);
+	block.ClusterDepth = glm::vec4(m_Clusters.GetNear(), m_Clusters.GetFar(), m_Clusters.GetSliceScale(), m_Clusters.GetSliceBias());
+
+	// One upload for every shader using the block
+	m_Block.SetData(block);
+	m_Block.Bind();
+
+	const auto &grid = m_Clusters.GetGrid();
+	const auto &indices = m_Clusters.GetIndices();
+	m_LightBuffer.SetData(data.PointLights.size() * sizeof(PointLightData), data.PointLights.data());
+	m_GridBuffer.SetData(grid.size() * sizeof(glm::uvec2), grid.data());
+	m_IndexBuffer.SetData(indices.size() * sizeof(unsigned int), indices.data());
+
+	m_LightBuffer.Activate(SHADER_SHARED_TEXTURE_UNIT + kShaderSharedTexture_LightData);
+	m_GridBuffer.Activate(SHADER_SHARED_TEXTURE_UNIT + kShaderSharedTexture_ClusterGrid);
+	m_IndexBuffer.Activate(SHADER_SHARED_TEXTURE_UNIT + kShaderSharedTexture_ClusterLights);
+
+	m_Stats.PointLights = data.PointLights.size();
+	m_Stats.ClusterIndices = indices.size();
+	m_Stats.AssignTime = std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+const LightStats &LightManager::GetStats() const
+{
+	return m_Stats;
 }
\ No newline at end of file
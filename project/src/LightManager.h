@@ -3,29 +3,81 @@
 #include "Object.h"
 #include "Shader.h"
 #include "GraphicsManager.h"
+#include "UniformBuffer.h"
+#include "TextureBuffer.h"
+#include "LightClusters.h"
+#include "Memory.h"
 #include "Utility/Exception.h"
 #include <glm/glm.hpp>
 
-#ifndef LIGHTS_MAX
-#define LIGHTS_MAX 255
-#endif
+// Block capacity, must match DIRECTIONAL_LIGHTS_MAX in the light shader,
+// point lights are stored in a texture buffer and have no fixed limit
+#define LIGHTS_DIRECTIONAL_MAX 1
+
+class Camera;
 
 DEFINE_EXCEPTION(LightNotFoundException);
 
-#define LIGHT_DEFINE_VARIABLE(name) static const char *kLightVar_ ## name =  "u_" #name
-#define LIGHT_GET_BLOCK_VARIABLE(var, i, name) String::Format("%s[%d].%s", var, i, name)
+// std140 layout of the Lights block, vec3 members are padded to 16 bytes
+struct DirectionalLightData
+{
+	glm::vec3 Direction;
+	float Intensity;
+	glm::vec3 Ambient;
+	float Padding0;
+	glm::vec3 Diffuse;
+	float Padding1;
+	glm::vec3 Specular;
+	float Padding2;
+};
 
-// Vars
-LIGHT_DEFINE_VARIABLE(ViewPosition);
-LIGHT_DEFINE_VARIABLE(DirectionalLightCount);
-LIGHT_DEFINE_VARIABLE(DirectionalLights);
-LIGHT_DEFINE_VARIABLE(PointLightCount);
-LIGHT_DEFINE_VARIABLE(PointLights);
+// Four RGBA32F texels of the light data texture buffer
+struct PointLightData
+{
+	glm::vec3 Position;
+	float Range;
+	glm::vec3 Ambient;
+	float Intensity;
+	glm::vec3 Diffuse;
+	float Padding0;
+	glm::vec3 Specular;
+	float Padding1;
+};
+
+struct LightsBlock
+{
+	int DirectionalLightCount;
+	int PointLightCount;
+	int Padding[2];
+	glm::uvec4 ClusterCount; // x, y, z, unused
+	glm::vec4 ClusterDepth; // Near, far, slice scale, slice bias
+	DirectionalLightData DirectionalLights[LIGHTS_DIRECTIONAL_MAX];
+};
+
+static_assert(sizeof(LightsBlock) == 48 + 64 * LIGHTS_DIRECTIONAL_MAX, "LightsBlock does not match the std140 layout");
+static_assert(sizeof(PointLightData) == 64, "PointLightData must be four texels");
+
+// Everything written by the lights for one frame
+struct LightData
+{
+	LightsBlock Block;
+	FrameVector<PointLightData> PointLights;
+	FrameVector<LightClusterSphere> PointLightSpheres;
+};
+
+struct LightStats
+{
+	unsigned int PointLights;
+	unsigned int ClusterIndices;
+	float AssignTime; // Milliseconds spent assigning lights to clusters
+};
 
 enum LightType
 {
 	kLightType_Directional,
-	kLightType_Point
+	kLightType_Point,
+
+	kLightType_Count
 };
 
 class ILight : public Object
@@ -65,8 +117,8 @@ public:
 	const glm::vec3 &GetSpecular() const;
 	void SetSpecular(const glm::vec3 &specular);
 
-	virtual void SetCount(Shader *shader, unsigned int count) = 0;
-	virtual void Apply(Shader *shader, unsigned int index = 0) = 0;
+	// Writes the light into the frame data, directional lights are ignored when the block is full
+	virtual void Apply(LightData &data) = 0;
 };
 
 class DirectionalLight : public ILight
@@ -79,13 +131,13 @@ public:
 	const glm::vec3 &GetDirection() const;
 	void SetDirection(const glm::vec3 &direction);
 
-	void SetCount(Shader *shader, unsigned int count) override;
-	void Apply(Shader *shader, unsigned int index) override;
+	void Apply(LightData &data) override;
 };
 
 class PointLight : public ILight
 {
 	glm::vec3 m_Position;
+	float m_Range; // Zero lights everything
 
 public:
 	PointLight(Object *parent = nullptr);
@@ -93,17 +145,28 @@ public:
 	const glm::vec3 &GetPosition() const;
 	void SetPosition(const glm::vec3 &position);
 
-	void SetCount(Shader *shader, unsigned int count) override;
-	void Apply(Shader *shader, unsigned int index) override;
+	float GetRange() const;
+	void SetRange(float range);
+
+	void Apply(LightData &data) override;
 };
 
 // Not thread safe
 class LightManager
 {
 	std::vector<ILight *> m_Lights;
-	
+	UniformBuffer<LightsBlock> m_Block; // Shared with all shaders
+
+	// Point lights and their cluster lists, bound to the shared texture units
+	TextureBuffer m_LightBuffer;
+	TextureBuffer m_GridBuffer;
+	TextureBuffer m_IndexBuffer;
+	LightClusters m_Clusters;
+
+	LightStats m_Stats; // Of the last apply
+
 public:
-	LightManager() = default;
+	explicit LightManager(JobSystem *jobSystem); // Assigns lights to clusters on its workers
 	~LightManager();
 
 	// No copying/moving
@@ -113,7 +176,11 @@ public:
 	LightManager(const LightManager &&) = delete;
 	LightManager &operator=(const LightManager &&) = delete;
 
-	void Apply(Shader *shader, const glm::vec3 &viewPosition);
+	// Uploads all active lights and assigns point lights to the clusters of the camera,
+	// the view position comes from the camera block
+	void Apply(Camera *camera);
+
+	const LightStats &GetStats() const;
 
 	template<class TLight, typename... TArgs>
 	TLight *CreateLight(TArgs... args)
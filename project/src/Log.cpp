@@ -3,12 +3,14 @@
 #include <iostream>
 #include <iomanip>
 #include <ctime>
+#include <mutex>
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
 
 std::ofstream g_LogStream;
 LogType g_LogType;
 bool g_LogOpen;
+std::mutex g_LogMutex; // Asset loads log from workers
 
 void LogOpen(const std::string &fileName, LogType level)
 {
@@ -94,6 +96,7 @@ void LogWrite(LogType type, const std::string &title, std::string format, ...)
 	tm localTime{};
 	localtime_s(&localTime, &currentTime);
 
+	std::lock_guard<std::mutex> lock(g_LogMutex);
 	LogWriteToStream(std::cout, title, message, typeString, localTime);
 	if (g_LogOpen) LogWriteToStream(g_LogStream, title, message, typeString, localTime);
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "Memory.h"
+#include "Shader.h"
 #include "Log.h"
 #include "Window.h"
+#include "Benchmark.h"
 
 #include <GL/glew.h>
 #include <GL/freeglut.h>
@@ -11,6 +13,7 @@
 #define FULLSCREEN false
 #define WIREFRAME false
 #define MULTISAMPLE 8
+//#define RUN_BENCHMARKS
 
 // Vars
 Window *g_Window;
@@ -25,6 +28,13 @@ extern void Project_Render(float time, float deltaTime);
 
 static void Update()
 {
+	// Release transient memory used by the last update/render cycle
+	MemoryFrameReset();
+
+	// Sample allocation and uniform upload statistics
+	MemorySampleStats();
+	ShaderSampleUniformStats();
+
 	const auto time = glutGet(GLUT_ELAPSED_TIME);
 	const auto deltaTime = static_cast<float>(time) - static_cast<float>(g_LastUpdateTime);
 
@@ -151,6 +161,11 @@ int main(int argc, char **argv)
 	// Initialize memory subsystem
 	MemoryInitialize();
 
+#ifdef RUN_BENCHMARKS
+	// Run micro benchmarks before anything else is allocated
+	RunBenchmarks();
+#endif
+
 	// Initialize GLUT
 	glutInit(&argc, argv);
 
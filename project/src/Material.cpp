@@ -116,9 +116,12 @@ void MaterialVariable::Apply()
 		m_ShaderVariable->SetBool(static_cast<bool>(m_Value[0].x));
 		break;
 	case kShaderVariableType_Int:
-	case kShaderVariableType_Sampler2D:
 		m_ShaderVariable->SetInt(static_cast<int>(m_Value[0].x));
 		break;
+	case kShaderVariableType_Sampler2D:
+	case kShaderVariableType_Sampler2DArray:
+		// Set to the unit of the texture by the material
+		break;
 	case kShaderVariableType_UInt:
 		m_ShaderVariable->SetUInt(static_cast<unsigned int>(m_Value[0].x));
 		break;
@@ -148,8 +151,8 @@ void MaterialVariable::Apply()
 	m_ShaderVariable->SetTypeCheck(true);
 }
 
-MaterialResource::MaterialResource(std::string name, Texture *texture, unsigned int slot)
-	: m_Name(std::move(name)), m_Texture(texture), m_Slot(slot)
+MaterialResource::MaterialResource(std::string name, Texture *texture, unsigned int slot, ShaderVariable *variable)
+	: m_Name(std::move(name)), m_Handle(HashString(m_Name.c_str())), m_Texture(texture), m_Slot(slot), m_Variable(variable)
 {
 }
 
@@ -158,6 +161,11 @@ const std::string &MaterialResource::GetName() const
 	return m_Name;
 }
 
+ShaderVariableHandle MaterialResource::GetHandle() const
+{
+	return m_Handle;
+}
+
 Texture *MaterialResource::GetTexture() const
 {
 	return m_Texture;
@@ -168,20 +176,31 @@ unsigned MaterialResource::GetSlot() const
 	return m_Slot;
 }
 
+ShaderVariable *MaterialResource::GetVariable() const
+{
+	return m_Variable;
+}
+
 void MaterialResource::SetTexture(Texture *texture)
 {
 	m_Texture = texture;
 }
 
+static unsigned int g_MaterialNextID = 1;
+
 Material::Material(std::string name, Shader *shader)
-	: m_Name(std::move(name)), m_Shader(shader)
+	: m_ID(g_MaterialNextID++), m_Name(std::move(name)), m_Shader(shader)
 {
 	// Read shader vars and make material vars for them
 	for (auto &var : m_Shader->GetVariables())
 	{
 		// Only store variables if they are referring to the material
 		if (var->GetName().substr(0, strlen(MATERIAL_KEY_NAME)) == MATERIAL_KEY_NAME)
-			m_Variables.push_back(New<MaterialVariable>(var));
+		{
+			const auto materialVar = New<MaterialVariable>(var);
+			m_Variables.push_back(materialVar);
+			m_VariableTable.emplace(HashString(var->GetName().c_str()), materialVar);
+		}
 	}
 }
 
@@ -191,6 +210,7 @@ Material::~Material()
 		Delete(var);
 
 	m_Variables.clear();
+	m_VariableTable.clear();
 
 	for (auto &res : m_Resources)
 		Delete(res);
@@ -198,47 +218,62 @@ Material::~Material()
 	m_Resources.clear();
 }
 
-Texture *Material::GetTexture(const std::string &name) const
+MaterialResource *Material::findResource(ShaderVariableHandle handle) const
 {
 	for (auto &res : m_Resources)
 	{
-		if (res->GetName() == name)
-			return res->GetTexture();
+		if (res->GetHandle() == handle)
+			return res;
 	}
 
-	THROW_EXCEPTION(MaterialTextureNotFoundException, "Texture %s not found", name.c_str());
+	return nullptr;
+}
+
+Texture *Material::GetTexture(const std::string &name) const
+{
+	const auto res = findResource(HashString(name.c_str()));
+	if (!res)
+		THROW_EXCEPTION(MaterialTextureNotFoundException, "Texture %s not found", name.c_str());
+
+	return res->GetTexture();
 }
 
 unsigned int Material::GetTextureSlot(const std::string &name) const
 {
-	for (auto &res : m_Resources)
-	{
-		if (res->GetName() == name)
-			return res->GetSlot();
-	}
+	const auto res = findResource(HashString(name.c_str()));
+	if (!res)
+		THROW_EXCEPTION(MaterialTextureNotFoundException, "Texture %s not found", name.c_str());
 
-	THROW_EXCEPTION(MaterialTextureNotFoundException, "Texture %s not found", name.c_str());
+	return res->GetSlot();
 }
 
 // Active texture limit is 16/32
-unsigned int Material::SetTexture(const std::string &name, Texture *texture)
+unsigned int Material::SetTexture(const std::string &name, Texture *texture, unsigned int layer)
 {
+	// Shaders without a layer variable sample the first layer
+	const auto layerName = name + MATERIAL_LAYER_SUFFIX;
+	if (IsVariable(layerName))
+		GetVariable(layerName)->SetInt(static_cast<int>(layer));
+
 	// Check if texture with name is already present
-	for (auto &res : m_Resources)
+	const auto res = findResource(HashString(name.c_str()));
+	if (res)
 	{
-		if (res->GetName() == name)
-		{
-			res->SetTexture(texture);
-			return res->GetSlot();
-		}
+		res->SetTexture(texture);
+		return res->GetSlot();
 	}
 
 	// Add resource
 	const auto slot = m_Resources.size();
-	m_Resources.push_back(New<MaterialResource>(name, texture, slot));
+	m_Resources.push_back(New<MaterialResource>(name, texture, slot, m_Shader->GetVariable(name)));
 	return slot;
 }
 
+unsigned int Material::GetID() const
+{
+	return m_ID;
+}
+
 const std::string & Material::GetName() const
 {
 	return m_Name;
@@ -251,24 +286,54 @@ Shader *Material::GetShader() const
 
 bool Material::IsVariable(const std::string &name) const
 {
-	for (auto &var : m_Variables)
-	{
-		if (var->GetName() == name)
-			return true;
-	}
+	return IsVariable(name.c_str());
+}
+
+bool Material::IsVariable(const char *name) const
+{
+	return IsVariable(HashString(name));
+}
 
-	return false;
+bool Material::IsVariable(const ShaderVariableName &name) const
+{
+	return IsVariable(name.Handle);
+}
+
+bool Material::IsVariable(ShaderVariableHandle handle) const
+{
+	return m_VariableTable.find(handle) != m_VariableTable.end();
 }
 
 MaterialVariable *Material::GetVariable(const std::string &name)
 {
-	for (auto &var : m_Variables)
-	{
-		if (var->GetName() == name)
-			return var;
-	}
-	
-	THROW_EXCEPTION(MaterialVariableNotFoundException, "Variable %s not found", name.c_str());
+	return GetVariable(name.c_str());
+}
+
+MaterialVariable *Material::GetVariable(const char *name)
+{
+	const auto it = m_VariableTable.find(HashString(name));
+	if (it == m_VariableTable.end())
+		THROW_EXCEPTION(MaterialVariableNotFoundException, "Variable %s not found", name);
+
+	return it->second;
+}
+
+MaterialVariable *Material::GetVariable(const ShaderVariableName &name)
+{
+	const auto it = m_VariableTable.find(name.Handle);
+	if (it == m_VariableTable.end())
+		THROW_EXCEPTION(MaterialVariableNotFoundException, "Variable %s not found", name.Name);
+
+	return it->second;
+}
+
+MaterialVariable *Material::GetVariable(ShaderVariableHandle handle)
+{
+	const auto it = m_VariableTable.find(handle);
+	if (it == m_VariableTable.end())
+		THROW_EXCEPTION(MaterialVariableNotFoundException, "Variable 0x%08X not found", handle);
+
+	return it->second;
 }
 
 std::vector<MaterialVariable *> Material::GetVariables() const
@@ -276,11 +341,8 @@ std::vector<MaterialVariable *> Material::GetVariables() const
 	return m_Variables;
 }
 
-void Material::Apply()
+void Material::Apply(GraphicsManager *graphicsManager)
 {
-	// Activate shader
-	m_Shader->Use();
-
 	// Apply material vars
 	for (auto &var : m_Variables)
 		var->Apply();
@@ -288,15 +350,14 @@ void Material::Apply()
 	// Apply textures to texture units
 	for (auto &res : m_Resources)
 	{
-		const auto texture = res->GetTexture();
-		const auto slot = res->GetSlot();
-		const auto var = m_Shader->GetVariable(res->GetName());
+		const auto var = res->GetVariable();
 
-		texture->Activate(slot);
+		// Textures stay on their unit while they are in use, only new ones are bound
+		const auto unit = graphicsManager->Bind(res->GetTexture());
 
-		// Set slot
+		// Point the sampler at the unit, only uploaded when the unit differs from the last material
 		var->SetTypeCheck(false);
-		var->SetInt(slot);
+		var->SetInt(static_cast<int>(unit));
 		var->SetTypeCheck(true);
 	}
 }
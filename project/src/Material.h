@@ -9,8 +9,9 @@ DEFINE_EXCEPTION(MaterialTextureNotFoundException);
 DEFINE_EXCEPTION(MaterialUnsupportedTypeException);
 
 #define MATERIAL_KEY_NAME "u_Material"
-#define MATERIAL_DEFINE_VARIABLE(name) static const char *kMaterialVar_ ## name =  MATERIAL_KEY_NAME "." #name
+#define MATERIAL_DEFINE_VARIABLE(name) static constexpr ShaderVariableName kMaterialVar_ ## name(MATERIAL_KEY_NAME "." #name)
 #define MATERIAL_LOCAL_NAME(name) #name
+#define MATERIAL_LAYER_SUFFIX "Layer" // Appended to a texture name for the variable selecting its array layer
 
 // Default vars
 MATERIAL_DEFINE_VARIABLE(Ambient);
@@ -19,10 +20,13 @@ MATERIAL_DEFINE_VARIABLE(Specular);
 
 MATERIAL_DEFINE_VARIABLE(TextureAmbient);
 MATERIAL_DEFINE_VARIABLE(TextureAmbientEnabled);
+MATERIAL_DEFINE_VARIABLE(TextureAmbientLayer);
 MATERIAL_DEFINE_VARIABLE(TextureDiffuse);
 MATERIAL_DEFINE_VARIABLE(TextureDiffuseEnabled);
+MATERIAL_DEFINE_VARIABLE(TextureDiffuseLayer);
 MATERIAL_DEFINE_VARIABLE(TextureSpecular);
 MATERIAL_DEFINE_VARIABLE(TextureSpecularEnabled);
+MATERIAL_DEFINE_VARIABLE(TextureSpecularLayer);
 
 MATERIAL_DEFINE_VARIABLE(Shininess);
 
@@ -62,26 +66,34 @@ public:
 class MaterialResource
 {
 	std::string m_Name;
+	ShaderVariableHandle m_Handle;
 	Texture *m_Texture;
-	unsigned int m_Slot; // Active texture slot/unit
+	unsigned int m_Slot; // Order in the material, units are assigned by the graphics manager
+	ShaderVariable *m_Variable; // Sampler
 
 public:
-	MaterialResource(std::string name, Texture *texture, unsigned int slot);
+	MaterialResource(std::string name, Texture *texture, unsigned int slot, ShaderVariable *variable);
 
 	const std::string &GetName() const;
+	ShaderVariableHandle GetHandle() const;
 	Texture *GetTexture() const;
 	unsigned int GetSlot() const;
+	ShaderVariable *GetVariable() const;
 
 	void SetTexture(Texture *texture);
 };
 
 class Material
 {
+	unsigned int m_ID; // Unique, used for render sorting
 	std::string m_Name;
 	Shader *m_Shader;
 	std::vector<MaterialVariable *> m_Variables;
+	std::unordered_map<ShaderVariableHandle, MaterialVariable *> m_VariableTable;
 	std::vector<MaterialResource *> m_Resources;
 
+	MaterialResource *findResource(ShaderVariableHandle handle) const;
+
 public:
 	Material(std::string name, Shader *shader);
 	~Material();
@@ -95,15 +107,23 @@ public:
 
 	Texture *GetTexture(const std::string &name) const;
 	unsigned int GetTextureSlot(const std::string &name) const;
-	unsigned int SetTexture(const std::string &name, Texture *texture); // Not thread safe
+	unsigned int SetTexture(const std::string &name, Texture *texture, unsigned int layer = 0); // Not thread safe
 
+	unsigned int GetID() const;
 	const std::string &GetName() const;
 
 	Shader *GetShader() const;
 
+	// Prefer the handle overloads on hot paths, names are hashed per call
 	bool IsVariable(const std::string &name) const;
+	bool IsVariable(const char *name) const;
+	bool IsVariable(const ShaderVariableName &name) const;
+	bool IsVariable(ShaderVariableHandle handle) const;
 	MaterialVariable *GetVariable(const std::string &name);
+	MaterialVariable *GetVariable(const char *name);
+	MaterialVariable *GetVariable(const ShaderVariableName &name);
+	MaterialVariable *GetVariable(ShaderVariableHandle handle);
 	std::vector<MaterialVariable *> GetVariables() const;
 
-	void Apply();
+	void Apply(GraphicsManager *graphicsManager); // Shader must be in use, textures already bound are skipped
 };
\ No newline at end of file
@@ -1,20 +1,488 @@
 #include "Memory.h"
 #include "Log.h"
-#include <map>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <mutex>
+#include <new>
+#include <vector>
 
-struct Block
+#define MEMORY_BLOCK_MAGIC 0x424D454D // "MEMB"
+#define MEMORY_LARGE_CLASS 0xFFFF
+
+enum BlockState : uint16_t
+{
+	kBlockState_Free,
+	kBlockState_Allocated
+};
+
+// Stored directly in front of every allocation, replaces the old block map
+struct alignas(16) BlockHeader
 {
-	std::string TypeName;
+	const char *TypeName;
 	size_t TypeHash;
 	uint64_t Size;
-	const void *Data;
+	BlockHeader *Next; // Free list when pooled, live list when large
+	BlockHeader *Prev; // Live list when large
+	uint32_t Magic;
+	uint16_t SizeClass;
+	uint16_t State;
+};
+
+// Payload sizes for each pool, anything larger goes straight to malloc
+static const uint32_t kSizeClasses[] = { 16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048 };
+static const size_t kSizeClassCount = sizeof(kSizeClasses) / sizeof(kSizeClasses[0]);
+
+struct Slab
+{
+	uint8_t *Data;
+	uint16_t SizeClass;
+	uint32_t BlockCount;
+};
+
+struct SizeClassPool
+{
+	BlockHeader *Free;
+	uint32_t FreeCount;
+};
+
+struct MemoryPool
+{
+	std::mutex Mutex;
+	SizeClassPool Classes[kSizeClassCount];
+	std::vector<Slab> Slabs;
+	BlockHeader *Large;
+
+	MemoryPool()
+		: Classes(), Large(nullptr)
+	{
+	}
+
+	~MemoryPool()
+	{
+		for (auto &slab : Slabs)
+			free(slab.Data);
+		Slabs.clear();
+	}
+};
+
+// Per thread free lists, only touches the pool lock on refill/overflow
+struct ThreadCache
+{
+	BlockHeader *Free[kSizeClassCount];
+	uint32_t Count[kSizeClassCount];
+
+	ThreadCache()
+		: Free(), Count()
+	{
+	}
+
+	~ThreadCache();
+};
+
+// Overflow allocations made while the frame arena was full
+struct FrameChunk
+{
+	FrameChunk *Next;
+};
+
+struct FrameArena
+{
+	uint8_t *Data;
+	size_t Capacity;
+	size_t Offset;
+
+	FrameChunk *Overflow;
+	size_t OverflowSize;
+	uint64_t OverflowCount;
+
+	uint64_t HeapAllocationMark;
+	MemoryFrameStats Stats;
+
+	FrameArena()
+		: Data(nullptr), Capacity(0), Offset(0), Overflow(nullptr), OverflowSize(0), OverflowCount(0), HeapAllocationMark(0), Stats()
+	{
+	}
+
+	~FrameArena();
+};
+
+// Counters for a single type, only ever written by the thread owning the table
+struct TypeCounters
+{
+	std::atomic<size_t> TypeHash; // 0 when unused
+	std::atomic<const char *> TypeName;
+	std::atomic<uint64_t> Allocations;
+	std::atomic<uint64_t> Frees;
+	std::atomic<uint64_t> AllocatedBytes;
+	std::atomic<uint64_t> FreedBytes;
+};
+
+struct TypeCounterTable
+{
+	TypeCounters Types[MEMORY_STATS_TYPES_MAX];
+
+	TypeCounterTable()
+		: Types()
+	{
+	}
+};
+
+struct ThreadStats : TypeCounterTable
+{
+	ThreadStats *Next;
+
+	ThreadStats();
+	~ThreadStats();
+};
+
+// Aggregated state, only touched while sampling
+struct TypeSample
+{
+	size_t TypeHash;
+	const char *TypeName;
+	uint64_t Allocations;
+	uint64_t Frees;
+	uint64_t AllocatedBytes;
+	uint64_t FreedBytes;
+	uint64_t LastAllocations;
+	uint64_t LastFrees;
+	uint64_t PeakBytes;
+	float AllocationRate;
+	float FreeRate;
 };
 
 uint64_t g_MemoryLimit;
-std::map<void *, Block> g_MemoryBlocks;
-uint64_t g_MemoryAllocated;
-std::mutex g_MemoryMutex;
+std::atomic<uint64_t> g_MemoryAllocated;
+std::atomic<uint64_t> g_MemoryPeak;
+std::atomic<uint64_t> g_MemoryBlockCount;
+MemoryPool g_MemoryPool;
+thread_local ThreadCache g_MemoryThreadCache;
+thread_local FrameArena g_MemoryFrameArena;
+
+std::mutex g_MemoryStatsMutex;
+ThreadStats *g_MemoryStatsThreads;
+TypeCounterTable g_MemoryStatsRetired; // Counters of threads that have exited
+thread_local ThreadStats g_MemoryThreadStats;
+thread_local uint64_t g_MemoryHeapAllocations; // Per thread, so workers are not charged to the frame of the main thread
+TypeSample g_MemoryStatsSamples[MEMORY_STATS_TYPES_MAX];
+std::chrono::steady_clock::time_point g_MemoryStatsLastSample;
+bool g_MemoryStatsSampled;
+
+static uint16_t getSizeClass(uint64_t size)
+{
+	for (uint16_t i = 0; i < kSizeClassCount; i++)
+	{
+		if (size <= kSizeClasses[i])
+			return i;
+	}
+
+	return MEMORY_LARGE_CLASS;
+}
+
+static size_t getBlockStride(uint16_t sizeClass)
+{
+	return sizeof(BlockHeader) + kSizeClasses[sizeClass];
+}
+
+// Must be called with the pool locked
+static void createSlab(uint16_t sizeClass)
+{
+	const auto stride = getBlockStride(sizeClass);
+	const auto count = static_cast<uint32_t>(MEMORY_SLAB_SIZE / stride);
+
+	const auto data = static_cast<uint8_t *>(malloc(stride * count));
+	if (!data)
+		THROW_EXCEPTION(OutOfMemoryException, "Unable to allocate slab for size class %u", kSizeClasses[sizeClass]);
+
+	auto &pool = g_MemoryPool.Classes[sizeClass];
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const auto header = reinterpret_cast<BlockHeader *>(data + stride * i);
+		header->Magic = MEMORY_BLOCK_MAGIC;
+		header->SizeClass = sizeClass;
+		header->State = kBlockState_Free;
+		header->Next = pool.Free;
+		pool.Free = header;
+	}
+	pool.FreeCount += count;
+
+	g_MemoryPool.Slabs.push_back({ data, sizeClass, count });
+}
+
+ThreadCache::~ThreadCache()
+{
+	// Give cached blocks back to the pool so other threads can use them
+	std::lock_guard<std::mutex> lock(g_MemoryPool.Mutex);
+	for (size_t i = 0; i < kSizeClassCount; i++)
+	{
+		auto &pool = g_MemoryPool.Classes[i];
+		while (Free[i])
+		{
+			const auto header = Free[i];
+			Free[i] = header->Next;
+			header->Next = pool.Free;
+			pool.Free = header;
+			pool.FreeCount++;
+		}
+		Count[i] = 0;
+	}
+}
+
+static BlockHeader *allocatePooled(uint16_t sizeClass)
+{
+	auto &cache = g_MemoryThreadCache;
+	if (!cache.Free[sizeClass])
+	{
+		// Refill from the shared pool, creating a new slab if it ran dry
+		std::lock_guard<std::mutex> lock(g_MemoryPool.Mutex);
+		auto &pool = g_MemoryPool.Classes[sizeClass];
+		if (!pool.Free)
+			createSlab(sizeClass);
+
+		for (auto i = 0; i < MEMORY_CACHE_REFILL && pool.Free; i++)
+		{
+			const auto header = pool.Free;
+			pool.Free = header->Next;
+			pool.FreeCount--;
+			header->Next = cache.Free[sizeClass];
+			cache.Free[sizeClass] = header;
+			cache.Count[sizeClass]++;
+		}
+	}
+
+	const auto header = cache.Free[sizeClass];
+	cache.Free[sizeClass] = header->Next;
+	cache.Count[sizeClass]--;
+	return header;
+}
+
+static void freePooled(BlockHeader *header)
+{
+	auto &cache = g_MemoryThreadCache;
+	const auto sizeClass = header->SizeClass;
+
+	header->Next = cache.Free[sizeClass];
+	cache.Free[sizeClass] = header;
+	cache.Count[sizeClass]++;
+
+	if (cache.Count[sizeClass] <= MEMORY_CACHE_MAX)
+		return;
+
+	// Return half of the cache to the shared pool
+	std::lock_guard<std::mutex> lock(g_MemoryPool.Mutex);
+	auto &pool = g_MemoryPool.Classes[sizeClass];
+	while (cache.Count[sizeClass] > MEMORY_CACHE_MAX / 2)
+	{
+		const auto block = cache.Free[sizeClass];
+		cache.Free[sizeClass] = block->Next;
+		cache.Count[sizeClass]--;
+		block->Next = pool.Free;
+		pool.Free = block;
+		pool.FreeCount++;
+	}
+}
+
+static BlockHeader *allocateLarge(uint64_t size)
+{
+	const auto header = static_cast<BlockHeader *>(malloc(sizeof(BlockHeader) + size));
+	if (!header)
+		THROW_EXCEPTION(OutOfMemoryException, "Unable to allocate %llu bytes", size);
+
+	header->Magic = MEMORY_BLOCK_MAGIC;
+	header->SizeClass = MEMORY_LARGE_CLASS;
+
+	// Link into live list so it can be dumped
+	std::lock_guard<std::mutex> lock(g_MemoryPool.Mutex);
+	header->Prev = nullptr;
+	header->Next = g_MemoryPool.Large;
+	if (g_MemoryPool.Large)
+		g_MemoryPool.Large->Prev = header;
+	g_MemoryPool.Large = header;
+
+	return header;
+}
+
+static void freeLarge(BlockHeader *header)
+{
+	{
+		std::lock_guard<std::mutex> lock(g_MemoryPool.Mutex);
+		if (header->Prev)
+			header->Prev->Next = header->Next;
+		else g_MemoryPool.Large = header->Next;
+		if (header->Next)
+			header->Next->Prev = header->Prev;
+	}
+
+	header->Magic = 0;
+	free(header);
+}
+
+static void freeFrameOverflow(FrameArena &arena)
+{
+	while (arena.Overflow)
+	{
+		const auto chunk = arena.Overflow;
+		arena.Overflow = chunk->Next;
+		free(chunk);
+	}
+
+	arena.OverflowSize = 0;
+	arena.OverflowCount = 0;
+}
+
+FrameArena::~FrameArena()
+{
+	freeFrameOverflow(*this);
+	free(Data);
+}
+
+static TypeCounters *findTypeCounters(TypeCounterTable &table, size_t hash, const char *name)
+{
+	// Linear probing, 0 is reserved for empty slots
+	if (hash == 0)
+		hash = 1;
+
+	auto index = hash % MEMORY_STATS_TYPES_MAX;
+	for (size_t i = 0; i < MEMORY_STATS_TYPES_MAX; i++)
+	{
+		auto &counters = table.Types[index];
+		const auto current = counters.TypeHash.load(std::memory_order_acquire);
+		if (current == hash)
+			return &counters;
+
+		if (current == 0)
+		{
+			counters.TypeName.store(name, std::memory_order_relaxed);
+			counters.TypeHash.store(hash, std::memory_order_release);
+			return &counters;
+		}
+
+		index = (index + 1) % MEMORY_STATS_TYPES_MAX;
+	}
+
+	// Table is full, type is not tracked
+	return nullptr;
+}
+
+static void addCounter(std::atomic<uint64_t> &counter, uint64_t value)
+{
+	// Single writer, so a plain load/store is enough for readers to see consistent values
+	counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+static void recordAllocation(size_t hash, const char *name, uint64_t size)
+{
+	const auto counters = findTypeCounters(g_MemoryThreadStats, hash, name);
+	if (!counters)
+		return;
+
+	addCounter(counters->Allocations, 1);
+	addCounter(counters->AllocatedBytes, size);
+}
+
+static void recordFree(size_t hash, const char *name, uint64_t size)
+{
+	const auto counters = findTypeCounters(g_MemoryThreadStats, hash, name);
+	if (!counters)
+		return;
+
+	addCounter(counters->Frees, 1);
+	addCounter(counters->FreedBytes, size);
+}
+
+ThreadStats::ThreadStats()
+	: Next(nullptr)
+{
+	std::lock_guard<std::mutex> lock(g_MemoryStatsMutex);
+	Next = g_MemoryStatsThreads;
+	g_MemoryStatsThreads = this;
+}
+
+ThreadStats::~ThreadStats()
+{
+	std::lock_guard<std::mutex> lock(g_MemoryStatsMutex);
+
+	// Keep counters of this thread around
+	for (auto &counters : Types)
+	{
+		const auto hash = counters.TypeHash.load(std::memory_order_relaxed);
+		if (hash == 0)
+			continue;
+
+		const auto retired = findTypeCounters(g_MemoryStatsRetired, hash, counters.TypeName.load(std::memory_order_relaxed));
+		if (!retired)
+			continue;
+
+		addCounter(retired->Allocations, counters.Allocations.load(std::memory_order_relaxed));
+		addCounter(retired->Frees, counters.Frees.load(std::memory_order_relaxed));
+		addCounter(retired->AllocatedBytes, counters.AllocatedBytes.load(std::memory_order_relaxed));
+		addCounter(retired->FreedBytes, counters.FreedBytes.load(std::memory_order_relaxed));
+	}
+
+	// Unregister
+	for (auto it = &g_MemoryStatsThreads; *it; it = &(*it)->Next)
+	{
+		if (*it == this)
+		{
+			*it = Next;
+			break;
+		}
+	}
+}
+
+// Must be called with the stats locked
+static void accumulateSamples(const TypeCounterTable &table)
+{
+	for (auto &counters : table.Types)
+	{
+		auto hash = counters.TypeHash.load(std::memory_order_acquire);
+		if (hash == 0)
+			continue;
+
+		auto index = hash % MEMORY_STATS_TYPES_MAX;
+		for (size_t i = 0; i < MEMORY_STATS_TYPES_MAX; i++)
+		{
+			auto &sample = g_MemoryStatsSamples[index];
+			if (sample.TypeHash == 0)
+			{
+				sample.TypeHash = hash;
+				sample.TypeName = counters.TypeName.load(std::memory_order_relaxed);
+			}
+
+			if (sample.TypeHash == hash)
+			{
+				sample.Allocations += counters.Allocations.load(std::memory_order_relaxed);
+				sample.Frees += counters.Frees.load(std::memory_order_relaxed);
+				sample.AllocatedBytes += counters.AllocatedBytes.load(std::memory_order_relaxed);
+				sample.FreedBytes += counters.FreedBytes.load(std::memory_order_relaxed);
+				break;
+			}
+
+			index = (index + 1) % MEMORY_STATS_TYPES_MAX;
+		}
+	}
+}
+
+static MemoryTypeStats getTypeStats(const TypeSample &sample)
+{
+	MemoryTypeStats stats;
+	stats.TypeName = sample.TypeName;
+	stats.TypeHash = sample.TypeHash;
+	stats.Allocations = sample.Allocations;
+	stats.Frees = sample.Frees;
+	stats.LiveBlocks = sample.Allocations > sample.Frees ? sample.Allocations - sample.Frees : 0;
+	stats.LiveBytes = sample.AllocatedBytes > sample.FreedBytes ? sample.AllocatedBytes - sample.FreedBytes : 0;
+	stats.PeakBytes = sample.PeakBytes;
+	stats.TotalBytes = sample.AllocatedBytes;
+	stats.AllocationRate = sample.AllocationRate;
+	stats.FreeRate = sample.FreeRate;
+	return stats;
+}
 
 void MemoryInitialize(uint64_t limit)
 {
@@ -24,62 +492,325 @@ void MemoryInitialize(uint64_t limit)
 void MemoryShutdown()
 {
 	// If there's still memory allocated there's an issue
-	if (!g_MemoryBlocks.empty())
-		THROW_EXCEPTION(MemoryLeakException, "Memory leak detected (%u blocks, %llu/%llu)", g_MemoryBlocks.size(), g_MemoryAllocated, g_MemoryLimit);
+	const auto blocks = g_MemoryBlockCount.load();
+	if (blocks != 0)
+		THROW_EXCEPTION(MemoryLeakException, "Memory leak detected (%llu blocks, %llu/%llu)", blocks, g_MemoryAllocated.load(), g_MemoryLimit);
 }
 
 void MemoryDebug()
 {
-	LOG_TRACE("Memory", "Dumping allocated memory (%d blocks, %llu/%llu)", g_MemoryBlocks.size(), g_MemoryAllocated, g_MemoryLimit);
-	g_MemoryMutex.lock();
-	for (auto &pair : g_MemoryBlocks)
+	LOG_TRACE("Memory", "Dumping allocated memory (%llu blocks, %llu/%llu)", g_MemoryBlockCount.load(), g_MemoryAllocated.load(), g_MemoryLimit);
+	g_MemoryPool.Mutex.lock();
+	for (auto &slab : g_MemoryPool.Slabs)
+	{
+		const auto stride = getBlockStride(slab.SizeClass);
+		for (uint32_t i = 0; i < slab.BlockCount; i++)
+		{
+			const auto region = reinterpret_cast<BlockHeader *>(slab.Data + stride * i);
+			if (region->State == kBlockState_Allocated)
+				LOG_TRACE("Memory", "- Block 0x%X of size %llu and type \"%s\" (%u)", region + 1, region->Size, region->TypeName, region->TypeHash);
+		}
+	}
+	for (auto region = g_MemoryPool.Large; region; region = region->Next)
+		LOG_TRACE("Memory", "- Block 0x%X of size %llu and type \"%s\" (%u)", region + 1, region->Size, region->TypeName, region->TypeHash);
+	g_MemoryPool.Mutex.unlock();
+
+	const auto &stats = g_MemoryFrameArena.Stats;
+	LOG_TRACE("Memory", "Last frame: %llu heap allocations, %llu/%llu frame bytes, %llu frame overflows", 
+		stats.HeapAllocations, stats.ArenaUsed, stats.ArenaCapacity, stats.ArenaOverflows);
+
+	// Dump live types
+	MemorySampleStats();
+	for (const auto &type : MemoryGetStats().Types)
 	{
-		const auto &region = pair.second;
-		LOG_TRACE("Memory", "- Block 0x%X of size %llu and type \"%s\" (%u)", pair.first, region.Size, region.TypeName.c_str(), region.TypeHash);
+		if (type.LiveBlocks)
+			LOG_TRACE("Memory", "- Type \"%s\": %llu live blocks, %llu bytes (peak %llu)", type.TypeName, type.LiveBlocks, type.LiveBytes, type.PeakBytes);
 	}
-	g_MemoryMutex.unlock();
 }
 
-void *MemoryAllocate(const std::string &name, size_t hash, uint64_t size)
+void *MemoryAllocate(const char *name, size_t hash, uint64_t size)
 {
-	g_MemoryMutex.lock();
-
 	// Check if we would be out of memory due to this allocation
-	if (g_MemoryLimit != 0 && g_MemoryAllocated + size > g_MemoryLimit)
+	const auto allocated = g_MemoryAllocated.fetch_add(size, std::memory_order_relaxed) + size;
+	if (g_MemoryLimit != 0 && allocated > g_MemoryLimit)
 	{
-		g_MemoryMutex.unlock();
-		THROW_EXCEPTION(OutOfMemoryException, "Out of memory (%llu/%llu)", g_MemoryAllocated, g_MemoryLimit);
+		g_MemoryAllocated.fetch_sub(size, std::memory_order_relaxed);
+		THROW_EXCEPTION(OutOfMemoryException, "Out of memory (%llu/%llu)", allocated - size, g_MemoryLimit);
 	}
 
-	// Allocate memory and store region
-	const auto ptr = malloc(size);
-	memset(ptr, 0, size);
+	// Update peak
+	auto peak = g_MemoryPeak.load(std::memory_order_relaxed);
+	while (allocated > peak && !g_MemoryPeak.compare_exchange_weak(peak, allocated, std::memory_order_relaxed))
+	{
+	}
+
+	// Allocate memory and store block info
+	const auto sizeClass = getSizeClass(size);
+	const auto header = sizeClass == MEMORY_LARGE_CLASS ? allocateLarge(size) : allocatePooled(sizeClass);
+	header->TypeName = name;
+	header->TypeHash = hash;
+	header->Size = size;
+	header->State = kBlockState_Allocated;
+
+	g_MemoryBlockCount.fetch_add(1, std::memory_order_relaxed);
+	g_MemoryHeapAllocations++;
+	recordAllocation(hash, name, size);
 
-	g_MemoryAllocated += size;
-	g_MemoryBlocks.insert({ ptr, { name, hash, size, ptr } });
-	g_MemoryMutex.unlock();
+	const auto ptr = header + 1;
+	memset(ptr, 0, size);
 
 	return ptr;
 }
 
 void MemoryFree(void *ptr)
 {
-	g_MemoryMutex.lock();
+	// Find block
+	const auto header = ptr ? static_cast<BlockHeader *>(ptr) - 1 : nullptr;
+	if (!header || header->Magic != MEMORY_BLOCK_MAGIC || header->State != kBlockState_Allocated)
+		THROW_EXCEPTION(UnknownMemoryException, "Unknown memory block 0x%X", ptr);
 
-	// Find region
-	std::map<void *, Block>::iterator it;
-	if ((it = g_MemoryBlocks.find(ptr)) == g_MemoryBlocks.end())
+	// Free memory and block
+	g_MemoryAllocated.fetch_sub(header->Size, std::memory_order_relaxed);
+	g_MemoryBlockCount.fetch_sub(1, std::memory_order_relaxed);
+	recordFree(header->TypeHash, header->TypeName, header->Size);
+
+	header->State = kBlockState_Free;
+	if (header->SizeClass == MEMORY_LARGE_CLASS)
+		freeLarge(header);
+	else freePooled(header);
+}
+
+void MemorySampleStats()
+{
+	std::lock_guard<std::mutex> lock(g_MemoryStatsMutex);
+
+	// Sum counters of all threads
+	for (auto &sample : g_MemoryStatsSamples)
 	{
-		g_MemoryMutex.unlock();
-		THROW_EXCEPTION(UnknownMemoryException, "Unknown memory block 0x%X", ptr);
+		sample.Allocations = 0;
+		sample.Frees = 0;
+		sample.AllocatedBytes = 0;
+		sample.FreedBytes = 0;
 	}
 
-	// Free memory and region region
-	free(ptr);
+	accumulateSamples(g_MemoryStatsRetired);
+	for (auto stats = g_MemoryStatsThreads; stats; stats = stats->Next)
+		accumulateSamples(*stats);
+
+	// Update peaks and rates
+	const auto now = std::chrono::steady_clock::now();
+	const auto elapsed = g_MemoryStatsSampled ? std::chrono::duration<float>(now - g_MemoryStatsLastSample).count() : 0.0f;
+	for (auto &sample : g_MemoryStatsSamples)
+	{
+		if (sample.TypeHash == 0)
+			continue;
+
+		const auto liveBytes = sample.AllocatedBytes > sample.FreedBytes ? sample.AllocatedBytes - sample.FreedBytes : 0;
+		sample.PeakBytes = std::max(sample.PeakBytes, liveBytes);
 
-	const auto &region = it->second;
-	g_MemoryAllocated -= region.Size;
-	g_MemoryBlocks.erase(it);
+		if (elapsed > 0.0f)
+		{
+			sample.AllocationRate = static_cast<float>(sample.Allocations - sample.LastAllocations) / elapsed;
+			sample.FreeRate = static_cast<float>(sample.Frees - sample.LastFrees) / elapsed;
+		}
 
-	g_MemoryMutex.unlock();
-}
\ No newline at end of file
+		sample.LastAllocations = sample.Allocations;
+		sample.LastFrees = sample.Frees;
+	}
+
+	g_MemoryStatsLastSample = now;
+	g_MemoryStatsSampled = true;
+}
+
+MemoryStats MemoryGetStats()
+{
+	MemoryStats stats;
+	stats.Allocated = g_MemoryAllocated.load(std::memory_order_relaxed);
+	stats.Peak = g_MemoryPeak.load(std::memory_order_relaxed);
+	stats.Limit = g_MemoryLimit;
+	stats.Blocks = g_MemoryBlockCount.load(std::memory_order_relaxed);
+
+	{
+		std::lock_guard<std::mutex> lock(g_MemoryStatsMutex);
+		for (const auto &sample : g_MemoryStatsSamples)
+		{
+			if (sample.TypeHash != 0)
+				stats.Types.push_back(getTypeStats(sample));
+		}
+	}
+
+	std::sort(stats.Types.begin(), stats.Types.end(), [](const MemoryTypeStats &a, const MemoryTypeStats &b)
+	{
+		return a.LiveBytes > b.LiveBytes;
+	});
+
+	return stats;
+}
+
+static void writeQuoted(std::ostream &stream, const char *str, bool json)
+{
+	// JSON escapes with a backslash, CSV doubles the quote
+	stream << '"';
+	for (; *str; str++)
+	{
+		if (*str == '"')
+			stream << (json ? '\\' : '"');
+		else if (json && *str == '\\')
+			stream << '\\';
+		stream << *str;
+	}
+	stream << '"';
+}
+
+void MemoryDumpStats(const std::string &path)
+{
+	if (!g_MemoryStatsSampled)
+		MemorySampleStats();
+
+	const auto stats = MemoryGetStats();
+
+	std::ofstream file(path, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+	{
+		LOG_ERROR("Memory", "Unable to write memory stats to %s", path.c_str());
+		return;
+	}
+
+	const auto json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+	if (json)
+	{
+		file << "{\n";
+		file << "\t\"allocated\": " << stats.Allocated << ",\n";
+		file << "\t\"peak\": " << stats.Peak << ",\n";
+		file << "\t\"limit\": " << stats.Limit << ",\n";
+		file << "\t\"blocks\": " << stats.Blocks << ",\n";
+		file << "\t\"types\": [";
+		for (size_t i = 0; i < stats.Types.size(); i++)
+		{
+			const auto &type = stats.Types[i];
+			file << (i ? ",\n" : "\n") << "\t\t{ \"name\": ";
+			writeQuoted(file, type.TypeName, true);
+			file << ", \"hash\": " << type.TypeHash
+				<< ", \"allocations\": " << type.Allocations
+				<< ", \"frees\": " << type.Frees
+				<< ", \"liveBlocks\": " << type.LiveBlocks
+				<< ", \"liveBytes\": " << type.LiveBytes
+				<< ", \"peakBytes\": " << type.PeakBytes
+				<< ", \"totalBytes\": " << type.TotalBytes
+				<< ", \"allocationRate\": " << type.AllocationRate
+				<< ", \"freeRate\": " << type.FreeRate << " }";
+		}
+		file << "\n\t]\n}\n";
+	}
+	else
+	{
+		file << "Type,Hash,Allocations,Frees,LiveBlocks,LiveBytes,PeakBytes,TotalBytes,AllocationRate,FreeRate\n";
+		for (const auto &type : stats.Types)
+		{
+			writeQuoted(file, type.TypeName, false);
+			file << "," << type.TypeHash << "," << type.Allocations << "," << type.Frees << "," << type.LiveBlocks << ","
+				<< type.LiveBytes << "," << type.PeakBytes << "," << type.TotalBytes << "," << type.AllocationRate << "," << type.FreeRate << "\n";
+		}
+	}
+
+	LOG_INFO("Memory", "Wrote memory stats for %u types to %s", stats.Types.size(), path.c_str());
+}
+
+void *MemoryFrameAllocate(size_t size, size_t alignment)
+{
+	auto &arena = g_MemoryFrameArena;
+	if (!arena.Data)
+	{
+		arena.Data = static_cast<uint8_t *>(malloc(MEMORY_FRAME_SIZE));
+		if (!arena.Data)
+			THROW_EXCEPTION(OutOfMemoryException, "Unable to allocate frame arena");
+		arena.Capacity = MEMORY_FRAME_SIZE;
+	}
+
+	// Bump allocate from the arena
+	const auto base = reinterpret_cast<uintptr_t>(arena.Data);
+	const auto start = (base + arena.Offset + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+	if (start + size <= base + arena.Capacity)
+	{
+		arena.Offset = start + size - base;
+		return reinterpret_cast<void *>(start);
+	}
+
+	// Arena is full, use a separate chunk for the rest of the frame and grow on reset
+	const auto chunkSize = sizeof(FrameChunk) + size + alignment;
+	const auto chunk = static_cast<FrameChunk *>(malloc(chunkSize));
+	if (!chunk)
+		THROW_EXCEPTION(OutOfMemoryException, "Unable to allocate %llu frame bytes", static_cast<uint64_t>(size));
+
+	chunk->Next = arena.Overflow;
+	arena.Overflow = chunk;
+	arena.OverflowSize += chunkSize;
+	arena.OverflowCount++;
+	g_MemoryHeapAllocations++;
+
+	const auto chunkData = reinterpret_cast<uintptr_t>(chunk + 1);
+	return reinterpret_cast<void *>((chunkData + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+}
+
+const char *MemoryFrameFormat(const char *format, ...)
+{
+	va_list arguments;
+	va_start(arguments, format);
+
+	const auto length = _vscprintf(format, arguments) + 1;
+	const auto result = static_cast<char *>(MemoryFrameAllocate(length, 1));
+	vsprintf_s(result, length, format, arguments);
+
+	va_end(arguments);
+
+	return result;
+}
+
+void MemoryFrameReset()
+{
+	auto &arena = g_MemoryFrameArena;
+
+	// Store stats for the frame that just ended
+	arena.Stats.HeapAllocations = g_MemoryHeapAllocations - arena.HeapAllocationMark;
+	arena.Stats.ArenaUsed = arena.Offset + arena.OverflowSize;
+	arena.Stats.ArenaCapacity = arena.Capacity;
+	arena.Stats.ArenaOverflows = arena.OverflowCount;
+
+	// Grow the arena so the next frame fits
+	if (arena.Overflow)
+	{
+		const auto capacity = arena.Capacity + arena.OverflowSize;
+		freeFrameOverflow(arena);
+
+		free(arena.Data);
+		arena.Data = static_cast<uint8_t *>(malloc(capacity));
+		if (!arena.Data)
+			THROW_EXCEPTION(OutOfMemoryException, "Unable to grow frame arena to %llu bytes", static_cast<uint64_t>(capacity));
+		arena.Capacity = capacity;
+	}
+
+	arena.Offset = 0;
+	arena.HeapAllocationMark = g_MemoryHeapAllocations;
+}
+
+MemoryFrameStats MemoryGetFrameStats()
+{
+	return g_MemoryFrameArena.Stats;
+}
+
+// Count every heap allocation so frame stats also catch STL containers
+void *operator new(size_t size)
+{
+	g_MemoryHeapAllocations++;
+
+	const auto ptr = malloc(size ? size : 1);
+	if (!ptr)
+		throw std::bad_alloc();
+
+	return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+	free(ptr);
+}
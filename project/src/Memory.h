@@ -3,11 +3,32 @@
 #include "Utility/Exception.h"
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #ifndef MEMORY_DEFAULT_LIMIT
 #define MEMORY_DEFAULT_LIMIT (1024 * 1024 * 1024) // 1GB
 #endif
 
+#ifndef MEMORY_SLAB_SIZE
+#define MEMORY_SLAB_SIZE (64 * 1024) // Size of each size class slab
+#endif
+
+#ifndef MEMORY_CACHE_REFILL
+#define MEMORY_CACHE_REFILL 32 // Blocks moved into a thread cache at once
+#endif
+
+#ifndef MEMORY_CACHE_MAX
+#define MEMORY_CACHE_MAX 256 // Blocks a thread cache holds per size class before returning half
+#endif
+
+#ifndef MEMORY_STATS_TYPES_MAX
+#define MEMORY_STATS_TYPES_MAX 1024 // Distinct types tracked by allocation statistics
+#endif
+
+#ifndef MEMORY_FRAME_SIZE
+#define MEMORY_FRAME_SIZE (256 * 1024) // Initial size of each thread's frame arena
+#endif
+
 DEFINE_EXCEPTION(OutOfMemoryException);
 DEFINE_EXCEPTION(UnknownMemoryException);
 DEFINE_EXCEPTION(MemoryLeakException);
@@ -17,11 +38,12 @@ void MemoryShutdown();
 
 void MemoryDebug();
 
-void *MemoryAllocate(const std::string &name, size_t hash, uint64_t size);
+// NOTE: name must outlive the allocation (typeid names do)
+void *MemoryAllocate(const char *name, size_t hash, uint64_t size);
 void MemoryFree(void *ptr);
 
 template<typename T>
-static T *MemoryAllocate(const std::string &name, size_t hash, size_t count = 1)
+static T *MemoryAllocate(const char *name, size_t hash, size_t count = 1)
 {
 	return static_cast<T *>(MemoryAllocate(name, hash, sizeof(T) * count));
 }
@@ -32,6 +54,87 @@ static void MemoryFree(T *ptr)
 	MemoryFree(static_cast<void *>(ptr));
 }
 
+struct MemoryTypeStats
+{
+	const char *TypeName;
+	size_t TypeHash;
+	uint64_t Allocations;
+	uint64_t Frees;
+	uint64_t LiveBlocks;
+	uint64_t LiveBytes;
+	uint64_t PeakBytes; // Highest live bytes seen when sampled
+	uint64_t TotalBytes;
+	float AllocationRate; // Per second, since the previous sample
+	float FreeRate;
+};
+
+struct MemoryStats
+{
+	uint64_t Allocated;
+	uint64_t Peak;
+	uint64_t Limit;
+	uint64_t Blocks;
+	std::vector<MemoryTypeStats> Types; // Sorted by live bytes
+};
+
+// Allocation statistics, aggregated from per thread counters when sampled
+void MemorySampleStats();
+MemoryStats MemoryGetStats();
+void MemoryDumpStats(const std::string &path); // CSV, or JSON if the path ends in .json
+
+struct MemoryFrameStats
+{
+	uint64_t HeapAllocations; // Heap allocations made by the calling thread during its last frame
+	uint64_t ArenaUsed; // Frame arena bytes used during the last frame
+	uint64_t ArenaCapacity;
+	uint64_t ArenaOverflows; // Frame allocations that did not fit in the arena
+};
+
+// Frame memory, valid until the next MemoryFrameReset on the same thread
+void *MemoryFrameAllocate(size_t size, size_t alignment = 16);
+const char *MemoryFrameFormat(const char *format, ...);
+void MemoryFrameReset();
+MemoryFrameStats MemoryGetFrameStats();
+
+// STL allocator backed by the frame arena, deallocation is a no-op
+template<typename T>
+class FrameAllocator
+{
+public:
+	typedef T value_type;
+
+	FrameAllocator() = default;
+
+	template<typename U>
+	FrameAllocator(const FrameAllocator<U> &)
+	{
+	}
+
+	T *allocate(size_t count)
+	{
+		return static_cast<T *>(MemoryFrameAllocate(sizeof(T) * count, alignof(T)));
+	}
+
+	void deallocate(T *, size_t)
+	{
+	}
+
+	template<typename U>
+	bool operator==(const FrameAllocator<U> &) const
+	{
+		return true;
+	}
+
+	template<typename U>
+	bool operator!=(const FrameAllocator<U> &) const
+	{
+		return false;
+	}
+};
+
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
 #define MEM_ALLOC(type) MemoryAllocate<type>(typeid(type).name(), typeid(type).hash_code())
 #define MEM_ALLOC_ARRAY(type, count) MemoryAllocate<type>(typeid(type).name(), typeid(type).hash_code(), count)
 #define MEM_DELETE(ptr) MemoryFree(ptr)
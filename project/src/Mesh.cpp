@@ -14,4 +14,15 @@ MeshVertex::MeshVertex(glm::vec3 p, glm::vec3 n, glm::vec2 t)
 Mesh::Mesh(std::string name, std::vector<MeshVertex> vertices, std::vector<unsigned> indices, Material *material)
 	: IMesh(std::move(name), std::move(vertices), std::move(indices), material)
 {
+}
+
+Mesh::Mesh(std::string name, const MeshVertex *vertices, unsigned vertexCount, const unsigned *indices, unsigned indexCount, 
+	const BoundingBox &bounds, Material *material)
+	: IMesh(std::move(name), vertices, vertexCount, indices, indexCount, bounds, material)
+{
+}
+
+Mesh::Mesh(std::string name, MeshGeometry *geometry, Material *material)
+	: IMesh(std::move(name), geometry, material)
+{
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "Vertex.h"
 #include "Material.h"
 #include "Node.h"
+#include "RenderQueue.h"
 #include <glm/glm.hpp>
 
 struct MeshVertex
@@ -28,13 +29,17 @@ public:
 	}
 };
 
-// TODO: Add ability to change material for meshes
+// Vertex and index buffers of one mesh, shared by every mesh drawing the same geometry.
+// Reference counted, deleted when the last reference is released. Not thread safe
+// TVertex must have a glm::vec3 Position
 template<typename TVertex, typename TVertexFormat>
-class IMesh : public Node
+class IMeshGeometry
 {
 	std::vector<TVertex> m_Vertices;
 	std::vector<unsigned int> m_Indices;
-	Material *m_Material;
+	unsigned int m_IndexCount;
+	BoundingBox m_Bounds;
+	unsigned int m_References;
 
 	TVertexFormat m_VertexFormat;
 	VertexArray *m_VertexArray; // VAO
@@ -42,15 +47,128 @@ class IMesh : public Node
 	IndexBuffer m_IndexBuffer; // EBO
 
 public:
-	IMesh(std::string name, std::vector<TVertex> vertices, std::vector<unsigned int> indices, Material *material)
-		: Node(name), m_Vertices(std::move(vertices)), m_Indices(std::move(indices)),
-		m_Material(material), m_VertexFormat(), m_VertexArray(m_VertexFormat.GetArray()),
+	IMeshGeometry(std::vector<TVertex> vertices, std::vector<unsigned int> indices)
+		: m_Vertices(std::move(vertices)), m_Indices(std::move(indices)), m_IndexCount(m_Indices.size()), m_References(0),
+		m_VertexFormat(), m_VertexArray(m_VertexFormat.GetArray()),
 		m_VertexBuffer(m_VertexArray, m_Vertices.data(), m_Vertices.size()),
 		m_IndexBuffer(m_Indices.data(), m_Indices.size())
 	{
+		// Computed once at load, the vertices never change
+		for (const auto &v : m_Vertices)
+			m_Bounds.Add(v.Position);
+	}
+
+	// Uploads from memory the geometry does not keep, such as a mapped model cache.
+	// GetVertices and GetIndices are empty for these
+	IMeshGeometry(const TVertex *vertices, unsigned int vertexCount, const unsigned int *indices, unsigned int indexCount,
+		const BoundingBox &bounds)
+		: m_IndexCount(indexCount), m_Bounds(bounds), m_References(0), m_VertexFormat(), 
+		m_VertexArray(m_VertexFormat.GetArray()), m_VertexBuffer(m_VertexArray, vertices, vertexCount),
+		m_IndexBuffer(indices, indexCount)
+	{
+	}
+
+	// Use Release instead
+	~IMeshGeometry() = default;
+
+	// No copying/moving
+	IMeshGeometry(const IMeshGeometry &) = delete;
+	IMeshGeometry &operator=(const IMeshGeometry &) = delete;
+
+	IMeshGeometry(const IMeshGeometry &&) = delete;
+	IMeshGeometry &operator=(const IMeshGeometry &&) = delete;
+
+	void AddReference()
+	{
+		m_References++;
+	}
+
+	void Release()
+	{
+		if (--m_References == 0)
+			Delete(this);
+	}
+
+	unsigned int GetReferenceCount() const
+	{
+		return m_References;
+	}
+
+	// Bounds of the vertices
+	const BoundingBox &GetBounds() const
+	{
+		return m_Bounds;
+	}
+
+	const std::vector<TVertex> &GetVertices() const
+	{
+		return m_Vertices;
+	}
+
+	const std::vector<unsigned int> &GetIndices() const
+	{
+		return m_Indices;
+	}
+
+	unsigned int GetIndexCount() const
+	{
+		return m_IndexCount;
+	}
+
+	VertexArray *GetVertexArray() const
+	{
+		return m_VertexArray;
 	}
 
-	~IMesh() = default;
+	VertexBuffer<TVertex> *GetVertexBuffer()
+	{
+		return &m_VertexBuffer;
+	}
+
+	IndexBuffer *GetIndexBuffer()
+	{
+		return &m_IndexBuffer;
+	}
+};
+
+// TODO: Add ability to change material for meshes
+template<typename TVertex, typename TVertexFormat>
+class IMesh : public Node
+{
+public:
+	typedef IMeshGeometry<TVertex, TVertexFormat> Geometry;
+
+private:
+	Geometry *m_Geometry;
+	Material *m_Material;
+
+public:
+	IMesh(std::string name, std::vector<TVertex> vertices, std::vector<unsigned int> indices, Material *material)
+		: Node(name), m_Geometry(New<Geometry>(std::move(vertices), std::move(indices))), m_Material(material)
+	{
+		m_Geometry->AddReference();
+	}
+
+	// Uploads from memory the mesh does not keep, such as a mapped model cache.
+	// GetVertices and GetIndices are empty for these meshes
+	IMesh(std::string name, const TVertex *vertices, unsigned int vertexCount, const unsigned int *indices, unsigned int indexCount,
+		const BoundingBox &bounds, Material *material)
+		: Node(name), m_Geometry(New<Geometry>(vertices, vertexCount, indices, indexCount, bounds)), m_Material(material)
+	{
+		m_Geometry->AddReference();
+	}
+
+	// Draws geometry shared with other meshes
+	IMesh(std::string name, Geometry *geometry, Material *material)
+		: Node(name), m_Geometry(geometry), m_Material(material)
+	{
+		m_Geometry->AddReference();
+	}
+
+	~IMesh()
+	{
+		m_Geometry->Release();
+	}
 
 	// No copying/moving
 	IMesh(const IMesh &) = delete;
@@ -64,6 +182,32 @@ public:
 		return m_Material;
 	}
 
+	Geometry *GetGeometry() const
+	{
+		return m_Geometry;
+	}
+
+	// Bounds of the vertices
+	const BoundingBox &GetBounds() const
+	{
+		return m_Geometry->GetBounds();
+	}
+
+	const std::vector<TVertex> &GetVertices() const
+	{
+		return m_Geometry->GetVertices();
+	}
+
+	const std::vector<unsigned int> &GetIndices() const
+	{
+		return m_Geometry->GetIndices();
+	}
+
+	unsigned int GetIndexCount() const
+	{
+		return m_Geometry->GetIndexCount();
+	}
+
 	// TODO: Implement?
 	// Use with caution! Memory here is unmanaged
 	// we need a way to store the material in the 
@@ -82,31 +226,135 @@ public:
 
 	void Render(RenderContext *context) override
 	{
-		// Apply material
-		m_Material->Apply();
+		// Queue draw, the camera submits it sorted by state
+		context->Queue->Add(m_Material, m_Geometry->GetVertexArray(), m_Geometry->GetVertexBuffer(), m_Geometry->GetIndexBuffer(), 
+			m_Geometry->GetIndexCount(), context->TransformMatrix);
+		// TODO: create buffers through buffermanager
 
-		// Apply transform
-		const auto shader = m_Material->GetShader();
-		shader->GetVariable(kShaderVar_Transform)->SetMat4(context->TransformMatrix);
+		// Call render for all children
+		Node::Render(context);
+	}
+};
 
-		// Bind arrays
-		context->GraphicsManager->Bind(m_VertexArray);
-		context->GraphicsManager->Bind<TVertex>(&m_VertexBuffer);
-		context->GraphicsManager->Bind(&m_IndexBuffer);
+// Renders all instances with a single draw call, the material shader
+// must read the instance attributes following the vertex attributes
+template<typename TVertex, typename TInstance, typename TVertexFormat>
+class IInstancedMesh : public Node
+{
+	std::vector<TVertex> m_Vertices;
+	std::vector<unsigned int> m_Indices;
+	std::vector<TInstance> m_Instances;
+	Material *m_Material;
+	bool m_InstancesDirty;
+	BoundingBox m_Bounds; // Of all instances, empty if unknown
 
-		// Render
-		glDrawElements(GL_TRIANGLES, m_Indices.size(), GL_UNSIGNED_INT, nullptr); // TODO: Move these to graphics manager, along with buffers, etc.
-		// TODO: create buffers through buffermanager
+	TVertexFormat m_VertexFormat;
+	VertexArray *m_VertexArray; // VAO
+	VertexBuffer<TVertex> m_VertexBuffer; // VBO
+	IndexBuffer m_IndexBuffer; // EBO
+	InstanceBuffer<TInstance> m_InstanceBuffer;
+
+public:
+	IInstancedMesh(std::string name, std::vector<TVertex> vertices, std::vector<unsigned int> indices, std::vector<TInstance> instances, Material *material,
+		Buffer::Usage instanceUsage = Buffer::kUsage_DynamicDraw)
+		: Node(name), m_Vertices(std::move(vertices)), m_Indices(std::move(indices)), m_Instances(std::move(instances)),
+		m_Material(material), m_InstancesDirty(false), m_VertexFormat(), m_VertexArray(m_VertexFormat.GetArray()),
+		m_VertexBuffer(m_VertexArray, m_Vertices.data(), m_Vertices.size()),
+		m_IndexBuffer(m_Indices.data(), m_Indices.size()),
+		m_InstanceBuffer(m_VertexArray, m_Instances.data(), m_Instances.size(), instanceUsage)
+	{
+	}
+
+	~IInstancedMesh() = default;
+
+	// No copying/moving
+	IInstancedMesh(const IInstancedMesh &) = delete;
+	IInstancedMesh &operator=(const IInstancedMesh &) = delete;
+
+	IInstancedMesh(const IInstancedMesh &&) = delete;
+	IInstancedMesh &operator=(const IInstancedMesh &&) = delete;
+
+	Material *GetMaterial() const
+	{
+		return m_Material;
+	}
+
+	unsigned int GetInstanceCount() const
+	{
+		return m_Instances.size();
+	}
+
+	const TInstance &GetInstance(unsigned int index) const
+	{
+		return m_Instances[index];
+	}
+
+	void SetInstance(unsigned int index, const TInstance &instance)
+	{
+		m_Instances[index] = instance;
+		m_InstancesDirty = true;
+	}
+
+	// Direct access for bulk updates, call Invalidate when done
+	TInstance *GetInstances()
+	{
+		return m_Instances.data();
+	}
+
+	void Invalidate()
+	{
+		m_InstancesDirty = true;
+	}
+
+	// Instances are interpreted by the shader, so bounds must be given by the owner.
+	// Without bounds the mesh is never culled
+	void SetBounds(const BoundingBox &bounds)
+	{
+		m_Bounds = bounds;
+	}
+
+	NodeBoundsType GetLocalBounds(BoundingBox &bounds) const override
+	{
+		if (m_Bounds.IsEmpty())
+			return kNodeBoundsType_Infinite;
+
+		bounds = m_Bounds;
+		return kNodeBoundsType_Box;
+	}
+
+	void Compile() override
+	{
+		// Call compile for all children
+		Node::Compile();
+	}
+
+	void Render(RenderContext *context) override
+	{
+		// Upload instances changed since the last frame
+		if (m_InstancesDirty)
+		{
+			m_InstanceBuffer.SetData(0, m_Instances.size(), m_Instances.data());
+			m_InstancesDirty = false;
+		}
+
+		// Queue draw, instance transforms are relative to this node
+		context->Queue->Add(m_Material, m_VertexArray, &m_VertexBuffer, &m_IndexBuffer, m_Indices.size(), 
+			&m_InstanceBuffer, m_Instances.size(), m_Transform.GetMatrix());
 
 		// Call render for all children
 		Node::Render(context);
 	}
 };
 
+typedef IMeshGeometry<MeshVertex, MeshVertexFormat> MeshGeometry;
+
 class Mesh : public IMesh<MeshVertex, MeshVertexFormat>
 {
 public:
 	Mesh(std::string name, std::vector<MeshVertex> vertices, std::vector<unsigned int> indices, Material *material = nullptr);
+	Mesh(std::string name, const MeshVertex *vertices, unsigned int vertexCount, const unsigned int *indices, unsigned int indexCount,
+		const BoundingBox &bounds, Material *material = nullptr);
+	Mesh(std::string name, MeshGeometry *geometry, Material *material = nullptr);
 	~Mesh() = default;
 
 	// No copying/moving
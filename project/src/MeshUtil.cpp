@@ -0,0 +1,142 @@
+#include "MeshUtil.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+#define MESH_SIMPLIFY_RESOLUTION_MAX 1024 // Grid cells along the longest axis
+#define MESH_SIMPLIFY_ITERATIONS 10 // Steps of the search for the grid resolution
+#define MESH_SIMPLIFY_UV_CELLS 8 // Texture coordinate cells per unit, vertices on both sides of a UV seam land in different ones
+#define MESH_SIMPLIFY_UV_BITS 13 // Per texture coordinate in the cluster key, cells further out are clamped
+
+// Cell of a texture coordinate, offset to be positive within the key bits
+static uint64_t getTexCoordCell(float texCoord)
+{
+	const auto limit = static_cast<float>(1 << (MESH_SIMPLIFY_UV_BITS - 1));
+	const auto cell = glm::clamp(std::floor(texCoord * MESH_SIMPLIFY_UV_CELLS), -limit, limit - 1.0f);
+	return static_cast<uint64_t>(cell + limit);
+}
+
+// Clusters vertices on a grid with the given number of cells along the longest axis,
+// split by texture coordinates so seams are kept. Returns the number of triangles left
+static unsigned int clusterVertices(const std::vector<MeshVertex> &vertices, const std::vector<unsigned int> &indices,
+	const BoundingBox &bounds, unsigned int resolution, std::vector<unsigned int> &outRemap, std::vector<unsigned int> &outIndices)
+{
+	const auto size = bounds.Max - bounds.Min;
+	const auto cellSize = (std::max)((std::max)(size.x, size.y), size.z) / resolution;
+	const auto cells = glm::max(glm::uvec3(glm::ceil(size / cellSize)), glm::uvec3(1));
+
+	std::unordered_map<uint64_t, unsigned int> cellClusters;
+	std::vector<glm::vec3> sums;
+	std::vector<unsigned int> counts;
+
+	// Assign every vertex to the cluster of its cell
+	std::vector<unsigned int> vertexClusters(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		const auto cell = glm::min(glm::uvec3((vertices[i].Position - bounds.Min) / cellSize), cells - 1u);
+		auto key = cell.x + static_cast<uint64_t>(cells.x) * (cell.y + static_cast<uint64_t>(cells.y) * cell.z);
+		key = (key << MESH_SIMPLIFY_UV_BITS | getTexCoordCell(vertices[i].TexCoords.x)) << MESH_SIMPLIFY_UV_BITS
+			| getTexCoordCell(vertices[i].TexCoords.y);
+
+		const auto it = cellClusters.emplace(key, static_cast<unsigned int>(sums.size()));
+		if (it.second)
+		{
+			sums.emplace_back(0.0f);
+			counts.push_back(0);
+		}
+
+		const auto cluster = it.first->second;
+		sums[cluster] += vertices[i].Position;
+		counts[cluster]++;
+		vertexClusters[i] = cluster;
+	}
+
+	// Pick the member closest to the average as representative
+	std::vector<float> distances(sums.size(), INFINITY);
+	outRemap.assign(sums.size(), 0);
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		const auto cluster = vertexClusters[i];
+		const auto delta = vertices[i].Position - sums[cluster] / static_cast<float>(counts[cluster]);
+		const auto distance = glm::dot(delta, delta);
+		if (distance < distances[cluster])
+		{
+			distances[cluster] = distance;
+			outRemap[cluster] = static_cast<unsigned int>(i);
+		}
+	}
+
+	// Keep triangles whose corners landed in different cells
+	outIndices.clear();
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		const auto a = vertexClusters[indices[i]];
+		const auto b = vertexClusters[indices[i + 1]];
+		const auto c = vertexClusters[indices[i + 2]];
+		if (a == b || b == c || c == a)
+			continue;
+
+		outIndices.push_back(a);
+		outIndices.push_back(b);
+		outIndices.push_back(c);
+	}
+
+	return static_cast<unsigned int>(outIndices.size() / 3);
+}
+
+void SimplifyMesh(const std::vector<MeshVertex> &vertices, const std::vector<unsigned int> &indices, float ratio,
+	std::vector<MeshVertex> &outVertices, std::vector<unsigned int> &outIndices)
+{
+	BoundingBox bounds;
+	for (const auto &v : vertices)
+		bounds.Add(v.Position);
+
+	const auto triangles = static_cast<unsigned int>(indices.size() / 3);
+	const auto target = static_cast<unsigned int>(triangles * glm::clamp(ratio, 0.0f, 1.0f));
+	if (bounds.IsEmpty() || target >= triangles)
+	{
+		outVertices = vertices;
+		outIndices = indices;
+		return;
+	}
+
+	// Finer grids keep more triangles, search the resolution closest to the target
+	std::vector<unsigned int> remap, clusterIndices;
+	std::vector<unsigned int> bestRemap, bestIndices;
+	unsigned int bestError = UINT32_MAX;
+	unsigned int low = 1, high = MESH_SIMPLIFY_RESOLUTION_MAX;
+	for (unsigned int i = 0; i < MESH_SIMPLIFY_ITERATIONS && low <= high; i++)
+	{
+		const auto resolution = low + (high - low) / 2;
+		const auto count = clusterVertices(vertices, indices, bounds, resolution, remap, clusterIndices);
+
+		const auto error = count > target ? count - target : target - count;
+		if (error < bestError)
+		{
+			bestError = error;
+			bestRemap.swap(remap);
+			bestIndices.swap(clusterIndices);
+		}
+
+		if (count > target)
+			high = resolution - 1;
+		else low = resolution + 1;
+	}
+
+	// Compact to the clusters still referenced
+	std::vector<unsigned int> compact(bestRemap.size(), UINT32_MAX);
+	outVertices.clear();
+	outIndices.clear();
+	outIndices.reserve(bestIndices.size());
+	for (auto cluster : bestIndices)
+	{
+		if (compact[cluster] == UINT32_MAX)
+		{
+			compact[cluster] = static_cast<unsigned int>(outVertices.size());
+			outVertices.push_back(vertices[bestRemap[cluster]]);
+		}
+
+		outIndices.push_back(compact[cluster]);
+	}
+}
\ No newline at end of file
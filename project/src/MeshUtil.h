@@ -0,0 +1,11 @@
+#pragma once
+
+#include "Mesh.h"
+#include <vector>
+
+// Reduces a triangle mesh to roughly ratio of its triangles by vertex clustering. Vertices are
+// snapped to a grid and every cell keeps its member closest to their average, so normals and
+// texture coordinates are taken from real vertices. Cells are split by texture coordinates so
+// vertices across a UV seam are never merged. Triangles collapsing within a cell are removed
+void SimplifyMesh(const std::vector<MeshVertex> &vertices, const std::vector<unsigned int> &indices, float ratio,
+	std::vector<MeshVertex> &outVertices, std::vector<unsigned int> &outIndices);
\ No newline at end of file
@@ -1,10 +1,14 @@
 #include "Model.h"
-#include "Camera.h" 
-// TODO: Abstract camera
 
 Model::Model(std::string name, std::vector<Mesh *> meshes, std::vector<Material *> materials, bool managed)
-	: Node(std::move(name)), m_Meshes(std::move(meshes)), m_Materials(std::move(materials)), m_Managed(managed)
+	: Node(std::move(name)), m_Meshes(std::move(meshes)), m_Materials(std::move(materials)), m_Managed(managed), m_Triangles(0), 
+	m_CurrentLod(0)
 {
+	for (const auto &m : m_Meshes)
+	{
+		m_Bounds.Add(m->GetBounds());
+		m_Triangles += m->GetIndexCount() / 3;
+	}
 }
 
 Model::~Model()
@@ -14,6 +18,11 @@ Model::~Model()
 		// Delete meshes
 		for (auto &m : m_Meshes)
 			Delete(m);
+		for (auto &lod : m_Lods)
+		{
+			for (auto &m : lod.Meshes)
+				Delete(m);
+		}
 
 		// Delete materials
 		for (auto &m : m_Materials)
@@ -21,9 +30,39 @@ Model::~Model()
 	}
 
 	m_Meshes.clear();
+	m_Lods.clear();
 	m_Materials.clear();
 }
 
+float Model::getScreenSize(const RenderContext *context) const
+{
+	// Bounding sphere of the meshes in world space
+	const auto &matrix = m_Transform.GetMatrix();
+	const auto center = glm::vec3(matrix * glm::vec4(m_Bounds.GetCenter(), 1.0f));
+	const auto scale = glm::max(glm::max(glm::length(glm::vec3(matrix[0])), glm::length(glm::vec3(matrix[1]))), 
+		glm::length(glm::vec3(matrix[2])));
+	const auto radius = glm::length(m_Bounds.GetExtents()) * scale;
+
+	// Diameter over the viewport height at that distance
+	const auto distance = glm::length(center - context->ViewPosition);
+	if (distance <= radius)
+		return 1.0f;
+
+	return radius * context->LodScale / distance;
+}
+
+unsigned int Model::selectLod(float screenSize) const
+{
+	// Only move past a threshold by a margin so models near it do not flicker between levels
+	auto lod = m_CurrentLod;
+	while (lod < m_Lods.size() && screenSize < m_Lods[lod].ScreenSize * (1.0f - MODEL_LOD_HYSTERESIS))
+		lod++;
+	while (lod > 0 && screenSize > m_Lods[lod - 1].ScreenSize * (1.0f + MODEL_LOD_HYSTERESIS))
+		lod--;
+
+	return lod;
+}
+
 Mesh *Model::GetMesh(const std::string &name) const
 {
 	for (auto &m : m_Meshes)
@@ -46,27 +85,83 @@ Material *Model::GetMaterial(const std::string &name) const
 	THROW_EXCEPTION(MaterialNotFoundException, "Material %s not found", name.c_str());
 }
 
+const std::vector<Mesh *> &Model::GetMeshes() const
+{
+	return m_Meshes;
+}
+
+const std::vector<Material *> &Model::GetMaterials() const
+{
+	return m_Materials;
+}
+
+void Model::AddLod(std::vector<Mesh *> meshes, float screenSize)
+{
+	ModelLod lod;
+	lod.Meshes = std::move(meshes);
+	lod.ScreenSize = screenSize;
+	lod.Triangles = 0;
+	for (const auto &m : lod.Meshes)
+		lod.Triangles += m->GetIndexCount() / 3;
+
+	m_Lods.push_back(std::move(lod));
+}
+
+const std::vector<ModelLod> &Model::GetLods() const
+{
+	return m_Lods;
+}
+
+unsigned int Model::GetLodCount() const
+{
+	return static_cast<unsigned int>(m_Lods.size()) + 1;
+}
+
+unsigned int Model::GetCurrentLod() const
+{
+	return m_CurrentLod;
+}
+
+NodeBoundsType Model::GetLocalBounds(BoundingBox &bounds) const
+{
+	bounds = m_Bounds;
+	return kNodeBoundsType_Box;
+}
+
 void Model::Compile()
 {
 	for (auto &m : m_Meshes)
 		m->Compile();
+	for (auto &lod : m_Lods)
+	{
+		for (auto &m : lod.Meshes)
+			m->Compile();
+	}
 
 	Node::Compile();
 }
 
 void Model::Render(RenderContext *context)
 {
-	// Check if we're in the bounding frustum of the camera
-	// TODO: Causing issues with camera look at
-	//const auto frustum = context->Camera->GetBoundingFrustum();
-	//if (frustum.Contains(m_Transform.GetPosition()) != kContainmentType_Disjoint)
-	{
-		// Set transform matrix
-		context->TransformMatrix = m_Transform.GetMatrix();
+	// Culled by the parent node against the bounds of this subtree
+	context->TransformMatrix = m_Transform.GetMatrix();
 
+	if (m_Lods.empty())
+	{
 		for (auto &m : m_Meshes)
 			m->Render(context);
 	}
+	else
+	{
+		m_CurrentLod = selectLod(getScreenSize(context));
+
+		const auto &meshes = m_CurrentLod == 0 ? m_Meshes : m_Lods[m_CurrentLod - 1].Meshes;
+		for (auto &m : meshes)
+			m->Render(context);
+
+		if (m_CurrentLod > 0)
+			context->LodTrianglesSaved += m_Triangles - m_Lods[m_CurrentLod - 1].Triangles;
+	}
 
 	Node::Render(context);
 }
@@ -4,14 +4,34 @@
 #include "Mesh.h"
 #include "Utility/Exception.h"
 
+#ifndef MODEL_LOD_HYSTERESIS
+#define MODEL_LOD_HYSTERESIS 0.15f // Fraction a screen size threshold must be passed by before switching back
+#endif
+
 DEFINE_EXCEPTION(MeshNotFoundException);
 DEFINE_EXCEPTION(MaterialNotFoundException);
 
+struct ModelLod
+{
+	std::vector<Mesh *> Meshes;
+	float ScreenSize; // Used below this fraction of the viewport height
+	unsigned int Triangles;
+};
+
 class Model : public Node
 {
 	std::vector<Mesh *> m_Meshes; // TODO: Move this to Model::m_Children later
 	std::vector<Material *> m_Materials;
 	bool m_Managed;
+	BoundingBox m_Bounds; // Of all meshes
+
+	// Coarser levels after the meshes above, ordered by decreasing screen size
+	std::vector<ModelLod> m_Lods;
+	unsigned int m_Triangles;
+	unsigned int m_CurrentLod; // Zero for the full meshes
+
+	float getScreenSize(const RenderContext *context) const;
+	unsigned int selectLod(float screenSize) const;
 
 public:
 	Model(std::string name, std::vector<Mesh *> meshes, std::vector<Material *> materials, bool managed = true);
@@ -29,6 +49,18 @@ public:
 	Mesh *GetMesh(const std::string &name) const;
 	Material *GetMaterial(const std::string &name) const;
 
+	const std::vector<Mesh *> &GetMeshes() const;
+	const std::vector<Material *> &GetMaterials() const;
+
+	// Adds a coarser level drawn once the model covers less than screenSize of the viewport
+	// height, meshes are owned like the full ones. Levels must be added from fine to coarse
+	void AddLod(std::vector<Mesh *> meshes, float screenSize);
+	const std::vector<ModelLod> &GetLods() const;
+	unsigned int GetLodCount() const; // Including the full meshes
+	unsigned int GetCurrentLod() const;
+
+	NodeBoundsType GetLocalBounds(BoundingBox &bounds) const override;
+
 	void Compile() override;
 	void Render(RenderContext *context) override;
 };
\ No newline at end of file
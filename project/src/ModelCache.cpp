@@ -0,0 +1,248 @@
+#include "ModelCache.h"
+#include <cstring>
+
+struct ModelCacheHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint64_t Hash;
+	uint32_t MaterialCount;
+	uint32_t MeshCount;
+	uint32_t VertexSize; // Guards against MeshVertex changing without a version bump
+	uint32_t Padding;
+};
+
+struct ModelCacheMaterial
+{
+	char Name[MODEL_CACHE_NAME_MAX];
+	char Shader[MODEL_CACHE_NAME_MAX];
+	char Textures[kModelTexture_Count][MODEL_CACHE_NAME_MAX];
+	uint32_t Flags;
+	float Ambient[3];
+	float Diffuse[3];
+	float Specular[3];
+	float Shininess;
+	uint32_t Padding[3];
+};
+
+struct ModelCacheMesh
+{
+	char Name[MODEL_CACHE_NAME_MAX];
+	uint32_t Level;
+	float ScreenSize;
+	uint32_t Material;
+	uint32_t VertexCount;
+	uint32_t IndexCount;
+	float BoundsMin[3];
+	float BoundsMax[3];
+	uint32_t Padding;
+	uint64_t VertexOffset;
+	uint64_t IndexOffset;
+};
+
+static size_t align(size_t offset)
+{
+	return (offset + MODEL_CACHE_ALIGNMENT - 1) & ~static_cast<size_t>(MODEL_CACHE_ALIGNMENT - 1);
+}
+
+static bool copyName(char *target, const std::string &name)
+{
+	if (name.size() >= MODEL_CACHE_NAME_MAX)
+		return false;
+
+	memset(target, 0, MODEL_CACHE_NAME_MAX);
+	memcpy(target, name.c_str(), name.size());
+	return true;
+}
+
+static std::string readName(const char *name)
+{
+	return std::string(name, strnlen(name, MODEL_CACHE_NAME_MAX));
+}
+
+ModelMaterialData::ModelMaterialData()
+	: Flags(0), Ambient(0.0f), Diffuse(0.0f), Specular(0.0f), Shininess(0.0f)
+{
+}
+
+bool ModelCache::Open(const std::string &path, uint64_t hash)
+{
+	Close();
+
+	if (!m_File.Open(path))
+		return false;
+
+	const auto data = static_cast<const uint8_t *>(m_File.GetData());
+	const auto size = m_File.GetSize();
+
+	if (size < sizeof(ModelCacheHeader))
+	{
+		Close();
+		return false;
+	}
+
+	ModelCacheHeader header;
+	memcpy(&header, data, sizeof(header));
+	if (header.Magic != MODEL_CACHE_MAGIC || header.Version != MODEL_CACHE_VERSION || header.Hash != hash
+		|| header.VertexSize != sizeof(MeshVertex))
+	{
+		Close();
+		return false;
+	}
+
+	// Tables follow the header
+	const auto materialsOffset = sizeof(ModelCacheHeader);
+	const auto meshesOffset = materialsOffset + sizeof(ModelCacheMaterial) * header.MaterialCount;
+	if (meshesOffset + sizeof(ModelCacheMesh) * header.MeshCount > size)
+	{
+		Close();
+		return false;
+	}
+
+	m_Materials.resize(header.MaterialCount);
+	for (uint32_t i = 0; i < header.MaterialCount; i++)
+	{
+		ModelCacheMaterial cached;
+		memcpy(&cached, data + materialsOffset + sizeof(ModelCacheMaterial) * i, sizeof(cached));
+
+		auto &material = m_Materials[i];
+		material.Name = readName(cached.Name);
+		material.Shader = readName(cached.Shader);
+		for (unsigned int j = 0; j < kModelTexture_Count; j++)
+			material.Textures[j] = readName(cached.Textures[j]);
+		material.Flags = cached.Flags;
+		material.Ambient = glm::vec3(cached.Ambient[0], cached.Ambient[1], cached.Ambient[2]);
+		material.Diffuse = glm::vec3(cached.Diffuse[0], cached.Diffuse[1], cached.Diffuse[2]);
+		material.Specular = glm::vec3(cached.Specular[0], cached.Specular[1], cached.Specular[2]);
+		material.Shininess = cached.Shininess;
+	}
+
+	m_Meshes.resize(header.MeshCount);
+	for (uint32_t i = 0; i < header.MeshCount; i++)
+	{
+		ModelCacheMesh cached;
+		memcpy(&cached, data + meshesOffset + sizeof(ModelCacheMesh) * i, sizeof(cached));
+
+		// Reject offsets outside the file or misaligned for the vertex and index types
+		const auto vertexEnd = cached.VertexOffset + static_cast<uint64_t>(cached.VertexCount) * sizeof(MeshVertex);
+		const auto indexEnd = cached.IndexOffset + static_cast<uint64_t>(cached.IndexCount) * sizeof(unsigned int);
+		if (vertexEnd > size || indexEnd > size || cached.VertexOffset % MODEL_CACHE_ALIGNMENT != 0
+			|| cached.IndexOffset % MODEL_CACHE_ALIGNMENT != 0
+			|| (cached.Material != MODEL_CACHE_NO_MATERIAL && cached.Material >= header.MaterialCount))
+		{
+			Close();
+			return false;
+		}
+
+		auto &mesh = m_Meshes[i];
+		mesh.Name = readName(cached.Name);
+		mesh.Level = cached.Level;
+		mesh.ScreenSize = cached.ScreenSize;
+		mesh.Material = cached.Material;
+		mesh.Vertices = reinterpret_cast<const MeshVertex *>(data + cached.VertexOffset);
+		mesh.VertexCount = cached.VertexCount;
+		mesh.Indices = reinterpret_cast<const unsigned int *>(data + cached.IndexOffset);
+		mesh.IndexCount = cached.IndexCount;
+		mesh.Bounds = BoundingBox(glm::vec3(cached.BoundsMin[0], cached.BoundsMin[1], cached.BoundsMin[2]),
+			glm::vec3(cached.BoundsMax[0], cached.BoundsMax[1], cached.BoundsMax[2]));
+	}
+
+	return true;
+}
+
+void ModelCache::Close()
+{
+	m_Materials.clear();
+	m_Meshes.clear();
+	m_File.Close();
+}
+
+const std::vector<ModelMaterialData> &ModelCache::GetMaterials() const
+{
+	return m_Materials;
+}
+
+const std::vector<ModelMeshData> &ModelCache::GetMeshes() const
+{
+	return m_Meshes;
+}
+
+bool ModelCache::Write(const std::string &path, uint64_t hash, const std::vector<ModelMaterialData> &materials,
+	const std::vector<ModelMeshData> &meshes)
+{
+	ModelCacheHeader header{};
+	header.Magic = MODEL_CACHE_MAGIC;
+	header.Version = MODEL_CACHE_VERSION;
+	header.Hash = hash;
+	header.MaterialCount = static_cast<uint32_t>(materials.size());
+	header.MeshCount = static_cast<uint32_t>(meshes.size());
+	header.VertexSize = sizeof(MeshVertex);
+
+	std::vector<ModelCacheMaterial> cachedMaterials(materials.size());
+	for (size_t i = 0; i < materials.size(); i++)
+	{
+		const auto &material = materials[i];
+		auto &cached = cachedMaterials[i];
+		memset(&cached, 0, sizeof(cached));
+
+		if (!copyName(cached.Name, material.Name) || !copyName(cached.Shader, material.Shader))
+			return false;
+		for (unsigned int j = 0; j < kModelTexture_Count; j++)
+		{
+			if (!copyName(cached.Textures[j], material.Textures[j]))
+				return false;
+		}
+
+		cached.Flags = material.Flags;
+		memcpy(cached.Ambient, &material.Ambient[0], sizeof(cached.Ambient));
+		memcpy(cached.Diffuse, &material.Diffuse[0], sizeof(cached.Diffuse));
+		memcpy(cached.Specular, &material.Specular[0], sizeof(cached.Specular));
+		cached.Shininess = material.Shininess;
+	}
+
+	// Place the data arrays after the tables
+	auto offset = align(sizeof(ModelCacheHeader) + sizeof(ModelCacheMaterial) * materials.size() + sizeof(ModelCacheMesh) * meshes.size());
+
+	std::vector<ModelCacheMesh> cachedMeshes(meshes.size());
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		const auto &mesh = meshes[i];
+		auto &cached = cachedMeshes[i];
+		memset(&cached, 0, sizeof(cached));
+
+		if (!copyName(cached.Name, mesh.Name))
+			return false;
+
+		cached.Level = mesh.Level;
+		cached.ScreenSize = mesh.ScreenSize;
+		cached.Material = mesh.Material;
+		cached.VertexCount = mesh.VertexCount;
+		cached.IndexCount = mesh.IndexCount;
+		memcpy(cached.BoundsMin, &mesh.Bounds.Min[0], sizeof(cached.BoundsMin));
+		memcpy(cached.BoundsMax, &mesh.Bounds.Max[0], sizeof(cached.BoundsMax));
+
+		cached.VertexOffset = offset;
+		offset = align(offset + sizeof(MeshVertex) * mesh.VertexCount);
+		cached.IndexOffset = offset;
+		offset = align(offset + sizeof(unsigned int) * mesh.IndexCount);
+	}
+
+	// Assemble in memory and write at once
+	std::vector<uint8_t> data(offset, 0);
+	memcpy(data.data(), &header, sizeof(header));
+	if (!cachedMaterials.empty())
+		memcpy(data.data() + sizeof(ModelCacheHeader), cachedMaterials.data(), sizeof(ModelCacheMaterial) * cachedMaterials.size());
+	if (!cachedMeshes.empty())
+		memcpy(data.data() + sizeof(ModelCacheHeader) + sizeof(ModelCacheMaterial) * materials.size(), cachedMeshes.data(),
+			sizeof(ModelCacheMesh) * cachedMeshes.size());
+
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		if (meshes[i].VertexCount)
+			memcpy(data.data() + cachedMeshes[i].VertexOffset, meshes[i].Vertices, sizeof(MeshVertex) * meshes[i].VertexCount);
+		if (meshes[i].IndexCount)
+			memcpy(data.data() + cachedMeshes[i].IndexOffset, meshes[i].Indices, sizeof(unsigned int) * meshes[i].IndexCount);
+	}
+
+	return File::WriteAllBytes(path, data.data(), data.size());
+}
\ No newline at end of file
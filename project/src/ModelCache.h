@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Bounds.h"
+#include "Mesh.h"
+#include "Utility/FileUtil.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#ifndef MODEL_CACHE_EXTENSION
+#define MODEL_CACHE_EXTENSION ".cache"
+#endif
+
+#define MODEL_CACHE_MAGIC 0x43444C4Du // "MLDC"
+#define MODEL_CACHE_VERSION 2 // Bump whenever the layout or the import settings change
+#define MODEL_CACHE_NAME_MAX 64 // Including the terminator
+#define MODEL_CACHE_ALIGNMENT 16
+
+enum ModelTexture
+{
+	kModelTexture_Ambient,
+	kModelTexture_Diffuse,
+	kModelTexture_Specular,
+
+	kModelTexture_Count
+};
+
+enum ModelMaterialFlag
+{
+	kModelMaterialFlag_Ambient = 1 << 0,
+	kModelMaterialFlag_Diffuse = 1 << 1,
+	kModelMaterialFlag_Specular = 1 << 2,
+	kModelMaterialFlag_Shininess = 1 << 3
+};
+
+// Material properties found by the importer, applied to the shader's variables when they exist
+struct ModelMaterialData
+{
+	std::string Name;
+	std::string Shader;
+	unsigned int Flags;
+	glm::vec3 Ambient;
+	glm::vec3 Diffuse;
+	glm::vec3 Specular;
+	float Shininess;
+	std::string Textures[kModelTexture_Count]; // Texture names, empty if unused
+
+	ModelMaterialData();
+};
+
+// Points into the mapped file for cached meshes
+struct ModelMeshData
+{
+	std::string Name;
+	unsigned int Level; // Zero for the full meshes
+	float ScreenSize; // Of the level
+	unsigned int Material; // Index into the material table, MODEL_CACHE_NO_MATERIAL if none
+	const MeshVertex *Vertices;
+	unsigned int VertexCount;
+	const unsigned int *Indices;
+	unsigned int IndexCount;
+	BoundingBox Bounds;
+};
+
+#define MODEL_CACHE_NO_MATERIAL 0xFFFFFFFFu
+
+// Baked model, read through a memory mapping so vertex and index data go to the buffers
+// without being copied. Layout: header, material table, mesh table, then vertex and index
+// data, every array aligned to MODEL_CACHE_ALIGNMENT. Stores native endianness
+class ModelCache
+{
+	MemoryMappedFile m_File;
+	std::vector<ModelMaterialData> m_Materials;
+	std::vector<ModelMeshData> m_Meshes;
+
+public:
+	ModelCache() = default;
+
+	// No copying/moving
+	ModelCache(const ModelCache &) = delete;
+	ModelCache &operator=(const ModelCache &) = delete;
+
+	ModelCache(const ModelCache &&) = delete;
+	ModelCache &operator=(const ModelCache &&) = delete;
+
+	// Returns false if the file is missing, from another version, stale or damaged
+	bool Open(const std::string &path, uint64_t hash);
+	void Close();
+
+	const std::vector<ModelMaterialData> &GetMaterials() const;
+	const std::vector<ModelMeshData> &GetMeshes() const;
+
+	// Returns false if the file could not be written or a name is too long
+	static bool Write(const std::string &path, uint64_t hash, const std::vector<ModelMaterialData> &materials,
+		const std::vector<ModelMeshData> &meshes);
+};
\ No newline at end of file
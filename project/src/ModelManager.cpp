@@ -1,31 +1,43 @@
 #include "ModelManager.h"
+#include "MeshUtil.h"
+#include "Log.h"
 #include "Utility/FileUtil.h"
+#include "Utility/Hash.h"
 #include <assimp/postprocess.h>
 #include <rapidjson/document.h>
+#include <algorithm>
+#include <chrono>
 
-void ModelManager::loadTexture(Material *material, const std::string &path, const std::string &key, const std::string &enableKey)
+// Texture name from the path stored in the model file
+static std::string getTextureName(const std::string &path)
 {
-	// Load texture
 	auto name = path.substr(path.find_last_of('/') + 1);
 	name = name.substr(name.find_last_of('\\') + 1);
-	name = name.substr(0, name.find_last_of('.'));
-	const auto texture = m_GraphicsManager->GetTexture(name);
+	return name.substr(0, name.find_last_of('.'));
+}
+
+void ModelManager::loadTexture(Material *material, const std::string &name, const char *key, const char *enableKey)
+{
+	// Load texture, streamed in after the model is shown
+	unsigned int layer;
+	const auto texture = m_GraphicsManager->GetTexture(name, m_Loader, &layer);
 
 	// Set material texture
-	material->SetTexture(key, texture);
+	material->SetTexture(key, texture, layer);
 	
 	// Set material to use texture
-	if (!enableKey.empty())
+	if (enableKey)
 	{
 		const auto v = material->GetVariable(enableKey);
 		v->SetBool(true);
 	}
 }
 
-Mesh *ModelManager::processMesh(Material *material, aiMesh *mesh, const aiScene *scene)
+void ModelManager::processMesh(ModelLoad *load, unsigned int material, aiMesh *mesh, const aiScene *scene) const
 {
 	std::vector<MeshVertex> vertices;
 	std::vector<unsigned int> indices;
+	BoundingBox bounds;
 
 	// Build vertices
 	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -36,6 +48,7 @@ Mesh *ModelManager::processMesh(Material *material, aiMesh *mesh, const aiScene
 		v.Position.x = mesh->mVertices[i].x;
 		v.Position.y = mesh->mVertices[i].y;
 		v.Position.z = mesh->mVertices[i].z;
+		bounds.Add(v.Position);
 
 		// Normal
 		if (mesh->HasNormals())
@@ -65,11 +78,24 @@ Mesh *ModelManager::processMesh(Material *material, aiMesh *mesh, const aiScene
 			indices.push_back(face.mIndices[j]);
 	}
 
-	return New<Mesh>(mesh->mName.C_Str(), vertices, indices, material);
+	ModelMeshData data;
+	data.Name = mesh->mName.C_Str();
+	data.Level = 0;
+	data.ScreenSize = 0.0f;
+	data.Material = material;
+	data.Vertices = vertices.data();
+	data.VertexCount = static_cast<unsigned int>(vertices.size());
+	data.Indices = indices.data();
+	data.IndexCount = static_cast<unsigned int>(indices.size());
+	data.Bounds = bounds;
+	load->Meshes.push_back(data);
+
+	// Moving keeps the buffers the mesh points to
+	load->Vertices.push_back(std::move(vertices));
+	load->Indices.push_back(std::move(indices));
 }
 
-void ModelManager::processNode(std::vector<Material *> &materials, std::vector<Mesh *> &meshes, aiNode *node,
-	const aiScene *scene)
+void ModelManager::processNode(ModelLoad *load, aiNode *node, const aiScene *scene) const
 {
 	// Load meshes
 	for (unsigned int i = 0; i < node->mNumMeshes; i++)
@@ -81,119 +107,166 @@ void ModelManager::processNode(std::vector<Material *> &materials, std::vector<M
 		if (scene->mMaterials[mesh->mMaterialIndex]->Get(AI_MATKEY_NAME, reqMatName) != AI_SUCCESS)
 			THROW_EXCEPTION(ModelLoadException, "Unable to get material name");
 
-		Material *material = nullptr;
-		for (auto &m : materials)
+		auto material = MODEL_CACHE_NO_MATERIAL;
+		for (size_t j = 0; j < load->Materials.size(); j++)
 		{
-			if (m->GetName() == reqMatName.C_Str())
+			if (load->Materials[j].Name == reqMatName.C_Str())
 			{
-				material = m;
+				material = static_cast<unsigned int>(j);
 				break;
 			}
 		}
 
 		// Process mesh
-		meshes.push_back(processMesh(material, mesh, scene));
+		processMesh(load, material, mesh, scene);
 	}
 
 	// Load child nodes
 	for (unsigned int i = 0; i < node->mNumChildren; i++)
 	{
 		const auto n = node->mChildren[i];
-		processNode(materials, meshes, n, scene);
+		processNode(load, n, scene);
 	}
 }
 
-Material *ModelManager::processMaterial(std::map<std::string, std::string> &materialMap, aiMaterial *material, const aiScene *scene)
+ModelMaterialData ModelManager::processMaterial(std::map<std::string, std::string> &materialMap, aiMaterial *material, 
+	const aiScene *scene) const
 {
+	ModelMaterialData data;
+
 	// Read material info
 	aiString name;
 	if (material->Get(AI_MATKEY_NAME, name) != AI_SUCCESS)
 		THROW_EXCEPTION(ModelLoadException, "Unable to get material name, possibly no materials");
 
+	data.Name = name.C_Str();
+
 	// Check if material map contains shader for this material
 	std::map<std::string, std::string>::iterator it;
 	if ((it = materialMap.find(name.C_Str())) == materialMap.end())
 		THROW_EXCEPTION(ModelLoadException, "Unable to get shader name, material must be mapped to a shader");
 
-	// Find and activate shader
-	const auto s = m_GraphicsManager->GetShader(it->second);
-	s->Use();
-
-	// Create material
-	const auto m = New<Material>(name.C_Str(), s);
+	data.Shader = it->second;
 
 	// Colors
 	{
 		aiColor3D value;
-		if (material->Get(AI_MATKEY_COLOR_AMBIENT, value) == AI_SUCCESS
-			&& m->IsVariable(kMaterialVar_Ambient))
+		if (material->Get(AI_MATKEY_COLOR_AMBIENT, value) == AI_SUCCESS)
 		{
-			const auto v = m->GetVariable(kMaterialVar_Ambient);
-			v->SetVec3({ value.r, value.g, value.b });
+			data.Ambient = { value.r, value.g, value.b };
+			data.Flags |= kModelMaterialFlag_Ambient;
 		}
-		if (material->Get(AI_MATKEY_COLOR_DIFFUSE, value) == AI_SUCCESS
-			&& m->IsVariable(kMaterialVar_Diffuse))
+		if (material->Get(AI_MATKEY_COLOR_DIFFUSE, value) == AI_SUCCESS)
 		{
-			const auto v = m->GetVariable(kMaterialVar_Diffuse);
-			v->SetVec3({ value.r, value.g, value.b });
+			data.Diffuse = { value.r, value.g, value.b };
+			data.Flags |= kModelMaterialFlag_Diffuse;
 		}
-		if (material->Get(AI_MATKEY_COLOR_SPECULAR, value) == AI_SUCCESS
-			&& m->IsVariable(kMaterialVar_Specular))
+		if (material->Get(AI_MATKEY_COLOR_SPECULAR, value) == AI_SUCCESS)
 		{
-			const auto v = m->GetVariable(kMaterialVar_Specular);
-			v->SetVec3({ value.r, value.g, value.b });
+			data.Specular = { value.r, value.g, value.b };
+			data.Flags |= kModelMaterialFlag_Specular;
 		}
 	}
 
 	// Textures (NOTE: only one per property is supported)
 	{
 		aiString path;
-		if (material->GetTextureCount(aiTextureType_AMBIENT)
-			&& m->IsVariable(kMaterialVar_TextureAmbient))
+		if (material->GetTextureCount(aiTextureType_AMBIENT))
 			if (material->GetTexture(aiTextureType_AMBIENT, 0, &path) == AI_SUCCESS)
-				loadTexture(m, path.C_Str(), kMaterialVar_TextureAmbient, kMaterialVar_TextureAmbientEnabled);
-		if (material->GetTextureCount(aiTextureType_DIFFUSE)
-			&& m->IsVariable(kMaterialVar_TextureDiffuse))
+				data.Textures[kModelTexture_Ambient] = getTextureName(path.C_Str());
+		if (material->GetTextureCount(aiTextureType_DIFFUSE))
 			if (material->GetTexture(aiTextureType_DIFFUSE, 0, &path) == AI_SUCCESS)
-				loadTexture(m, path.C_Str(), kMaterialVar_TextureDiffuse, kMaterialVar_TextureDiffuseEnabled);
-		if (material->GetTextureCount(aiTextureType_SPECULAR)
-			&& m->IsVariable(kMaterialVar_TextureSpecular))
+				data.Textures[kModelTexture_Diffuse] = getTextureName(path.C_Str());
+		if (material->GetTextureCount(aiTextureType_SPECULAR))
 			if (material->GetTexture(aiTextureType_SPECULAR, 0, &path) == AI_SUCCESS)
-				loadTexture(m, path.C_Str(), kMaterialVar_TextureSpecular, kMaterialVar_TextureSpecularEnabled);
+				data.Textures[kModelTexture_Specular] = getTextureName(path.C_Str());
 	}
 
 	// Other properties
 	{
 		float value;
-		if (material->Get(AI_MATKEY_SHININESS, value) == AI_SUCCESS
-			&& m->IsVariable(kMaterialVar_Shininess))
+		if (material->Get(AI_MATKEY_SHININESS, value) == AI_SUCCESS)
 		{
-			const auto v = m->GetVariable(kMaterialVar_Shininess);
-			v->SetFloat(value);
+			data.Shininess = value;
+			data.Flags |= kModelMaterialFlag_Shininess;
 		}
 	}
 
 	// TODO: etc...
 
+	return data;
+}
+
+Material *ModelManager::createMaterial(const ModelMaterialData &data)
+{
+	// Find and activate shader
+	const auto s = m_GraphicsManager->GetShader(data.Shader);
+	s->Use();
+
+	// Create material, properties the shader does not use are skipped
+	const auto m = New<Material>(data.Name, s);
+
+	// Colors
+	if (data.Flags & kModelMaterialFlag_Ambient && m->IsVariable(kMaterialVar_Ambient))
+		m->GetVariable(kMaterialVar_Ambient)->SetVec3(data.Ambient);
+	if (data.Flags & kModelMaterialFlag_Diffuse && m->IsVariable(kMaterialVar_Diffuse))
+		m->GetVariable(kMaterialVar_Diffuse)->SetVec3(data.Diffuse);
+	if (data.Flags & kModelMaterialFlag_Specular && m->IsVariable(kMaterialVar_Specular))
+		m->GetVariable(kMaterialVar_Specular)->SetVec3(data.Specular);
+
+	// Textures
+	if (!data.Textures[kModelTexture_Ambient].empty() && m->IsVariable(kMaterialVar_TextureAmbient))
+		loadTexture(m, data.Textures[kModelTexture_Ambient], kMaterialVar_TextureAmbient, kMaterialVar_TextureAmbientEnabled);
+	if (!data.Textures[kModelTexture_Diffuse].empty() && m->IsVariable(kMaterialVar_TextureDiffuse))
+		loadTexture(m, data.Textures[kModelTexture_Diffuse], kMaterialVar_TextureDiffuse, kMaterialVar_TextureDiffuseEnabled);
+	if (!data.Textures[kModelTexture_Specular].empty() && m->IsVariable(kMaterialVar_TextureSpecular))
+		loadTexture(m, data.Textures[kModelTexture_Specular], kMaterialVar_TextureSpecular, kMaterialVar_TextureSpecularEnabled);
+
+	// Other properties
+	if (data.Flags & kModelMaterialFlag_Shininess && m->IsVariable(kMaterialVar_Shininess))
+		m->GetVariable(kMaterialVar_Shininess)->SetFloat(data.Shininess);
+
 	return m;
 }
 
-void ModelManager::processScene(const aiScene *scene, std::map<std::string, std::string> &materialMap, std::vector<Material *> &materials, std::vector<Mesh *> &meshes)
+void ModelManager::processScene(ModelLoad *load, const aiScene *scene, std::map<std::string, std::string> &materialMap) const
 {
-	// Load materials
+	// Load materials, created for every instance
 	for (unsigned int i = 0; i < scene->mNumMaterials; i++)
 	{
 		const auto m = scene->mMaterials[i];
-		materials.push_back(processMaterial(materialMap, m, scene));
+		load->Materials.push_back(processMaterial(materialMap, m, scene));
 	}
 
 	// Process nodes
-	processNode(materials, meshes, scene->mRootNode, scene);
+	processNode(load, scene->mRootNode, scene);
 }
 
 // TODO: Preferrably rewrite loading/materials for better support -- (multiple material support!)
-Model *ModelManager::loadFromFile(const std::string &name)
+uint64_t ModelManager::hashSources(const std::string &metaSource, const std::string &filePath, const std::string &name) const
 {
+	// Meta data, the model file and the usual companion files (gltf buffers, obj materials)
+	auto hash = HashBytes(metaSource.data(), metaSource.size());
+
+	const auto directory = m_DataPath + "/" + name + "/" + name;
+	for (const auto &path : { filePath, directory + ".bin", directory + ".mtl" })
+	{
+		// A missing model file fails the import afterwards
+		if (!File::Exists(path))
+			continue;
+
+		const auto bytes = File::ReadAllBytes(path);
+		hash = HashBytes(bytes.data(), bytes.size(), hash);
+	}
+
+	return hash;
+}
+
+void ModelManager::readModel(ModelLoad *load) const
+{
+	const auto startTime = std::chrono::steady_clock::now();
+	const auto &name = load->Name;
+
 	// Read texture meta data
 	const auto metaLines = File::ReadAllLines(m_DataPath + "/" + name + "/meta.json");
 	const auto metaSource = String::Join(metaLines, "\n");
@@ -211,6 +284,22 @@ Model *ModelManager::loadFromFile(const std::string &name)
 	if (!meta.HasMember("extension") || !meta["extension"].IsString())
 		THROW_EXCEPTION(InvalidModelException, "Meta data invalid extension");
 
+	// Use the baked model while its sources are unchanged
+	const auto filePath = m_DataPath + "/" + name + "/" + name + "." + meta["extension"].GetString();
+	const auto cachePath = m_DataPath + "/" + name + "/" + name + MODEL_CACHE_EXTENSION;
+	const auto hash = hashSources(metaSource, filePath, name);
+
+	if (load->Cache.Open(cachePath, hash))
+	{
+		// Uploaded straight from the mapping
+		load->Materials = load->Cache.GetMaterials();
+		load->Meshes = load->Cache.GetMeshes();
+
+		LOG_INFO("Models", "Read %s from cache in %.2f ms", name.c_str(), 
+			std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count());
+		return;
+	}
+
 	// Get material to shader map
 	if (!meta.HasMember("materialMap") || !meta["materialMap"].IsObject())
 		THROW_EXCEPTION(InvalidModelException, "Meta data invalid material map");
@@ -226,22 +315,139 @@ Model *ModelManager::loadFromFile(const std::string &name)
 
 	// Import
 	Assimp::Importer importer;
-	const auto filePath = m_DataPath + "/" + name + "/" + name + "." + meta["extension"].GetString();
 	const auto scene = importer.ReadFile(filePath,  aiProcess_Triangulate | aiProcess_RemoveRedundantMaterials 
 		| aiProcess_GenUVCoords | aiProcess_TransformUVCoords);
 	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
 		THROW_EXCEPTION(ModelLoadException, "Unable to load model %s: %s", filePath.c_str(), importer.GetErrorString());
 
+	processScene(load, scene, materialMap);
+
+	// Optional coarser levels, simplified from the imported meshes
+	if (meta.HasMember("lods"))
+	{
+		const auto &lods = meta["lods"];
+		if (!lods.IsArray())
+			THROW_EXCEPTION(InvalidModelException, "Meta data invalid lods");
+
+		for (rapidjson::SizeType i = 0; i < lods.Size(); i++)
+		{
+			const auto &lod = lods[i];
+			if (!lod.IsObject() || !lod.HasMember("screenSize") || !lod["screenSize"].IsNumber() 
+				|| !lod.HasMember("ratio") || !lod["ratio"].IsNumber())
+				THROW_EXCEPTION(InvalidModelException, "Meta data invalid lod %u", i);
+
+			// Imported meshes come first, one vertex and index array each
+			const auto meshCount = load->Vertices.size();
+			for (size_t j = 0; j < meshCount; j++)
+			{
+				std::vector<MeshVertex> vertices;
+				std::vector<unsigned int> indices;
+				SimplifyMesh(load->Vertices[j], load->Indices[j], lod["ratio"].GetFloat(), vertices, indices);
+
+				auto data = load->Meshes[j];
+				data.Level = i + 1;
+				data.ScreenSize = lod["screenSize"].GetFloat();
+				data.Vertices = vertices.data();
+				data.VertexCount = static_cast<unsigned int>(vertices.size());
+				data.Indices = indices.data();
+				data.IndexCount = static_cast<unsigned int>(indices.size());
+				load->Meshes.push_back(data);
+
+				load->Vertices.push_back(std::move(vertices));
+				load->Indices.push_back(std::move(indices));
+			}
+		}
+	}
+
+	// Not fatal, the model is imported again next time
+	if (!ModelCache::Write(cachePath, hash, load->Materials, load->Meshes))
+		LOG_WARN("Models", "Unable to write model cache %s", cachePath.c_str());
+
+	LOG_INFO("Models", "Imported %s in %.2f ms", name.c_str(), 
+		std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count());
+}
+
+void ModelManager::finishModel(ModelLoad *load)
+{
+	// Kept until a wait reports the error
+	if (!load->Error.empty())
+	{
+		LOG_ERROR("Models", "Unable to load model %s: %s", load->Name.c_str(), load->Error.c_str());
+		return;
+	}
+
+	const auto asset = New<ModelAsset>();
+	asset->Materials = load->Materials;
+	for (const auto &data : load->Meshes)
+	{
+		ModelAssetMesh m;
+		m.Name = data.Name;
+		m.Level = data.Level;
+		m.ScreenSize = data.ScreenSize;
+		m.Material = data.Material;
+		m.Geometry = New<MeshGeometry>(data.Vertices, data.VertexCount, data.Indices, data.IndexCount, data.Bounds);
+		m.Geometry->AddReference();
+		asset->Meshes.push_back(m);
+	}
+
+	m_Assets.emplace(load->Name, asset);
+	m_Loads.erase(load->Name);
+	Delete(load);
+}
+
+ModelAsset *ModelManager::getAsset(const std::string &name)
+{
+	// Check if it is already loaded
+	std::map<std::string, ModelAsset *>::iterator it;
+	if ((it = m_Assets.find(name)) != m_Assets.end())
+		return it->second;
+
+	// Load asset, completed by the wait unless it failed
+	RequestModel(name);
+	const auto load = m_Loads[name];
+	m_Loader->Wait(&load->Counter);
+
+	if ((it = m_Assets.find(name)) != m_Assets.end())
+		return it->second;
+
+	const auto error = load->Error;
+	m_Loads.erase(name);
+	Delete(load);
+
+	THROW_EXCEPTION(ModelLoadException, "Unable to load model %s: %s", name.c_str(), error.c_str());
+}
+
+Model *ModelManager::createModel(const std::string &name, const ModelAsset *asset)
+{
+	// Materials hold per instance values, the textures and shaders behind them are shared
 	std::vector<Material *> materials;
-	std::vector<Mesh *> meshes;
+	for (const auto &data : asset->Materials)
+		materials.push_back(createMaterial(data));
 
-	processScene(scene, materialMap, materials, meshes);
+	std::vector<std::vector<Mesh *>> levels(1);
+	std::vector<float> screenSizes(1, 0.0f);
+	for (const auto &m : asset->Meshes)
+	{
+		if (m.Level >= levels.size())
+		{
+			levels.resize(m.Level + 1);
+			screenSizes.resize(m.Level + 1);
+		}
 
-	return New<Model>(name, meshes, materials);
+		const auto material = m.Material == MODEL_CACHE_NO_MATERIAL ? nullptr : materials[m.Material];
+		levels[m.Level].push_back(New<Mesh>(m.Name, m.Geometry, material));
+		screenSizes[m.Level] = m.ScreenSize;
+	}
+
+	const auto model = New<Model>(name, levels[0], materials);
+	for (size_t i = 1; i < levels.size(); i++)
+		model->AddLod(levels[i], screenSizes[i]);
+
+	return model;
 }
 
-ModelManager::ModelManager(std::string dataPath, GraphicsManager *graphicsManager)
-	: m_DataPath(std::move(dataPath)), m_GraphicsManager(graphicsManager)
+ModelManager::ModelManager(std::string dataPath, GraphicsManager *graphicsManager, AssetLoader *loader)
+	: m_DataPath(std::move(dataPath)), m_GraphicsManager(graphicsManager), m_Loader(loader)
 {
 }
 
@@ -251,11 +457,55 @@ ModelManager::~ModelManager()
 	for (auto &pair : m_Models)
 		Delete(pair.second);
 	m_Models.clear();
+
+	// Failed loads nobody waited for
+	for (auto &pair : m_Loads)
+		Delete(pair.second);
+	m_Loads.clear();
+
+	// Release geometry, buffers still drawn by unmanaged models stay alive until those are deleted
+	for (auto &pair : m_Assets)
+	{
+		for (auto &m : pair.second->Meshes)
+			m.Geometry->Release();
+		Delete(pair.second);
+	}
+	m_Assets.clear();
+}
+
+void ModelManager::RequestModel(const std::string &name)
+{
+	if (m_Assets.find(name) != m_Assets.end() || m_Loads.find(name) != m_Loads.end())
+		return;
+
+	const auto load = New<ModelLoad>();
+	load->Name = name;
+	m_Loads.emplace(name, load);
+
+	m_Loader->Load([this, load]()
+	{
+		try
+		{
+			readModel(load);
+		}
+		catch (std::exception &ex)
+		{
+			load->Error = ex.what();
+		}
+	}, [this, load]()
+	{
+		finishModel(load);
+	}, &load->Counter);
+}
+
+bool ModelManager::IsModelReady(const std::string &name) const
+{
+	return m_Assets.find(name) != m_Assets.end();
 }
 
 Model *ModelManager::LoadModel(const std::string &name)
 {
-	return loadFromFile(name);
+	return createModel(name, getAsset(name));
 }
 
 Model *ModelManager::GetModel(const std::string &name)
@@ -266,7 +516,7 @@ Model *ModelManager::GetModel(const std::string &name)
 		return it->second;
 
 	// Load model
-	const auto model = loadFromFile(name);
+	const auto model = createModel(name, getAsset(name));
 
 	// Store model
 	m_Models.emplace(name, model);
@@ -1,7 +1,9 @@
 #pragma once
 
+#include "AssetLoader.h"
 #include "GraphicsManager.h"
 #include "Model.h"
+#include "ModelCache.h"
 #include "Utility/Exception.h"
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
@@ -9,26 +11,67 @@
 DEFINE_EXCEPTION(InvalidModelException);
 DEFINE_EXCEPTION(ModelLoadException);
 
+// Imported geometry of a model, shared by every instance of it
+struct ModelAssetMesh
+{
+	std::string Name;
+	unsigned int Level; // Zero for the full meshes
+	float ScreenSize; // Of the level
+	unsigned int Material; // Index into the materials, MODEL_CACHE_NO_MATERIAL if none
+	MeshGeometry *Geometry; // Referenced by the asset
+};
+
+struct ModelAsset
+{
+	std::vector<ModelMaterialData> Materials;
+	std::vector<ModelAssetMesh> Meshes; // Ordered by level
+};
+
+// Model read on a worker, the geometry is uploaded once it completes
+struct ModelLoad
+{
+	std::string Name;
+	ModelCache Cache; // Cached meshes point into it
+	std::vector<ModelMaterialData> Materials;
+	std::vector<ModelMeshData> Meshes; // Ordered by level
+	std::vector<std::vector<MeshVertex>> Vertices; // Imported meshes point into these
+	std::vector<std::vector<unsigned int>> Indices;
+	std::string Error; // Set if the load failed
+	JobCounter Counter;
+};
+
 class ModelManager
 {
 	std::string m_DataPath;
 
 	GraphicsManager *m_GraphicsManager;
+	AssetLoader *m_Loader;
 	std::map<std::string, Model *> m_Models;
+	std::map<std::string, ModelAsset *> m_Assets;
+	std::map<std::string, ModelLoad *> m_Loads; // Requested, not completed or failed
+
+	void loadTexture(Material *material, const std::string &name, const char *key, const char *enableKey = nullptr);
+	Material *createMaterial(const ModelMaterialData &data);
+
+	// Run on workers, without touching GL
+	void processMesh(ModelLoad *load, unsigned int material, aiMesh *mesh, const aiScene *scene) const;
+	void processNode(ModelLoad *load, aiNode *node, const aiScene *scene) const;
+	ModelMaterialData processMaterial(std::map<std::string, std::string> &materialMap, aiMaterial *material, 
+		const aiScene *scene) const;
+	void processScene(ModelLoad *load, const aiScene *scene, std::map<std::string, std::string> &materialMap) const;
 
-	void loadTexture(Material *material, const std::string &path, const std::string &key, const std::string &enableKey = "");
+	// Baked models next to the sources, rebuilt whenever the hash of the sources changes
+	uint64_t hashSources(const std::string &metaSource, const std::string &filePath, const std::string &name) const;
 
-	Mesh *processMesh(Material *material, aiMesh *mesh, const aiScene *scene);
-	void processNode(std::vector<Material *> &materials, std::vector<Mesh *> &meshes, aiNode *node, 
-		const aiScene *scene);
-	Material *processMaterial(std::map<std::string, std::string> &materialMap, aiMaterial *material, 
-		const aiScene *scene);
-	void processScene(const aiScene *scene, std::map<std::string, std::string> &materialMap, 
-		std::vector<Material *> &materials, std::vector<Mesh *> &meshes);
-	Model *loadFromFile(const std::string &name);
+	void readModel(ModelLoad *load) const;
+	void finishModel(ModelLoad *load); // GL thread
+	ModelAsset *getAsset(const std::string &name);
+
+	// New materials and meshes drawing the shared geometry
+	Model *createModel(const std::string &name, const ModelAsset *asset);
 
 public:
-	ModelManager(std::string dataPath, GraphicsManager *graphicsManager);
+	ModelManager(std::string dataPath, GraphicsManager *graphicsManager, AssetLoader *loader);
 	~ModelManager();
 
 	// No copying/moving
@@ -38,7 +81,14 @@ public:
 	ModelManager(const ModelManager &&) = delete;
 	ModelManager &operator=(const ModelManager &&) = delete;
 
-	// Unmanaged memory
+	// Starts reading the model on a worker, its textures are decoded once it completed.
+	// Ignored if it is already loaded or requested
+	void RequestModel(const std::string &name);
+	bool IsModelReady(const std::string &name) const;
+
+	// Unmanaged memory. Models are imported once, later loads share their vertex and
+	// index buffers and only get their own transform and materials. Waits for requested
+	// models, requesting them first lets several load at once
 	Model *LoadModel(const std::string &name);
 
 	// Managed memory
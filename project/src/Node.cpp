@@ -2,7 +2,8 @@
 #include <utility>
 
 Node::Node(std::string name, Node *parent)
-	: m_Name(std::move(name)), m_Parent(parent), m_IsActive(true)
+	: m_Name(std::move(name)), m_Parent(parent), m_IsActive(true), m_Unbounded(false), m_ChildHierarchy(nullptr),
+	m_ChildrenChanged(false), m_ActiveChildCount(0)
 {
 }
 
@@ -24,6 +25,7 @@ void Node::AddChild(Node *node)
 	node->m_Parent = this;
 	node->m_Transform.SetParent(&m_Transform);
 	m_Children.push_back(node);
+	m_ChildrenChanged = true;
 }
 
 void Node::RemoveChild(Node *node)
@@ -36,6 +38,7 @@ void Node::RemoveChild(Node *node)
 		if (*it == node)
 		{
 			m_Children.erase(it);
+			m_ChildrenChanged = true;
 			break;
 		}
 		++it;
@@ -60,8 +63,122 @@ void Node::SetActive(bool active)
 	m_IsActive = active;
 }
 
+NodeBoundsType Node::GetLocalBounds(BoundingBox &bounds) const
+{
+	return kNodeBoundsType_None;
+}
+
+void Node::UpdateBounds()
+{
+	m_WorldBounds = BoundingBox();
+	m_Unbounded = false;
+
+	BoundingBox localBounds;
+	switch (GetLocalBounds(localBounds))
+	{
+	case kNodeBoundsType_Box:
+		m_WorldBounds = localBounds.Transform(m_Transform.GetMatrix());
+		break;
+	case kNodeBoundsType_Infinite:
+		m_Unbounded = true;
+		break;
+	default:
+		break;
+	}
+
+	if (m_ChildHierarchy && m_ChildrenChanged)
+		m_ChildHierarchy->Reset(static_cast<unsigned int>(m_Children.size()));
+
+	m_ChildrenChanged = false;
+	m_ActiveChildCount = 0;
+
+	// Children are merged so a culled node culls its whole subtree
+	for (size_t i = 0; i < m_Children.size(); i++)
+	{
+		const auto node = m_Children[i];
+		if (!node->m_IsActive)
+		{
+			// Inactive children are never returned by the hierarchy
+			if (m_ChildHierarchy)
+				m_ChildHierarchy->SetBounds(static_cast<unsigned int>(i), BoundingBox());
+			continue;
+		}
+
+		node->UpdateBounds();
+		m_WorldBounds.Add(node->m_WorldBounds);
+		m_Unbounded |= node->m_Unbounded;
+		m_ActiveChildCount++;
+
+		// Only children that moved refit the hierarchy
+		if (m_ChildHierarchy)
+		{
+			if (node->m_Unbounded)
+				m_ChildHierarchy->SetUnbounded(static_cast<unsigned int>(i));
+			else m_ChildHierarchy->SetBounds(static_cast<unsigned int>(i), node->m_WorldBounds);
+		}
+	}
+
+	if (m_ChildHierarchy)
+		m_ChildHierarchy->Update();
+}
+
+const BoundingBox &Node::GetWorldBounds() const
+{
+	return m_WorldBounds;
+}
+
+bool Node::HasChildHierarchy() const
+{
+	return m_ChildHierarchy != nullptr;
+}
+
+void Node::SetChildHierarchy(bool enabled)
+{
+	if (enabled == HasChildHierarchy())
+		return;
+
+	if (enabled)
+	{
+		m_ChildHierarchy = New<BoundingVolumeHierarchy>();
+		m_ChildrenChanged = true;
+	}
+	else
+	{
+		Delete(m_ChildHierarchy);
+		m_ChildHierarchy = nullptr;
+	}
+}
+
+Node *Node::Pick(const Ray &ray, float &distance)
+{
+	if (m_ChildHierarchy && !m_ChildrenChanged)
+	{
+		unsigned int index;
+		return m_ChildHierarchy->Raycast(ray, index, distance) ? m_Children[index] : nullptr;
+	}
+
+	Node *result = nullptr;
+	for (auto node : m_Children)
+	{
+		if (!node->m_IsActive || node->m_Unbounded)
+			continue;
+
+		float near, far;
+		if (node->m_WorldBounds.Intersects(ray, near, far) && near >= 0.0f && (!result || near < distance))
+		{
+			result = node;
+			distance = near;
+		}
+	}
+
+	return result;
+}
+
 Node::~Node()
 {
+	if (m_ChildHierarchy)
+		Delete(m_ChildHierarchy);
+
 	for (auto obj : m_Children)
 		Delete(obj);
 
@@ -76,7 +193,43 @@ void Node::Compile()
 
 void Node::Render(RenderContext *context)
 {
+	const auto inside = context->FrustumInside;
+	if (m_ChildHierarchy && !inside)
+	{
+		// Only children touching the frustum, the hierarchy tests their bounds
+		const auto &results = m_ChildHierarchy->Query(context->Frustum);
+		for (const auto &result : results)
+		{
+			context->FrustumInside = result.Inside;
+			context->NodesVisible++;
+			m_Children[result.Index]->Render(context);
+		}
+
+		context->NodesCulled += m_ActiveChildCount - static_cast<unsigned int>(results.size());
+		context->FrustumInside = inside;
+		return;
+	}
+
 	for (auto node : m_Children)
-		if (node->m_IsActive)
-			node->Render(context);
+	{
+		if (!node->m_IsActive)
+			continue;
+
+		// Skip subtrees outside the frustum, fully visible ones are not tested further down
+		if (!inside && !node->m_Unbounded)
+		{
+			const auto containment = context->Frustum.Contains(node->m_WorldBounds);
+			if (containment == kContainmentType_Disjoint)
+			{
+				context->NodesCulled++;
+				continue;
+			}
+
+			context->FrustumInside = containment == kContainmentType_Contains;
+		}
+
+		context->NodesVisible++;
+		node->Render(context);
+		context->FrustumInside = inside;
+	}
 }
\ No newline at end of file
@@ -2,19 +2,41 @@
 
 #include "GraphicsManager.h"
 #include "Transform.h"
+#include "Bounds.h"
+#include "BoundingVolumeHierarchy.h"
 #include "Memory.h"
 #include "Utility/Exception.h"
 #include <vector>
 
 class Camera;
+class RenderQueue;
 struct RenderContext
 {
 	GraphicsManager *GraphicsManager;
 	Camera *Camera;
+	RenderQueue *Queue;
 
 	glm::mat4 ViewMatrix;
 	glm::mat4 ProjectionMatrix;
 	glm::mat4 TransformMatrix;
+
+	// Culling
+	BoundingFrustum Frustum;
+	bool FrustumInside; // Current subtree is fully visible, children are not tested
+	unsigned int NodesVisible;
+	unsigned int NodesCulled;
+
+	// Level of detail
+	glm::vec3 ViewPosition;
+	float LodScale; // Screen size of a bounding sphere is radius * LodScale / distance
+	unsigned int LodTrianglesSaved; // By drawing coarser levels than the full meshes
+};
+
+enum NodeBoundsType
+{
+	kNodeBoundsType_None, // Draws nothing itself
+	kNodeBoundsType_Box,
+	kNodeBoundsType_Infinite // Never culled
 };
 
 DEFINE_EXCEPTION(NodeNotFoundException);
@@ -28,6 +50,15 @@ protected:
 	Transform m_Transform;
 	bool m_IsActive;
 
+	// Subtree bounds in world space, refreshed by UpdateBounds
+	BoundingBox m_WorldBounds;
+	bool m_Unbounded;
+
+	// Optional tree over the children, indexed like m_Children
+	BoundingVolumeHierarchy *m_ChildHierarchy;
+	bool m_ChildrenChanged;
+	unsigned int m_ActiveChildCount; // As of the last UpdateBounds
+
 public:
 	Node(std::string name = "Node", Node *parent = nullptr);
 
@@ -43,6 +74,7 @@ public:
 		auto node = New<TNode>(args...);
 		node->m_Parent = this;
 		m_Children.push_back(node);
+		m_ChildrenChanged = true;
 		return node;
 	}
 
@@ -89,6 +121,22 @@ public:
 	bool IsActive() const;
 	void SetActive(bool active);
 
+	// Bounds of what this node draws itself, relative to its transform
+	virtual NodeBoundsType GetLocalBounds(BoundingBox &bounds) const;
+
+	// Refreshes world bounds of the subtree, call before culling
+	void UpdateBounds();
+	const BoundingBox &GetWorldBounds() const;
+
+	// Culls and picks children through a bounding volume hierarchy instead of testing each one,
+	// worth it for nodes with many children
+	bool HasChildHierarchy() const;
+	void SetChildHierarchy(bool enabled);
+
+	// Closest child whose subtree bounds the ray enters, as of the last UpdateBounds.
+	// Children around the ray origin are ignored
+	Node *Pick(const Ray &ray, float &distance);
+
 	virtual ~Node();
 
 	virtual void Compile();
@@ -1,7 +1,8 @@
 #include "Object.h"
+#include "JobSystem.h"
 
 Object::Object(std::string name, Object *parent)
-	: m_Name(std::move(name)), m_IsActive(true), m_Parent(parent)
+	: m_Name(std::move(name)), m_IsActive(true), m_Parent(parent), m_JobSystem(nullptr), m_ParallelGrainSize(OBJECT_PARALLEL_GRAIN_SIZE)
 {
 }
 
@@ -25,6 +26,12 @@ Object *Object::GetParent() const
 	return m_Parent;
 }
 
+void Object::SetParallelUpdate(JobSystem *jobSystem, unsigned int grainSize)
+{
+	m_JobSystem = jobSystem;
+	m_ParallelGrainSize = grainSize;
+}
+
 void Object::AddChild(Object *obj)
 {
 	if (obj->m_Parent)
@@ -62,6 +69,21 @@ Object::~Object()
 
 void Object::Update(float time, float deltaTime)
 {
+	if (m_JobSystem)
+	{
+		// Fan subtrees out across the workers
+		Transform::BeginParallelUpdate();
+		m_JobSystem->ParallelFor(m_Children.size(), m_ParallelGrainSize, [&](unsigned int begin, unsigned int end)
+		{
+			for (auto i = begin; i < end; i++)
+				if (m_Children[i]->m_IsActive)
+					m_Children[i]->Update(time, deltaTime);
+		});
+		Transform::EndParallelUpdate();
+
+		return;
+	}
+
 	// Update all children
 	for (auto obj : m_Children)
 		if (obj->m_IsActive)
@@ -7,8 +7,14 @@
 #include <vector>
 #include <memory>
 
+#ifndef OBJECT_PARALLEL_GRAIN_SIZE
+#define OBJECT_PARALLEL_GRAIN_SIZE 64 // Children per job when updating in parallel
+#endif
+
 DEFINE_EXCEPTION(ObjectNotFoundException);
 
+class JobSystem;
+
 class Object
 {
 protected:
@@ -17,6 +23,10 @@ protected:
 	Object *m_Parent;
 	std::vector<Object *> m_Children;
 
+	// Set to update children as jobs
+	JobSystem *m_JobSystem;
+	unsigned int m_ParallelGrainSize;
+
 public:
 	Object(std::string name = "Object", Object *parent = nullptr);
 
@@ -34,6 +44,10 @@ public:
 
 	Object *GetParent() const;
 
+	// Children are updated as independent jobs, a child may only write to its own subtree
+	// and transforms, see Transform::BeginParallelUpdate. Pass nullptr to update serially
+	void SetParallelUpdate(JobSystem *jobSystem, unsigned int grainSize = OBJECT_PARALLEL_GRAIN_SIZE);
+
 	void AddChild(Object *obj);
 	void RemoveChild(Object *obj);
 
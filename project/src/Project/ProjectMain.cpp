@@ -5,6 +5,8 @@
 #include "../LightManager.h"
 #include "../Camera.h"
 #include "../Object.h"
+#include "../JobSystem.h"
+#include "../AssetLoader.h"
 #include "UVSphere.h"
 #include "Util.h"
 #include "Star.h"
@@ -12,10 +14,13 @@
 
 //#define NO_SKYBOX
 //#define NO_PLANETS
+//#define NO_STAR_INSTANCING
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
 
 #define SOLAR_SYSTEM_RADIUS 350.0f
 #define GET_DISTANCE(x) (x * SOLAR_SYSTEM_RADIUS)
@@ -59,6 +64,10 @@ const float NeptuneSpeed = 0.075f;
 #endif
 
 const int StarResolution = 12;
+#ifdef NO_STAR_INSTANCING
+const int StarLodResolutions[] = { 8, 5 };
+const float StarLodScreenSizes[] = { 0.05f, 0.01f };
+#endif
 const int StarCount = 500;
 const float StarInnerRadius = SOLAR_SYSTEM_RADIUS * 1.5f;
 const float StarOuterRadius = SOLAR_SYSTEM_RADIUS * 2.5f;
@@ -81,6 +90,27 @@ const float CameraSpeed = 0.5f;
 const float ShipScale = 0.0025f;
 const float ShipStartDistance = GET_DISTANCE(1.0f);
 const float ShipStartHeight = GET_DISTANCE(0.25f);
+const unsigned int ShipTrailLength = 512; // Positions recorded per ship
+
+// Light benchmark
+const unsigned int LightBenchmarkMinCount = 100;
+const unsigned int LightBenchmarkMaxCount = 800;
+const unsigned int LightBenchmarkStep = 100;
+const unsigned int LightBenchmarkFrames = 120; // Per light count
+const float LightBenchmarkRange = 40.0f;
+
+// Loading
+const int JobWorkerCount = -1; // Threads updating objects and loading assets, -1 for one less than the hardware threads
+const size_t TextureUploadBudget = 2 * 1024 * 1024; // Bytes of texture data uploaded per frame
+const unsigned int SceneUpdateGrainSize = 2; // Orbits or ship animations per job
+
+struct PlanetOrbit
+{
+	Model *Planet;
+	float *Rotation;
+	float Speed;
+	float Distance;
+};
 
 // Vars
 unsigned int g_Width;
@@ -91,6 +121,10 @@ Window *g_RootWindow;
 GraphicsManager *g_GraphicsManager;
 ModelManager *g_ModelManager;
 LightManager *g_LightManager;
+JobSystem *g_JobSystem;
+AssetLoader *g_AssetLoader;
+std::chrono::steady_clock::time_point g_LoadStartTime;
+bool g_LoadReported;
 
 Camera *g_Camera;
 Object *g_RootObject;
@@ -98,6 +132,9 @@ Node *g_RootNode;
 
 // Shaders
 Shader *g_FlatShader;
+#ifndef NO_STAR_INSTANCING
+Shader *g_StarShader;
+#endif
 #ifndef NO_SKYBOX
 Shader *g_FakeSkyboxShader;
 #endif
@@ -112,6 +149,7 @@ std::vector<Model *> g_Models;
 Model *g_SkyboxModel;
 #endif
 Model *g_SunModel;
+MaterialVariable *g_SunDiffuse;
 #ifndef NO_PLANETS
 Model *g_MercuryModel;
 Model *g_VenusModel;
@@ -128,7 +166,12 @@ Model *g_ShipModel3;
 Model *g_ShipModel4;
 
 // Stars
+#ifdef NO_STAR_INSTANCING
 Mesh *g_StarMesh;
+std::vector<ModelLod> g_StarLods;
+#else
+StarMesh *g_StarMesh;
+#endif
 Material *g_StarMaterial;
 
 // Camera
@@ -159,25 +202,114 @@ Animation *g_AnimationShip2;
 Animation *g_AnimationShip3;
 Animation *g_AnimationShip4;
 
+// Ship trails, ring buffer of the last ShipTrailLength positions of every ship
+std::vector<glm::vec3> g_ShipTrail;
+size_t g_ShipTrailNext;
+
+// Light benchmark
+std::vector<PointLight *> g_BenchmarkLights;
+bool g_LightBenchmarkRunning;
+unsigned int g_LightBenchmarkFrame;
+float g_LightBenchmarkFrameTime;
+float g_LightBenchmarkAssignTime;
+std::chrono::steady_clock::time_point g_LightBenchmarkLastFrame; // Frames are timed render to render
+
+void SetBenchmarkLightCount(unsigned int count)
+{
+	for (const auto &light : g_BenchmarkLights)
+		g_LightManager->RemoveLight(light);
+	g_BenchmarkLights.clear();
+
+	if (g_ShipTrail.empty())
+		return;
+
+	// Scatter lights along the recorded ship paths
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const auto light = g_LightManager->CreateLight<PointLight>();
+		light->SetAmbient(glm::vec3(0.0f));
+		light->SetDiffuse(glm::vec3(RandomFloat(0.2f, 1.0f), RandomFloat(0.2f, 1.0f), RandomFloat(0.2f, 1.0f)));
+		light->SetSpecular(glm::vec3(0.5f));
+		light->SetIntensity(1.0f);
+		light->SetRange(LightBenchmarkRange);
+		light->SetPosition(g_ShipTrail[RandomInt(0, g_ShipTrail.size())]);
+
+		g_BenchmarkLights.push_back(light);
+	}
+}
+
+void StartLightBenchmark()
+{
+	g_LightBenchmarkRunning = true;
+	g_LightBenchmarkFrame = 0;
+	g_LightBenchmarkFrameTime = 0.0f;
+	g_LightBenchmarkAssignTime = 0.0f;
+	g_LightBenchmarkLastFrame = std::chrono::steady_clock::now();
+
+	SetBenchmarkLightCount(LightBenchmarkMinCount);
+
+	LOG_INFO("Sim", "Light benchmark started, %u to %u lights", LightBenchmarkMinCount, LightBenchmarkMaxCount);
+}
+
+void UpdateLightBenchmark()
+{
+	if (!g_LightBenchmarkRunning)
+		return;
+
+	// The render delta time is measured from the last update, not the last frame
+	const auto now = std::chrono::steady_clock::now();
+	g_LightBenchmarkFrameTime += std::chrono::duration<float, std::milli>(now - g_LightBenchmarkLastFrame).count();
+	g_LightBenchmarkLastFrame = now;
+	g_LightBenchmarkAssignTime += g_LightManager->GetStats().AssignTime;
+	if (++g_LightBenchmarkFrame < LightBenchmarkFrames)
+		return;
+
+	// Report the average of this light count and move on to the next
+	const auto count = static_cast<unsigned int>(g_BenchmarkLights.size());
+	LOG_INFO("Sim", "%u lights: %.3f ms per frame, %.3f ms cluster assignment, %u cluster entries", count,
+		g_LightBenchmarkFrameTime / LightBenchmarkFrames, g_LightBenchmarkAssignTime / LightBenchmarkFrames,
+		g_LightManager->GetStats().ClusterIndices);
+
+	g_LightBenchmarkFrame = 0;
+	g_LightBenchmarkFrameTime = 0.0f;
+	g_LightBenchmarkAssignTime = 0.0f;
+
+	if (count + LightBenchmarkStep > LightBenchmarkMaxCount)
+	{
+		SetBenchmarkLightCount(0);
+		g_LightBenchmarkRunning = false;
+
+		LOG_INFO("Sim", "Light benchmark finished");
+	}
+	else SetBenchmarkLightCount(count + LightBenchmarkStep);
+}
+
 // For stars
-void CreateSphereMesh(int resolution, Shader *matShader, Mesh **outMesh, Material **outMaterial)
+void CreateSphereVertices(int resolution, std::vector<MeshVertex> &outVertices, std::vector<unsigned int> &outIndices)
 {
 	// Generate mesh
 	const UVSphere sphere(resolution, resolution, 1.0f);
 
-	// Create material
-	*outMaterial = New<Material>("Material", matShader);
-
 	// Get indices
-	const auto &indices = sphere.GetIndices();
+	outIndices = sphere.GetIndices();
 
 	// Store vertices
-	std::vector<MeshVertex> vertices;
 	const auto &positions = sphere.GetPositions();
 	const auto &normals = sphere.GetNormals();
 	const auto &texCoords = sphere.GetTextureCoords();
 	for (size_t j = 0; j < positions.size(); j++)
-		vertices.emplace_back(positions[j], normals[j], texCoords[j]);
+		outVertices.emplace_back(positions[j], normals[j], texCoords[j]);
+}
+
+void CreateSphereMesh(int resolution, Shader *matShader, Mesh **outMesh, Material **outMaterial)
+{
+	// Create material
+	*outMaterial = New<Material>("Material", matShader);
+
+	// Generate vertices
+	std::vector<MeshVertex> vertices;
+	std::vector<unsigned int> indices;
+	CreateSphereVertices(resolution, vertices, indices);
 
 	// Create mesh
 	*outMesh = New<Mesh>("Sphere", vertices, indices, *outMaterial);
@@ -192,12 +324,16 @@ void CreateScene()
 	g_Camera->SetClearColor(CameraClearColor);
 	g_Camera->SetClearDepth(CameraClearDepth);
 
-	// Add shaders to camera
-	g_Camera->AddShader(g_FlatShader);
-	g_Camera->AddShader(g_LightShader);
+	// Read every model on the workers at once, each load below waits for its own
 #ifndef NO_SKYBOX
-	g_Camera->AddShader(g_FakeSkyboxShader);
+	g_ModelManager->RequestModel("Skybox");
+#endif
+	g_ModelManager->RequestModel("Sun");
+#ifndef NO_PLANETS
+	for (const auto name : { "Mercury", "Venus", "Earth", "Mars", "Jupiter", "Saturn", "Uranus", "Neptune" })
+		g_ModelManager->RequestModel(name);
 #endif
+	g_ModelManager->RequestModel("Ship");
 
 #ifndef NO_SKYBOX
 	// Create skybox
@@ -222,8 +358,8 @@ void CreateScene()
 
 	// Get sun material
 	const auto sunMaterial = g_SunModel->GetMaterial("Material");
-	const auto sunDiffuse = sunMaterial->GetVariable("u_Material.Diffuse");
-	sunDiffuse->SetVec3(glm::vec3(SunMinBrightness));
+	g_SunDiffuse = sunMaterial->GetVariable(kMaterialVar_Diffuse);
+	g_SunDiffuse->SetVec3(glm::vec3(SunMinBrightness));
 
 	// Create point light (at sun)
 	g_SunLight = g_LightManager->CreateLight<PointLight>();
@@ -390,13 +526,41 @@ void CreateScene()
 
 	LOG_TRACE("Sim", "Ship loaded");
 
+#ifdef NO_STAR_INSTANCING
 	// Create star mesh
 	CreateSphereMesh(StarResolution, g_FlatShader, &g_StarMesh, &g_StarMaterial);
 	g_StarMaterial->GetShader()->Use();
 	g_StarMaterial->GetVariable(kMaterialVar_Diffuse)->SetVec3(glm::vec3(0.8f, 0.8f, 0.8f));
 
+	// Create coarser star meshes, distant stars cover a few pixels
+	for (size_t i = 0; i < sizeof(StarLodResolutions) / sizeof(StarLodResolutions[0]); i++)
+	{
+		std::vector<MeshVertex> lodVertices;
+		std::vector<unsigned int> lodIndices;
+		CreateSphereVertices(StarLodResolutions[i], lodVertices, lodIndices);
+
+		ModelLod lod;
+		lod.Meshes.push_back(New<Mesh>("Sphere", lodVertices, lodIndices, g_StarMaterial));
+		lod.ScreenSize = StarLodScreenSizes[i];
+		g_StarLods.push_back(lod);
+	}
+
 	// Generate star field
-	CreateStarField(StarCount, StarInnerRadius, StarOuterRadius, StarMinSize, StarMaxSize, g_StarMesh, g_StarMaterial, g_RootObject, g_RootNode);
+	CreateStarField(StarCount, StarInnerRadius, StarOuterRadius, StarMinSize, StarMaxSize, g_StarMesh, g_StarLods, g_StarMaterial, 
+		g_RootObject, g_RootNode);
+#else
+	// Create star material
+	g_StarMaterial = New<Material>("Material", g_StarShader);
+	g_StarMaterial->GetShader()->Use();
+	g_StarMaterial->GetVariable(kMaterialVar_Diffuse)->SetVec3(glm::vec3(0.8f, 0.8f, 0.8f));
+
+	// Generate star field, all stars are drawn with one call and twinkle on the GPU
+	std::vector<MeshVertex> starVertices;
+	std::vector<unsigned int> starIndices;
+	CreateSphereVertices(StarResolution, starVertices, starIndices);
+	g_StarMesh = CreateInstancedStarField(StarCount, StarInnerRadius, StarOuterRadius, StarMinSize, StarMaxSize, starVertices, starIndices, 
+		g_StarMaterial, g_RootObject, g_RootNode); // Owned by root node
+#endif
 
 	LOG_TRACE("Sim", "Generated star field");
 
@@ -413,6 +577,17 @@ void Project_Update(float time, float deltaTime)
 	const auto timeSeconds = time / 1000.0f;
 	const auto deltaTimeSeconds = deltaTime / 1000.0f;
 
+	// Finish loads decoded since the last frame and stream their textures within the budget
+	g_AssetLoader->Update();
+	g_GraphicsManager->Update();
+	if (!g_LoadReported && g_AssetLoader->GetPendingCount() == 0 && g_GraphicsManager->GetTextureStreamer()->GetPendingCount() == 0)
+	{
+		g_LoadReported = true;
+		LOG_INFO("Sim", "All assets loaded in %.1f ms with %u workers, textures use %.1f MB", 
+			std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - g_LoadStartTime).count(),
+			g_JobSystem->GetWorkerCount(), g_GraphicsManager->GetTextureMemorySize() / (1024.0f * 1024.0f));
+	}
+
 	// Update sun
 	{
 		// Update scale
@@ -433,103 +608,67 @@ void Project_Update(float time, float deltaTime)
 		// Calculate lighting
 		const auto lightDiffuse = SunMaxBrightness * abs(sin(g_SunBrightness)) + SunMinBrightness * abs(cos(g_SunBrightness));
 
-		// Get sun material
-		const auto sunMaterial = g_SunModel->GetMaterial("Material");
-		const auto sunDiffuse = sunMaterial->GetVariable("u_Material.Diffuse");
-		sunDiffuse->SetVec3(glm::vec3(lightDiffuse));
+		// Set sun brightness
+		g_SunDiffuse->SetVec3(glm::vec3(lightDiffuse));
 
 		// Update point light (sunlight)
 		g_SunLight->SetDiffuse(glm::vec3(lightDiffuse));
 	}
 
+	// Orbits and ship animations only write their own transform, so they run as jobs. Their
+	// shared parent is resolved first
 #ifndef NO_PLANETS
-	// Update mercury
-	{
-		// Update rotation
-		g_MercuryRotation += MercurySpeed * deltaTimeSeconds;
-
-		// Update transform
-		const auto mercuryTransform = g_MercuryModel->GetTransform();
-		mercuryTransform->SetPosition(glm::vec3(MercuryDistance * sin(g_MercuryRotation), 0.0f, MercuryDistance * cos(g_MercuryRotation)));
-	}
-
-	// Update venus
-	{
-		// Update rotation
-		g_VenusRotation += VenusSpeed * deltaTimeSeconds;
-
-		// Update transform
-		const auto venusTransform = g_VenusModel->GetTransform();
-		venusTransform->SetPosition(glm::vec3(VenusDistance * sin(g_VenusRotation), 0.0f, VenusDistance * cos(g_VenusRotation)));
-	}
-
-	// Update earth
+	const PlanetOrbit orbits[] =
 	{
-		// Update rotation
-		g_EarthRotation += EarthSpeed * deltaTimeSeconds;
-
-		// Update transform
-		const auto earthTransform = g_EarthModel->GetTransform();
-		earthTransform->SetPosition(glm::vec3(EarthDistance * sin(g_EarthRotation), 0.0f, EarthDistance * cos(g_EarthRotation)));
-	}
-
-	// Update mars
-	{
-		// Update rotation
-		g_MarsRotation += MarsSpeed * deltaTimeSeconds;
-
-		// Update transform
-		const auto marsTransform = g_MarsModel->GetTransform();
-		marsTransform->SetPosition(glm::vec3(MarsDistance * sin(g_MarsRotation), 0.0f, MarsDistance * cos(g_MarsRotation)));
-	}
+		{ g_MercuryModel, &g_MercuryRotation, MercurySpeed, MercuryDistance },
+		{ g_VenusModel, &g_VenusRotation, VenusSpeed, VenusDistance },
+		{ g_EarthModel, &g_EarthRotation, EarthSpeed, EarthDistance },
+		{ g_MarsModel, &g_MarsRotation, MarsSpeed, MarsDistance },
+		{ g_JupiterModel, &g_JupiterRotation, JupiterSpeed, JupiterDistance },
+		{ g_SaturnModel, &g_SaturnRotation, SaturnSpeed, SaturnDistance },
+		{ g_UranusModel, &g_UranusRotation, UranusSpeed, UranusDistance },
+		{ g_NeptuneModel, &g_NeptuneRotation, NeptuneSpeed, NeptuneDistance }
+	};
+	const unsigned int orbitCount = sizeof(orbits) / sizeof(orbits[0]);
+#else
+	const PlanetOrbit *orbits = nullptr;
+	const unsigned int orbitCount = 0;
+#endif
+	Animation *const shipAnimations[] = { g_AnimationShip1, g_AnimationShip2, g_AnimationShip3, g_AnimationShip4 };
 
-	// Update jupiter
+	g_RootNode->GetTransform()->GetMatrix();
+	Transform::BeginParallelUpdate();
+	g_JobSystem->ParallelFor(orbitCount + 4, SceneUpdateGrainSize, [&](unsigned int begin, unsigned int end)
 	{
-		// Update rotation
-		g_JupiterRotation += JupiterSpeed * deltaTimeSeconds;
-
-		// Update transform
-		const auto jupiterTransform = g_JupiterModel->GetTransform();
-		jupiterTransform->SetPosition(glm::vec3(JupiterDistance * sin(g_JupiterRotation), 0.0f, JupiterDistance * cos(g_JupiterRotation)));
-	}
-
-	// Update saturn
+		for (auto i = begin; i < end; i++)
+		{
+			if (i >= orbitCount)
+			{
+				shipAnimations[i - orbitCount]->Update(time);
+				continue;
+			}
+
+			// Update rotation
+			const auto &orbit = orbits[i];
+			*orbit.Rotation += orbit.Speed * deltaTimeSeconds;
+
+			// Update transform
+			orbit.Planet->GetTransform()->SetPosition(glm::vec3(orbit.Distance * sin(*orbit.Rotation), 0.0f, 
+				orbit.Distance * cos(*orbit.Rotation)));
+		}
+	});
+	Transform::EndParallelUpdate();
+
+	// Record ship trails
+	for (const auto &ship : { g_ShipModel1, g_ShipModel2, g_ShipModel3, g_ShipModel4 })
 	{
-		// Update rotation
-		g_SaturnRotation += SaturnSpeed * deltaTimeSeconds;
-
-		// Update transform
-		const auto saturnTransform = g_SaturnModel->GetTransform();
-		saturnTransform->SetPosition(glm::vec3(SaturnDistance * sin(g_SaturnRotation), 0.0f, SaturnDistance * cos(g_SaturnRotation)));
+		const auto position = ship->GetTransform()->GetPosition();
+		if (g_ShipTrail.size() < ShipTrailLength * 4)
+			g_ShipTrail.push_back(position);
+		else g_ShipTrail[g_ShipTrailNext] = position;
+		g_ShipTrailNext = (g_ShipTrailNext + 1) % (ShipTrailLength * 4);
 	}
 
-	// Update uranus
-	{
-		// Update rotation
-		g_UranusRotation += UranusSpeed * deltaTimeSeconds;
-
-		// Update transform
-		const auto uranusTransform = g_UranusModel->GetTransform();
-		uranusTransform->SetPosition(glm::vec3(UranusDistance * sin(g_UranusRotation), 0.0f, UranusDistance * cos(g_UranusRotation)));
-	}
-
-	// Update neptune
-	{
-		// Update rotation
-		g_NeptuneRotation += NeptuneSpeed * deltaTimeSeconds;
-
-		// Update transform
-		const auto neptuneTransform = g_NeptuneModel->GetTransform();
-		neptuneTransform->SetPosition(glm::vec3(NeptuneDistance * sin(g_NeptuneRotation), 0.0f, NeptuneDistance * cos(g_NeptuneRotation)));
-	}
-#endif
-
-	// Update animations
-	g_AnimationShip1->Update(time);
-	g_AnimationShip2->Update(time);
-	g_AnimationShip3->Update(time);
-	g_AnimationShip4->Update(time);
-
 	// Set camera transform
 	const auto targetModel = g_Models[g_LookTarget];
 	const auto targetTransform = targetModel->GetTransform();
@@ -558,10 +697,12 @@ void Project_Render(float time, float deltaTime)
 	g_RootObject->Render(time, deltaTime);
 
 	// Apply lighting
-	g_LightManager->Apply(g_LightShader, g_Camera->GetTransform()->GetPosition());
+	g_LightManager->Apply(g_Camera);
 
 	// Render camera and nodes
 	g_Camera->Render(g_RootNode, deltaTime);
+
+	UpdateLightBenchmark();
 }
 
 // Window events
@@ -616,6 +757,30 @@ void Project_WindowKeyPress(KeyPressEventArgs &args)
 		g_AnimationShip3->Reset(g_LastTime);
 		g_AnimationShip4->Reset(g_LastTime);
 	}
+	if (args.Char == 'm')
+	{
+		MemoryDumpStats("MemoryStats.csv");
+		MemoryDumpStats("MemoryStats.json");
+	}
+	if (args.Char == 'i')
+	{
+		const auto &stats = g_Camera->GetRenderStats();
+		LOG_INFO("Sim", "Last frame: %u draw calls, %u shader changes, %u material changes, %u vertex array changes",
+			stats.DrawCalls, stats.ShaderChanges, stats.MaterialChanges, stats.VertexArrayChanges);
+		LOG_INFO("Sim", "Last frame: %u texture binds for %u textures applied", stats.TextureBinds, stats.TextureRequests);
+		LOG_INFO("Sim", "Last frame: %u nodes visible, %u nodes culled", stats.NodesVisible, stats.NodesCulled);
+		LOG_INFO("Sim", "Last frame: %u triangles, %u without level of detail", stats.Triangles, stats.TrianglesWithoutLod);
+
+		const auto uniformStats = ShaderGetUniformStats();
+		LOG_INFO("Sim", "Last frame: %llu uniform uploads, %llu skipped (%llu/%llu total)",
+			uniformStats.FrameIssued, uniformStats.FrameSkipped, uniformStats.Issued, uniformStats.Skipped);
+
+		const auto &lightStats = g_LightManager->GetStats();
+		LOG_INFO("Sim", "Last frame: %u point lights, %u cluster entries, %.3f ms cluster assignment",
+			lightStats.PointLights, lightStats.ClusterIndices, lightStats.AssignTime);
+	}
+	if (args.Char == 'l' && !g_LightBenchmarkRunning)
+		StartLightBenchmark();
 }
 
 void Project_WindowMouseWheel(MouseEventArgs &args)
@@ -631,6 +796,31 @@ void Project_WindowMouseMove(MouseEventArgs &args)
 {
 }
 
+void Project_WindowMouseDown(MouseEventArgs &args)
+{
+	if (args.Button != kMouseButton_Left || g_Width == 0 || g_Height == 0)
+		return;
+
+	// Pick through the root hierarchy, uses the bounds of the last rendered frame
+	const auto ray = g_Camera->ScreenPointToRay(static_cast<float>(args.X), static_cast<float>(args.Y), 
+		static_cast<float>(g_Width), static_cast<float>(g_Height));
+
+	float distance;
+	const auto node = g_RootNode->Pick(ray, distance);
+	if (!node)
+		return;
+
+	const auto it = std::find(g_Models.begin(), g_Models.end(), node);
+	if (it == g_Models.end())
+	{
+		LOG_INFO("Sim", "Picked %s at distance %.2f", node->GetName().c_str(), distance);
+		return;
+	}
+
+	g_LookTarget = static_cast<int>(it - g_Models.begin());
+	LOG_INFO("Sim", "Current model %u: %s", g_LookTarget, g_Models[g_LookTarget]->GetName().c_str());
+}
+
 bool Project_Initialize(Window *window)
 {
 	// Store window
@@ -641,6 +831,7 @@ bool Project_Initialize(Window *window)
 	window->OnKeyDown.Add(Project_WindowKeyDown);
 	window->OnKeyPress.Add(Project_WindowKeyPress);
 	window->OnMouseMove.Add(Project_WindowMouseMove);
+	window->OnMouseDown.Add(Project_WindowMouseDown);
 	window->OnMouseWheel.Add(Project_WindowMouseWheel);
 
 	// Seed random with time
@@ -651,21 +842,42 @@ bool Project_Initialize(Window *window)
 
 	try
 	{
+		// Create job system
+		g_JobSystem = JobWorkerCount < 0 ? New<JobSystem>() : New<JobSystem>(static_cast<unsigned int>(JobWorkerCount));
+
+		// Create asset loader, files are read and decoded on the workers
+		g_AssetLoader = New<AssetLoader>(g_JobSystem);
+
+		// Stream textures without hitches while the scene animates
+		g_GraphicsManager->GetTextureStreamer()->SetBudget(TextureUploadBudget);
+
 		// Create model manager
-		g_ModelManager = New<ModelManager>("data/models", g_GraphicsManager);
+		g_ModelManager = New<ModelManager>("data/models", g_GraphicsManager, g_AssetLoader);
 
 		// Create light manager
-		g_LightManager = New<LightManager>();
+		g_LightManager = New<LightManager>(g_JobSystem);
 
 		// Create root object
 		g_RootObject = New<Object>("Root");
 
-		// Create root node
+#ifdef NO_STAR_INSTANCING
+		// Every star is a child of its own, updated in parallel. The instanced field is a single child
+		g_RootObject->SetParallelUpdate(g_JobSystem);
+#endif
+
+		// Create root node, its children are culled and picked through a hierarchy
 		g_RootNode = New<Node>("Root");
+		g_RootNode->SetChildHierarchy(true);
 
-		// Get flat shader
+		// Get flat shader, programs are linked from source on the first launch only
+		const auto shaderStartTime = std::chrono::steady_clock::now();
 		g_FlatShader = g_GraphicsManager->GetShader("Flat");
 
+#ifndef NO_STAR_INSTANCING
+		// Get star shader
+		g_StarShader = g_GraphicsManager->GetShader("Star");
+#endif
+
 #ifndef NO_SKYBOX
 		// Get fake skybox shader
 		g_FakeSkyboxShader = g_GraphicsManager->GetShader("FakeSkybox");
@@ -673,19 +885,29 @@ bool Project_Initialize(Window *window)
 
 		// Get lambert shader
 		g_LightShader = g_GraphicsManager->GetShader("Light");
+		LOG_INFO("Sim", "Shaders ready in %.1f ms",
+			std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - shaderStartTime).count());
 
 		// Print loading messages
 		LOG_INFO("Sim", "Loading, please wait...");
 
-		// Create scene
+		// Create scene, models come from their caches after the first launch and textures stream in afterwards
+		g_LoadStartTime = std::chrono::steady_clock::now();
 		CreateScene();
+		LOG_INFO("Sim", "Scene created in %.1f ms with %u workers",
+			std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - g_LoadStartTime).count(),
+			g_JobSystem->GetWorkerCount());
 
 		// Print instructions
 		LOG_INFO("Sim", "Solar System Animation");
 		LOG_INFO("Sim", "Instructions:");
 		LOG_INFO("Sim", "- Press 'c' to stop camera rotation");
 		LOG_INFO("Sim", "- Press 'r' to reset animations");
+		LOG_INFO("Sim", "- Press 'm' to write memory statistics to MemoryStats.csv/json");
+		LOG_INFO("Sim", "- Press 'i' to log draw calls, state changes, culled nodes, triangles, uniform uploads and light clusters of the last frame");
+		LOG_INFO("Sim", "- Press 'l' to benchmark frame time with hundreds of point lights along the ship paths");
 		LOG_INFO("Sim", "- Press left/right to navigate through the planets/stars/ships");
+		LOG_INFO("Sim", "- Click a planet/ship to look at it");
 		LOG_INFO("Sim", "- Use the mouse wheel to zoom in/out of the planet/star/ship");
 
 		LOG_INFO("Sim", "Available models: ");
@@ -712,16 +934,25 @@ bool Project_Initialize(Window *window)
 
 bool Project_Shutdown()
 {
+	// Finish loads still referring to the managers
+	g_AssetLoader->WaitAll();
+
 	Delete(g_AnimationShip4);
 	Delete(g_AnimationShip3);
 	Delete(g_AnimationShip2);
 	Delete(g_AnimationShip1);
 
+#ifdef NO_STAR_INSTANCING
+	for (auto &lod : g_StarLods)
+		Delete(lod.Meshes[0]);
 	Delete(g_StarMesh);
+#endif
 	Delete(g_StarMaterial);
 
 	Delete(g_RootNode);
 	Delete(g_RootObject);
+	Delete(g_JobSystem);
+	Delete(g_AssetLoader);
 	Delete(g_Camera);
 	Delete(g_LightManager);
 	Delete(g_ModelManager);
@@ -22,7 +22,40 @@ void Star::Render(float time, float deltaTime)
 {
 }
 
-void CreateStarField(int count, float innerRadius, float outerRadius, float minSize, float maxSize, Mesh *mesh, Material *material, Object *parentObj, Node *parentNode)
+StarInstance::StarInstance()
+	: Position(0.0f), ScaleRate(0.0f), Size(0.0f)
+{
+}
+
+StarInstance::StarInstance(const glm::vec3 &position, float scaleRate, float minSize, float maxSize)
+	: Position(position), ScaleRate(scaleRate), Size(minSize, maxSize)
+{
+}
+
+StarMesh::StarMesh(std::string name, std::vector<MeshVertex> vertices, std::vector<unsigned> indices, std::vector<StarInstance> instances, Material *material)
+	: IInstancedMesh(std::move(name), std::move(vertices), std::move(indices), std::move(instances), material, Buffer::kUsage_StaticDraw)
+{
+}
+
+StarField::StarField(std::string name, StarMesh *mesh)
+	: Object(std::move(name)), m_Mesh(mesh)
+{
+}
+
+void StarField::Update(float time, float deltaTime)
+{
+}
+
+void StarField::Render(float time, float deltaTime)
+{
+	// Twinkle is computed per vertex from the time
+	const auto shader = m_Mesh->GetMaterial()->GetShader();
+	shader->Use();
+	shader->GetVariable(kShaderVar_Time)->SetFloat(time / 1000.0f);
+}
+
+void CreateStarField(int count, float innerRadius, float outerRadius, float minSize, float maxSize, Mesh *mesh, const std::vector<ModelLod> &lods, 
+	Material *material, Object *parentObj, Node *parentNode)
 {
 	// Generate spheres of random sizes
 	for (auto i = 0; i < count; i++)
@@ -48,8 +81,57 @@ void CreateStarField(int count, float innerRadius, float outerRadius, float minS
 		std::vector<Material *> materials;
 		materials.push_back(material);
 		const auto model = parentNode->CreateChild<Model>("Star", meshes, materials, false); // Unmanaged memory
+		for (const auto &lod : lods)
+			model->AddLod(lod.Meshes, lod.ScreenSize);
 
 		// Create star
 		parentObj->CreateChild<Star>(String::Format("Star_%3d", i), model, pos, minSize, maxSize, scaleRate);
 	}
+}
+
+StarMesh *CreateInstancedStarField(int count, float innerRadius, float outerRadius, float minSize, float maxSize, const std::vector<MeshVertex> &vertices, 
+	const std::vector<unsigned int> &indices, Material *material, Object *parentObj, Node *parentNode)
+{
+	std::vector<StarInstance> instances;
+	instances.reserve(count);
+
+	// Generate spheres of random sizes
+	for (auto i = 0; i < count; i++)
+	{
+		// Create random position
+		auto posX = RandomFloat(innerRadius, outerRadius);
+		auto posY = RandomFloat(innerRadius, outerRadius);
+		auto posZ = RandomFloat(innerRadius, outerRadius);
+
+		// Negate positions
+		if (RandomInt(0, 2) == 0) posX *= -1.0f;
+		if (RandomInt(0, 2) == 0) posY *= -1.0f;
+		if (RandomInt(0, 2) == 0) posZ *= -1.0f;
+
+		const glm::vec3 pos(posX * sin(posX), posY, posZ * cos(posZ));
+
+		// Create random scale rate
+		const auto scaleRate = RandomFloat(0.25, 0.75);
+
+		instances.emplace_back(pos, scaleRate, minSize, maxSize);
+	}
+
+	// Bounds of every star at its largest twinkle
+	BoundingBox meshBounds;
+	for (const auto &v : vertices)
+		meshBounds.Add(v.Position);
+
+	BoundingBox bounds;
+	for (const auto &instance : instances)
+	{
+		const auto scale = instance.Size.x + instance.Size.y;
+		bounds.Add(BoundingBox(instance.Position + meshBounds.Min * scale, instance.Position + meshBounds.Max * scale));
+	}
+
+	// Create mesh holding every star, the instances are uploaded once
+	const auto mesh = parentNode->CreateChild<StarMesh>("Stars", vertices, indices, instances, material);
+	mesh->SetBounds(bounds);
+	parentObj->CreateChild<StarField>("StarField", mesh);
+
+	return mesh;
 }
\ No newline at end of file
@@ -29,4 +29,69 @@ public:
 	void Render(float time, float deltaTime) override;
 };
 
-void CreateStarField(int count, float innerRadius, float outerRadius, float minSize, float maxSize, Mesh *mesh, Material *material, Object *parentObj, Node *parentNode);
\ No newline at end of file
+// Twinkle parameters, the scale is computed in the vertex shader
+struct StarInstance
+{
+	glm::vec3 Position; // Float 3
+	float ScaleRate; // Float 1
+	glm::vec2 Size; // Float 2, min and max
+
+	StarInstance();
+	StarInstance(const glm::vec3 &position, float scaleRate, float minSize, float maxSize);
+};
+
+class StarVertexFormat : public VertexFormat<MeshVertex, StarInstance>
+{
+public:
+	StarVertexFormat()
+		: VertexFormat<MeshVertex, StarInstance>({
+			{ "Position", kVertexAttributeType_Float, 3, false, sizeof(float) },
+			{ "Normal", kVertexAttributeType_Float, 3, false, sizeof(float) },
+			{ "TexCoords", kVertexAttributeType_Float, 2, false, sizeof(float) }
+			}, {
+			{ "StarPosition", kVertexAttributeType_Float, 3, false, sizeof(float) },
+			{ "StarScaleRate", kVertexAttributeType_Float, 1, false, sizeof(float) },
+			{ "StarSize", kVertexAttributeType_Float, 2, false, sizeof(float) }
+			})
+	{
+	}
+};
+
+class StarMesh : public IInstancedMesh<MeshVertex, StarInstance, StarVertexFormat>
+{
+public:
+	StarMesh(std::string name, std::vector<MeshVertex> vertices, std::vector<unsigned int> indices, std::vector<StarInstance> instances, Material *material);
+	~StarMesh() = default;
+
+	// No copying/moving
+	StarMesh(const StarMesh &) = delete;
+	StarMesh &operator=(const StarMesh &) = delete;
+
+	StarMesh(const StarMesh &&) = delete;
+	StarMesh &operator=(const StarMesh &&) = delete;
+};
+
+// Only passes the time to the star shader, stars are never touched on the CPU
+class StarField : public Object
+{
+	StarMesh *m_Mesh;
+
+public:
+	StarField(std::string name, StarMesh *mesh);
+
+	// No copying/moving
+	StarField(const StarField &) = delete;
+	StarField &operator=(const StarField &) = delete;
+
+	StarField(const StarField &&) = delete;
+	StarField &operator=(const StarField &&) = delete;
+
+	void Update(float time, float deltaTime) override;
+	void Render(float time, float deltaTime) override;
+};
+
+// Levels in lods are shared by every star and not owned by them
+void CreateStarField(int count, float innerRadius, float outerRadius, float minSize, float maxSize, Mesh *mesh, const std::vector<ModelLod> &lods, 
+	Material *material, Object *parentObj, Node *parentNode);
+StarMesh *CreateInstancedStarField(int count, float innerRadius, float outerRadius, float minSize, float maxSize, const std::vector<MeshVertex> &vertices, 
+	const std::vector<unsigned int> &indices, Material *material, Object *parentObj, Node *parentNode);
\ No newline at end of file
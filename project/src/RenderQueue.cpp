@@ -0,0 +1,130 @@
+#include "RenderQueue.h"
+#include <algorithm>
+
+uint64_t RenderQueue::makeKey(Material *material, VertexArray *vertexArray)
+{
+	const uint64_t shader = material->GetShader()->GetID() & ((1ull << RENDER_KEY_SHADER_BITS) - 1);
+	const uint64_t mat = material->GetID() & ((1ull << RENDER_KEY_MATERIAL_BITS) - 1);
+	const uint64_t va = vertexArray->GetID() & ((1ull << RENDER_KEY_VERTEX_ARRAY_BITS) - 1);
+
+	return (shader << (RENDER_KEY_MATERIAL_BITS + RENDER_KEY_VERTEX_ARRAY_BITS)) | (mat << RENDER_KEY_VERTEX_ARRAY_BITS) | va;
+}
+
+RenderQueue::RenderQueue()
+	: m_Stats()
+{
+}
+
+void RenderQueue::Add(Material *material, VertexArray *vertexArray, VertexBuffer<void> *vertexBuffer, IndexBuffer *indexBuffer,
+	unsigned int indexCount, const glm::mat4 &transform)
+{
+	Add(material, vertexArray, vertexBuffer, indexBuffer, indexCount, nullptr, 0, transform);
+}
+
+void RenderQueue::Add(Material *material, VertexArray *vertexArray, VertexBuffer<void> *vertexBuffer, IndexBuffer *indexBuffer,
+	unsigned int indexCount, InstanceBuffer<void> *instanceBuffer, unsigned int instanceCount, const glm::mat4 &transform)
+{
+	RenderCommand command;
+	command.Key = makeKey(material, vertexArray);
+	command.Material = material;
+	command.VertexArray = vertexArray;
+	command.VertexBuffer = vertexBuffer;
+	command.InstanceBuffer = instanceBuffer;
+	command.IndexBuffer = indexBuffer;
+	command.IndexCount = indexCount;
+	command.InstanceCount = instanceCount;
+	command.Transform = transform;
+
+	m_Commands.push_back(command);
+}
+
+void RenderQueue::Clear()
+{
+	m_Commands.clear();
+}
+
+void RenderQueue::Submit(GraphicsManager *graphicsManager)
+{
+	m_Stats = {};
+	m_Stats.Commands = m_Commands.size();
+
+	// Sort indices rather than the commands, stable so equal keys keep traversal order
+	FrameVector<unsigned int> order(m_Commands.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = i;
+
+	std::stable_sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b)
+	{
+		return m_Commands[a].Key < m_Commands[b].Key;
+	});
+
+	const auto textureBinds = graphicsManager->GetTextureBindCount();
+	const auto textureRequests = graphicsManager->GetTextureRequestCount();
+
+	Shader *activeShader = nullptr;
+	Material *activeMaterial = nullptr;
+	VertexArray *activeVertexArray = nullptr;
+
+	for (const auto index : order)
+	{
+		const auto &command = m_Commands[index];
+		const auto shader = command.Material->GetShader();
+
+		// Only change state when the sorted keys differ
+		if (shader != activeShader)
+		{
+			graphicsManager->UseShader(shader);
+			activeShader = shader;
+			m_Stats.ShaderChanges++;
+		}
+
+		if (command.Material != activeMaterial)
+		{
+			command.Material->Apply(graphicsManager);
+			activeMaterial = command.Material;
+			m_Stats.MaterialChanges++;
+		}
+
+		if (command.VertexArray != activeVertexArray)
+		{
+			graphicsManager->Bind(command.VertexArray);
+			activeVertexArray = command.VertexArray;
+			m_Stats.VertexArrayChanges++;
+		}
+
+		// Buffer binds are elided by the graphics manager
+		graphicsManager->Bind(command.VertexBuffer);
+		graphicsManager->Bind(command.IndexBuffer);
+
+		shader->GetVariable(kShaderVar_Transform)->SetMat4(command.Transform);
+
+		if (command.InstanceBuffer)
+		{
+			graphicsManager->Bind(command.InstanceBuffer);
+			glDrawElementsInstanced(GL_TRIANGLES, command.IndexCount, GL_UNSIGNED_INT, nullptr, command.InstanceCount);
+			m_Stats.Triangles += command.IndexCount / 3 * command.InstanceCount;
+		}
+		else
+		{
+			glDrawElements(GL_TRIANGLES, command.IndexCount, GL_UNSIGNED_INT, nullptr);
+			m_Stats.Triangles += command.IndexCount / 3;
+		}
+
+		m_Stats.DrawCalls++;
+	}
+
+	m_Stats.TextureBinds = graphicsManager->GetTextureBindCount() - textureBinds;
+	m_Stats.TextureRequests = graphicsManager->GetTextureRequestCount() - textureRequests;
+
+	Clear();
+}
+
+unsigned int RenderQueue::GetCount() const
+{
+	return m_Commands.size();
+}
+
+const RenderStats &RenderQueue::GetStats() const
+{
+	return m_Stats;
+}
\ No newline at end of file
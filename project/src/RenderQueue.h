@@ -0,0 +1,92 @@
+#pragma once
+
+#include "GraphicsManager.h"
+#include "Material.h"
+#include "Memory.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// Sort key layout, most significant first: shader (16 bits), material (24 bits), vertex array (24 bits)
+#define RENDER_KEY_SHADER_BITS 16
+#define RENDER_KEY_MATERIAL_BITS 24
+#define RENDER_KEY_VERTEX_ARRAY_BITS 24
+
+struct RenderCommand
+{
+	uint64_t Key;
+
+	Material *Material;
+	VertexArray *VertexArray;
+	VertexBuffer<void> *VertexBuffer;
+	InstanceBuffer<void> *InstanceBuffer; // Optional
+	IndexBuffer *IndexBuffer;
+	unsigned int IndexCount;
+	unsigned int InstanceCount; // Zero for non instanced draws
+
+	glm::mat4 Transform;
+};
+
+struct RenderStats
+{
+	unsigned int Commands;
+	unsigned int DrawCalls;
+	unsigned int ShaderChanges;
+	unsigned int MaterialChanges;
+	unsigned int TextureBinds; // Textures not yet on a unit
+	unsigned int TextureRequests; // Including those already on a unit
+	unsigned int VertexArrayChanges;
+	unsigned int Triangles; // Including every instance
+
+	// Filled by the camera
+	unsigned int NodesVisible;
+	unsigned int NodesCulled;
+	unsigned int TrianglesWithoutLod; // Triangles if every model drew its full meshes
+};
+
+// Collects draws during scene traversal and submits them sorted by state,
+// commands live in frame memory so a queue must not outlive the frame
+class RenderQueue
+{
+	FrameVector<RenderCommand> m_Commands;
+	RenderStats m_Stats;
+
+	static uint64_t makeKey(Material *material, VertexArray *vertexArray);
+
+public:
+	RenderQueue();
+
+	// No copying/moving
+	RenderQueue(const RenderQueue &) = delete;
+	RenderQueue &operator=(const RenderQueue &) = delete;
+
+	RenderQueue(const RenderQueue &&) = delete;
+	RenderQueue &operator=(const RenderQueue &&) = delete;
+
+	void Add(Material *material, VertexArray *vertexArray, VertexBuffer<void> *vertexBuffer, IndexBuffer *indexBuffer,
+		unsigned int indexCount, const glm::mat4 &transform);
+	void Add(Material *material, VertexArray *vertexArray, VertexBuffer<void> *vertexBuffer, IndexBuffer *indexBuffer,
+		unsigned int indexCount, InstanceBuffer<void> *instanceBuffer, unsigned int instanceCount, const glm::mat4 &transform);
+
+	template<typename TVertex>
+	void Add(Material *material, VertexArray *vertexArray, VertexBuffer<TVertex> *vertexBuffer, IndexBuffer *indexBuffer,
+		unsigned int indexCount, const glm::mat4 &transform)
+	{
+		Add(material, vertexArray, reinterpret_cast<VertexBuffer<void> *>(vertexBuffer), indexBuffer, indexCount, transform);
+	}
+
+	template<typename TVertex, typename TInstance>
+	void Add(Material *material, VertexArray *vertexArray, VertexBuffer<TVertex> *vertexBuffer, IndexBuffer *indexBuffer,
+		unsigned int indexCount, InstanceBuffer<TInstance> *instanceBuffer, unsigned int instanceCount, const glm::mat4 &transform)
+	{
+		Add(material, vertexArray, reinterpret_cast<VertexBuffer<void> *>(vertexBuffer), indexBuffer, indexCount,
+			reinterpret_cast<InstanceBuffer<void> *>(instanceBuffer), instanceCount, transform);
+	}
+
+	void Clear();
+
+	// Sorts and draws all commands, then clears the queue
+	void Submit(GraphicsManager *graphicsManager);
+
+	unsigned int GetCount() const;
+	const RenderStats &GetStats() const; // Of the last submit
+};
\ No newline at end of file
@@ -1,10 +1,59 @@
 ﻿#include "Shader.h"
+#include "Log.h"
 #include "Memory.h"
+#include "Utility/FileUtil.h"
+#include <cstring>
 #include <utility>
 #include <glm/gtc/type_ptr.hpp>
 
+static const char *kShaderBlockNames[kShaderBlockBinding_Count] = { "Camera", "Lights" };
+static const char *kShaderSharedTextureNames[kShaderSharedTexture_Count] = { "u_LightData", "u_ClusterGrid", "u_ClusterLights" };
+
+static uint64_t g_ShaderUniformsIssued = 0;
+static uint64_t g_ShaderUniformsSkipped = 0;
+static ShaderUniformStats g_ShaderUniformStats = {};
+
+struct ShaderCacheHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint64_t Hash;
+	uint32_t Format;
+	uint32_t Size; // Of the binary following the header
+};
+
+void ShaderSampleUniformStats()
+{
+	g_ShaderUniformStats.FrameIssued = g_ShaderUniformsIssued - g_ShaderUniformStats.Issued;
+	g_ShaderUniformStats.FrameSkipped = g_ShaderUniformsSkipped - g_ShaderUniformStats.Skipped;
+	g_ShaderUniformStats.Issued = g_ShaderUniformsIssued;
+	g_ShaderUniformStats.Skipped = g_ShaderUniformsSkipped;
+}
+
+ShaderUniformStats ShaderGetUniformStats()
+{
+	return g_ShaderUniformStats;
+}
+
+template<typename T>
+bool ShaderVariable::changed(const T &v)
+{
+	static_assert(sizeof(T) <= sizeof(m_Value), "Value does not fit in the uniform cache");
+
+	if (m_Cached && memcmp(&m_Value, &v, sizeof(T)) == 0)
+	{
+		g_ShaderUniformsSkipped++;
+		return false;
+	}
+
+	memcpy(&m_Value, &v, sizeof(T));
+	m_Cached = true;
+	g_ShaderUniformsIssued++;
+	return true;
+}
+
 ShaderVariable::ShaderVariable(GLuint id, std::string name, ShaderVariableType type)
-	: m_ID(id), m_Name(std::move(name)), m_Type(type), m_TypeCheck(true)
+	: m_ID(id), m_Name(std::move(name)), m_Type(type), m_TypeCheck(true), m_Value(0.0f), m_Transpose(false), m_Cached(false)
 {
 }
 
@@ -33,11 +82,27 @@ void ShaderVariable::SetTypeCheck(bool enabled)
 	m_TypeCheck = enabled;
 }
 
+void ShaderVariable::Invalidate()
+{
+	m_Cached = false;
+}
+
+void ShaderVariable::Reset(GLuint id, ShaderVariableType type)
+{
+	m_ID = id;
+	m_Type = type;
+	m_Cached = false;
+}
+
 void ShaderVariable::SetBool(bool v)
 {
 	if (m_Type != kShaderVariableType_Bool)
 		THROW_EXCEPTION(ShaderVariableTypeMismatchException, "Expected type %d", m_Type);
 
+	const int value = v;
+	if (!changed(value))
+		return;
+
 	glUniform1i(m_ID, v);
 }
 
@@ -46,6 +111,9 @@ void ShaderVariable::SetInt(int v)
 	if (m_TypeCheck && m_Type != kShaderVariableType_Int)
 		THROW_EXCEPTION(ShaderVariableTypeMismatchException, "Expected type %d", m_Type);
 
+	if (!changed(v))
+		return;
+
 	glUniform1i(m_ID, v);
 }
 
@@ -54,6 +122,9 @@ void ShaderVariable::SetUInt(unsigned int v)
 	if (m_TypeCheck && m_Type != kShaderVariableType_UInt)
 		THROW_EXCEPTION(ShaderVariableTypeMismatchException, "Expected type %d", m_Type);
 
+	if (!changed(v))
+		return;
+
 	glUniform1ui(m_ID, v);
 }
 
@@ -62,6 +133,9 @@ void ShaderVariable::SetFloat(float v)
 	if (m_TypeCheck && m_Type != kShaderVariableType_Float)
 		THROW_EXCEPTION(ShaderVariableTypeMismatchException, "Expected type %d", m_Type);
 
+	if (!changed(v))
+		return;
+
 	glUniform1f(m_ID, v);
 }
 
@@ -70,6 +144,9 @@ void ShaderVariable::SetDouble(double v)
 	if (m_TypeCheck && m_Type != kShaderVariableType_Double)
 		THROW_EXCEPTION(ShaderVariableTypeMismatchException, "Expected type %d", m_Type);
 
+	if (!changed(v))
+		return;
+
 	glUniform1d(m_ID, v);
 }
 
@@ -78,6 +155,9 @@ void ShaderVariable::SetVec2(const glm::vec2 &v)
 	if (m_TypeCheck && m_Type != kShaderVariableType_Vec2)
 		THROW_EXCEPTION(ShaderVariableTypeMismatchException, "Expected type %d", m_Type);
 
+	if (!changed(v))
+		return;
+
 	glUniform2fv(m_ID, 1, glm::value_ptr(v));
 }
 
@@ -86,6 +166,9 @@ void ShaderVariable::SetVec3(const glm::vec3 &v)
 	if (m_TypeCheck && m_Type != kShaderVariableType_Vec3)
 		THROW_EXCEPTION(ShaderVariableTypeMismatchException, "Expected type %d", m_Type);
 
+	if (!changed(v))
+		return;
+
 	glUniform3fv(m_ID, 1, glm::value_ptr(v));
 }
 
@@ -94,6 +177,9 @@ void ShaderVariable::SetVec4(const glm::vec4 &v)
 	if (m_TypeCheck && m_Type != kShaderVariableType_Vec4)
 		THROW_EXCEPTION(ShaderVariableTypeMismatchException, "Expected type %d", m_Type);
 
+	if (!changed(v))
+		return;
+
 	glUniform4fv(m_ID, 1, glm::value_ptr(v));
 }
 
@@ -102,6 +188,16 @@ void ShaderVariable::SetMat4(const glm::mat4 &v, bool transpose)
 	if (m_TypeCheck && m_Type != kShaderVariableType_Mat4)
 		THROW_EXCEPTION(ShaderVariableTypeMismatchException, "Expected type %d", m_Type);
 
+	// Transposed uploads of the same matrix differ
+	if (transpose != m_Transpose)
+	{
+		m_Transpose = transpose;
+		m_Cached = false;
+	}
+
+	if (!changed(v))
+		return;
+
 	glUniformMatrix4fv(m_ID, 1, transpose, glm::value_ptr(v));
 }
 
@@ -145,6 +241,7 @@ Shader::~Shader()
 	for (auto &v : m_Variables)
 		Delete(v);
 	m_Variables.clear();
+	m_VariableTable.clear();
 
 	if (m_Compiled)
 	{
@@ -165,14 +262,34 @@ GLuint Shader::GetID() const
 
 ShaderVariable *Shader::GetVariable(const std::string &name)
 {
-	// Find variable
-	for (auto &var : m_Variables)
-	{
-		if (var->GetName() == name)
-			return var;
-	}
-	
-	THROW_EXCEPTION(ShaderVariableNotFoundException, "Variable %s not found", name.c_str());
+	return GetVariable(name.c_str());
+}
+
+ShaderVariable *Shader::GetVariable(const char *name)
+{
+	const auto it = m_VariableTable.find(HashString(name));
+	if (it == m_VariableTable.end())
+		THROW_EXCEPTION(ShaderVariableNotFoundException, "Variable %s not found", name);
+
+	return it->second;
+}
+
+ShaderVariable *Shader::GetVariable(const ShaderVariableName &name)
+{
+	const auto it = m_VariableTable.find(name.Handle);
+	if (it == m_VariableTable.end())
+		THROW_EXCEPTION(ShaderVariableNotFoundException, "Variable %s not found", name.Name);
+
+	return it->second;
+}
+
+ShaderVariable *Shader::GetVariable(ShaderVariableHandle handle)
+{
+	const auto it = m_VariableTable.find(handle);
+	if (it == m_VariableTable.end())
+		THROW_EXCEPTION(ShaderVariableNotFoundException, "Variable 0x%08X not found", handle);
+
+	return it->second;
 }
 
 std::vector<ShaderVariable *> Shader::GetVariables() const
@@ -180,7 +297,7 @@ std::vector<ShaderVariable *> Shader::GetVariables() const
 	return m_Variables;
 }
 
-void Shader::Compile()
+void Shader::link()
 {
 	// Compile shaders
 	std::vector<GLuint> shaderIds;
@@ -192,10 +309,18 @@ void Shader::Compile()
 		shaderIds.push_back(shaderId);
 	}
 	
+	// Relinking replaces the previous program
+	if (m_Compiled)
+	{
+		glDeleteProgram(m_ID);
+		m_Compiled = false;
+	}
+
 	// Create and link the shaders into a program
 	m_ID = glCreateProgram();
 	for (auto &id : shaderIds)
 		glAttachShader(m_ID, id);
+	glProgramParameteri(m_ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glLinkProgram(m_ID);
 	glValidateProgram(m_ID);
 
@@ -230,6 +355,25 @@ void Shader::Compile()
 		glDetachShader(m_ID, id);
 		glDeleteShader(id);
 	}
+}
+
+void Shader::setup()
+{
+	// Bind shared blocks to their fixed binding points
+	for (unsigned int i = 0; i < kShaderBlockBinding_Count; i++)
+	{
+		const auto blockIndex = glGetUniformBlockIndex(m_ID, kShaderBlockNames[i]);
+		if (blockIndex != GL_INVALID_INDEX)
+			glUniformBlockBinding(m_ID, blockIndex, i);
+	}
+
+	// Point shared samplers at their texture units
+	for (unsigned int i = 0; i < kShaderSharedTexture_Count; i++)
+	{
+		const auto location = glGetUniformLocation(m_ID, kShaderSharedTextureNames[i]);
+		if (location != -1)
+			glProgramUniform1i(m_ID, location, SHADER_SHARED_TEXTURE_UNIT + i);
+	}
 
 	// Get max length of uniform name
 	GLint maxNameLength;
@@ -239,6 +383,10 @@ void Shader::Compile()
 	GLint count;
 	glGetProgramiv(m_ID, GL_ACTIVE_UNIFORMS, &count);
 
+	// Variables from a previous link keep their objects, uniforms no longer present are ignored by GL
+	for (auto &var : m_Variables)
+		var->Reset(-1, var->GetType());
+
 	for (auto i = 0; i < count; i++)
 	{
 		// Get uniform information
@@ -252,15 +400,159 @@ void Shader::Compile()
 		glGetActiveUniform(m_ID, static_cast<GLuint>(i), maxNameLength, &varNameLength, &size, &type, const_cast<char *>(varName.c_str()));
 		varName.resize(varNameLength);
 
+		// Block members are set through their buffer
+		const auto index = static_cast<GLuint>(i);
+		GLint blockIndex;
+		glGetActiveUniformsiv(m_ID, 1, &index, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+		if (blockIndex != -1)
+			continue;
+
 		// Get uniform location
 		const auto location = glGetUniformLocation(m_ID, varName.c_str());
 
-		// Store
-		m_Variables.push_back(New<ShaderVariable>(location, varName, static_cast<ShaderVariableType>(type)));
+		// Update existing variable or store a new one
+		ShaderVariable *existing = nullptr;
+		for (auto &var : m_Variables)
+		{
+			if (var->GetName() == varName)
+			{
+				existing = var;
+				break;
+			}
+		}
+
+		if (existing)
+			existing->Reset(location, static_cast<ShaderVariableType>(type));
+		else m_Variables.push_back(New<ShaderVariable>(location, varName, static_cast<ShaderVariableType>(type)));
+	}
+
+	// Index variables by handle
+	m_VariableTable.clear();
+	for (auto &var : m_Variables)
+	{
+		const auto handle = HashString(var->GetName().c_str());
+		const auto it = m_VariableTable.find(handle);
+		if (it != m_VariableTable.end())
+			THROW_EXCEPTION(ShaderVariableHashCollisionException, "Variables %s and %s have the same handle in shader %s", 
+				it->second->GetName().c_str(), var->GetName().c_str(), m_Name.c_str());
+
+		m_VariableTable.emplace(handle, var);
+	}
+}
+
+uint64_t Shader::getBinaryHash() const
+{
+	auto hash = HASH_FNV_OFFSET_64;
+
+	// Drivers reject or misread binaries of other drivers and versions
+	const GLenum driverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+	for (const auto name : driverStrings)
+	{
+		const auto str = reinterpret_cast<const char *>(glGetString(name));
+		if (str)
+			hash = HashBytes(str, strlen(str) + 1, hash);
+	}
+
+	for (const auto &source : m_Sources)
+	{
+		const auto code = String::Join(source.Code, "\n");
+		hash = HashBytes(&source.Type, sizeof(source.Type), hash);
+		hash = HashBytes(code.c_str(), code.size() + 1, hash);
+	}
+
+	return hash;
+}
+
+bool Shader::loadBinary(const std::string &path, uint64_t hash)
+{
+	if (!File::Exists(path))
+		return false;
+
+	const auto data = File::ReadAllBytes(path);
+	if (data.size() < sizeof(ShaderCacheHeader))
+		return false;
+
+	ShaderCacheHeader header;
+	memcpy(&header, data.data(), sizeof(header));
+	if (header.Magic != SHADER_CACHE_MAGIC || header.Version != SHADER_CACHE_VERSION || header.Hash != hash
+		|| sizeof(header) + header.Size != data.size())
+		return false;
+
+	// Drivers may still refuse a binary, e.g. after an update that kept the version string
+	const auto id = glCreateProgram();
+	glProgramBinary(id, header.Format, data.data() + sizeof(header), header.Size);
+
+	GLint result = 0;
+	glGetProgramiv(id, GL_LINK_STATUS, &result);
+	if (result == GL_FALSE)
+	{
+		glDeleteProgram(id);
+		return false;
+	}
+
+	// Relinking replaces the previous program
+	if (m_Compiled)
+	{
+		glDeleteProgram(m_ID);
+		m_Compiled = false;
 	}
 
+	m_ID = id;
+	return true;
+}
+
+bool Shader::saveBinary(const std::string &path, uint64_t hash) const
+{
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	if (formatCount == 0)
+		return false;
+
+	GLint size = 0;
+	glGetProgramiv(m_ID, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (size <= 0)
+		return false;
+
+	std::vector<char> data(sizeof(ShaderCacheHeader) + size);
+	GLenum format;
+	glGetProgramBinary(m_ID, size, nullptr, &format, data.data() + sizeof(ShaderCacheHeader));
+
+	ShaderCacheHeader header;
+	header.Magic = SHADER_CACHE_MAGIC;
+	header.Version = SHADER_CACHE_VERSION;
+	header.Hash = hash;
+	header.Format = format;
+	header.Size = static_cast<uint32_t>(size);
+	memcpy(data.data(), &header, sizeof(header));
+
+	if (!File::WriteAllBytes(path, data.data(), data.size()))
+	{
+		LOG_WARN("Graphics", "Unable to write shader cache %s", path.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool Shader::Compile(const std::string &cachePath)
+{
+	const auto hash = cachePath.empty() ? 0 : getBinaryHash();
+	const auto cached = !cachePath.empty() && loadBinary(cachePath, hash);
+	if (!cached)
+	{
+		link();
+
+		// Drivers without binary formats compile on every launch
+		if (!cachePath.empty())
+			saveBinary(cachePath, hash);
+	}
+
+	// Uniform state is set again, binaries are not guaranteed to keep it
+	setup();
+
 	// Set as compiled
 	m_Compiled = true;
+	return cached;
 }
 
 void Shader::Use()
@@ -1,7 +1,10 @@
 #pragma once
 
 #include "Utility/Exception.h"
+#include "Utility/Hash.h"
+#include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
@@ -12,11 +15,62 @@ DEFINE_EXCEPTION(ShaderLinkException);
 DEFINE_EXCEPTION(ShaderNotCompiledException);
 DEFINE_EXCEPTION(ShaderVariableNotFoundException);
 DEFINE_EXCEPTION(ShaderVariableTypeMismatchException);
+DEFINE_EXCEPTION(ShaderVariableHashCollisionException);
 
-#define SHADER_DEFINE_VARIABLE(name) static const char *kShaderVar_ ## name =  "u_" #name
+typedef uint32_t ShaderVariableHandle; // Hash of the variable name
+
+// Variable name with its handle computed at compile time
+struct ShaderVariableName
+{
+	const char *Name;
+	ShaderVariableHandle Handle;
+
+	constexpr ShaderVariableName(const char *name)
+		: Name(name), Handle(HashString(name))
+	{
+	}
+
+	operator const char *() const
+	{
+		return Name;
+	}
+};
+
+#ifndef SHADER_CACHE_EXTENSION
+#define SHADER_CACHE_EXTENSION ".cache"
+#endif
+
+#define SHADER_CACHE_MAGIC 0x43524753u // "SGRC"
+#define SHADER_CACHE_VERSION 1 // Bump whenever the layout changes
+
+#define SHADER_DEFINE_VARIABLE(name) static constexpr ShaderVariableName kShaderVar_ ## name("u_" #name)
 
 // Vars
 SHADER_DEFINE_VARIABLE(Transform);
+SHADER_DEFINE_VARIABLE(Time);
+
+// Uniform blocks shared by all programs, bound on compile when a program declares them
+enum ShaderBlockBinding
+{
+	kShaderBlockBinding_Camera,
+	kShaderBlockBinding_Lights,
+
+	kShaderBlockBinding_Count
+};
+
+// Samplers shared by all programs, set to fixed texture units on compile
+enum ShaderSharedTexture
+{
+	kShaderSharedTexture_LightData,
+	kShaderSharedTexture_ClusterGrid,
+	kShaderSharedTexture_ClusterLights,
+
+	kShaderSharedTexture_Count
+};
+
+#ifndef SHADER_SHARED_TEXTURE_UNIT
+#define SHADER_SHARED_TEXTURE_UNIT 13 // Unit of the first shared texture, materials use the units below
+#endif
 
 enum ShaderVariableType
 {
@@ -38,8 +92,21 @@ enum ShaderVariableType
 
 	// Internal
 	kShaderVariableType_Sampler2D = GL_SAMPLER_2D,
+	kShaderVariableType_Sampler2DArray = GL_SAMPLER_2D_ARRAY,
+};
+
+struct ShaderUniformStats
+{
+	uint64_t Issued; // glUniform calls made
+	uint64_t Skipped; // Uploads skipped because the value was unchanged
+	uint64_t FrameIssued; // During the last sampled frame
+	uint64_t FrameSkipped;
 };
 
+// Upload counters, sample once per frame
+void ShaderSampleUniformStats();
+ShaderUniformStats ShaderGetUniformStats();
+
 class ShaderVariable
 {
 	GLuint m_ID;
@@ -47,6 +114,14 @@ class ShaderVariable
 	ShaderVariableType m_Type;
 	bool m_TypeCheck;
 
+	// Last uploaded value, uniforms are program state so this stays valid until relink
+	glm::mat4 m_Value;
+	bool m_Transpose;
+	bool m_Cached;
+
+	template<typename T>
+	bool changed(const T &v);
+
 public:
 	ShaderVariable(GLuint id, std::string name, ShaderVariableType type);
 
@@ -57,6 +132,12 @@ public:
 	bool IsTypeCheckEnabled() const;
 	void SetTypeCheck(bool enabled);
 
+	// Forget the last uploaded value, the next set always uploads
+	void Invalidate();
+
+	// Set new location and type after the program was relinked
+	void Reset(GLuint id, ShaderVariableType type);
+
 	void SetBool(bool v);
 	void SetInt(int v);
 	void SetUInt(unsigned int v);
@@ -86,12 +167,20 @@ class Shader
 	std::string m_Name;
 	std::vector<ShaderSource> m_Sources;
 	std::vector<ShaderVariable *> m_Variables;
+	std::unordered_map<ShaderVariableHandle, ShaderVariable *> m_VariableTable; // Built on compile
 
 	GLuint m_ID;
 	bool m_Compiled;
 
 	// Shader compilation
 	static GLuint compileShader(GLenum type, const void *source);
+	void link();
+	void setup(); // After linking or loading a binary
+
+	// Program binaries, only valid for the driver that wrote them
+	uint64_t getBinaryHash() const;
+	bool loadBinary(const std::string &path, uint64_t hash); // False if missing, stale or rejected by the driver
+	bool saveBinary(const std::string &path, uint64_t hash) const; // False if the driver has no binary formats or the file could not be written
 
 public:
 	Shader(std::string name, std::vector<ShaderSource> sources);
@@ -106,9 +195,16 @@ public:
 	const std::string &GetName() const;
 	GLuint GetID() const;
 
+	// Prefer the handle overloads on hot paths, names are hashed per call
 	ShaderVariable *GetVariable(const std::string &name);
+	ShaderVariable *GetVariable(const char *name);
+	ShaderVariable *GetVariable(const ShaderVariableName &name);
+	ShaderVariable *GetVariable(ShaderVariableHandle handle);
 	std::vector<ShaderVariable *> GetVariables() const;
 
-	void Compile();
+	// With a cache path the program is loaded from the binary written by an earlier link of the
+	// same sources on the same driver, sources are compiled and the binary written otherwise.
+	// Returns true if the binary was used
+	bool Compile(const std::string &cachePath = std::string());
 	void Use();
 };
\ No newline at end of file
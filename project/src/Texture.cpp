@@ -1,31 +1,54 @@
 #include "Texture.h"
+#include <algorithm>
 
-Texture::Texture(unsigned int width, unsigned int height, Format format, const void *data)
-	: m_ID(0), m_Width(width), m_Height(height), m_Format(format), m_WrapModeS(kWrapMode_Repeat), m_WrapModeT(kWrapMode_Repeat), 
-	m_FilterModeMin(kFilterMode_LinearMipmapLinear), m_FilterModeMag(kFilterMode_Linear)
+Texture::Texture(unsigned int width, unsigned int height, Format format, const void *data, bool mipmaps, unsigned int layerCount)
+	: m_ID(0), m_StreamID(0), m_Width(width), m_Height(height), m_LayerCount(layerCount), 
+	m_MemorySize(static_cast<size_t>(width) * height * 4 * layerCount), m_StreamLevelCount(0), m_StreamedLayers(0), m_Format(format), 
+	m_WrapModeS(kWrapMode_Repeat), m_WrapModeT(kWrapMode_Repeat), m_FilterModeMin(kFilterMode_LinearMipmapLinear), 
+	m_FilterModeMag(kFilterMode_Linear), m_Anisotropy(1.0f)
 {
 	// TODO: Use buffers for this
 	// Generate texture buffer
 	glGenTextures(1, &m_ID);
-	glBindTexture(GL_TEXTURE_2D, m_ID);
+	bind(m_ID);
 
 	// Set wrap mode and filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, m_WrapModeS);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, m_WrapModeT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_FilterModeMin);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_FilterModeMag);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, m_WrapModeS);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, m_WrapModeT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, m_FilterModeMin);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, m_FilterModeMag);
 
 	// Create texture
-	glTexImage2D(GL_TEXTURE_2D, 0, kFormat_RGBA8, width, height, 0, m_Format, GL_UNSIGNED_BYTE, data);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, kFormat_RGBA8, width, height, layerCount, 0, m_Format, GL_UNSIGNED_BYTE, data);
 
-	// TODO: Add a parameter for this, and the ability to specify if mipmapped in texture metadata
-	glGenerateMipmap(GL_TEXTURE_2D);
+	if (mipmaps)
+	{
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+		m_MemorySize = m_MemorySize * 4 / 3;
+	}
+	else glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
 }
 
 Texture::~Texture()
 {
 	// Destroy texture
 	glDeleteTextures(1, &m_ID);
+	if (m_StreamID)
+		glDeleteTextures(1, &m_StreamID);
+}
+
+void Texture::applyAnisotropy()
+{
+	// Applies to the bound texture
+	if (GLEW_EXT_texture_filter_anisotropic)
+		glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_ANISOTROPY_EXT, m_Anisotropy);
+}
+
+void Texture::bind(GLuint id)
+{
+	// Textures bound for drawing stay untouched
+	glActiveTexture(GL_TEXTURE0 + TEXTURE_EDIT_UNIT);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, id);
 }
 
 const GLuint &Texture::GetID() const
@@ -43,6 +66,34 @@ unsigned int Texture::GetHeight() const
 	return m_Height;
 }
 
+unsigned int Texture::GetLayerCount() const
+{
+	return m_LayerCount;
+}
+
+size_t Texture::GetMemorySize() const
+{
+	return m_MemorySize;
+}
+
+bool Texture::IsCompressed(Format format)
+{
+	return GetBlockSize(format) != 0;
+}
+
+unsigned int Texture::GetBlockSize(Format format)
+{
+	switch (format)
+	{
+	case kFormat_BC1:
+		return 8;
+	case kFormat_BC3:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
 void Texture::GetData(const void *buffer, unsigned int size, unsigned int x, unsigned int y, unsigned int width, unsigned int height)
 {
 	if (m_Lock.try_lock()) 
@@ -62,11 +113,11 @@ void Texture::GetData(const void *buffer, unsigned int size, unsigned int x, uns
 	if (!width) width = m_Width;
 	if (!height) height = m_Height;
 	
-	glBindTexture(GL_TEXTURE_2D, m_ID);
+	bind(m_ID);
 	glGetTextureSubImage(GL_TEXTURE_2D, 0, x, y, 0, width, height, 0, m_Format, GL_UNSIGNED_BYTE, size, &buffer);
 }
 
-void Texture::SetData(unsigned int x, unsigned int y, unsigned int width, unsigned int height, const void *data)
+void Texture::SetData(unsigned int x, unsigned int y, unsigned int width, unsigned int height, const void *data, unsigned int layer)
 {
 	if (m_Lock.try_lock()) 
 	{
@@ -74,19 +125,95 @@ void Texture::SetData(unsigned int x, unsigned int y, unsigned int width, unsign
 		THROW_EXCEPTION(TextureNotLockedException, "Texture must be locked to set data");
 	}
 	
-	glBindTexture(GL_TEXTURE_2D, m_ID);
-	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, m_Format, GL_UNSIGNED_BYTE, data);
+	bind(m_ID);
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, x, y, layer, width, height, 1, m_Format, GL_UNSIGNED_BYTE, data);
+}
+
+bool Texture::BeginStream(unsigned int width, unsigned int height, Format format, unsigned int levelCount)
+{
+	// Further layers write into the storage of the first
+	if (m_StreamID)
+		return width == m_Width && height == m_Height && format == m_Format && levelCount == m_StreamLevelCount;
+
+	m_Width = width;
+	m_Height = height;
+	m_Format = format;
+	m_StreamLevelCount = levelCount;
+
+	// Storage only, filled by the rows
+	glGenTextures(1, &m_StreamID);
+	bind(m_StreamID);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, m_WrapModeS);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, m_WrapModeT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, m_FilterModeMin);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, m_FilterModeMag);
+	applyAnisotropy();
+
+	const auto blockSize = GetBlockSize(format);
+	m_MemorySize = 0;
+	for (unsigned int i = 0; i < levelCount; i++)
+	{
+		const auto levelWidth = (std::max)(width >> i, 1u);
+		const auto levelHeight = (std::max)(height >> i, 1u);
+		if (blockSize)
+		{
+			const auto size = static_cast<size_t>((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * blockSize * m_LayerCount;
+			glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, i, format, levelWidth, levelHeight, m_LayerCount, 0, 
+				static_cast<GLsizei>(size), nullptr);
+			m_MemorySize += size;
+		}
+		else
+		{
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, i, kFormat_RGBA8, levelWidth, levelHeight, m_LayerCount, 0, m_Format, 
+				GL_UNSIGNED_BYTE, nullptr);
+			m_MemorySize += static_cast<size_t>(levelWidth) * levelHeight * 4 * m_LayerCount;
+		}
+	}
+
+	// Incomplete chains would make the texture unusable with mipmapped filtering
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+	return true;
+}
+
+void Texture::StreamRows(unsigned int layer, unsigned int level, unsigned int y, unsigned int count, const void *data, size_t size)
+{
+	const auto levelWidth = (std::max)(m_Width >> level, 1u);
+
+	bind(m_StreamID);
+	if (IsCompressed(m_Format))
+		glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, y, layer, levelWidth, count, 1, m_Format, static_cast<GLsizei>(size), data);
+	else
+	{
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, y, layer, levelWidth, count, 1, m_Format, GL_UNSIGNED_BYTE, data);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+}
+
+void Texture::EndStream()
+{
+	// Layers that failed count as well, they are left undefined
+	if (++m_StreamedLayers < m_LayerCount)
+		return;
+
+	m_StreamedLayers = 0;
+	if (!m_StreamID)
+		return;
+
+	glDeleteTextures(1, &m_ID);
+	m_ID = m_StreamID;
+	m_StreamID = 0;
 }
 
 void Texture::Bind()
 {
-	glBindTexture(GL_TEXTURE_2D, m_ID);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_ID);
 }
 
 void Texture::Activate(uint8_t index)
 {
 	glActiveTexture(GL_TEXTURE0 + index);
-	glBindTexture(GL_TEXTURE_2D, m_ID);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_ID);
 }
 
 void Texture::Lock()
@@ -112,8 +239,8 @@ const Texture::WrapMode &Texture::GetWrapModeS() const
 void Texture::SetWrapModeS(const WrapMode &wrapMode)
 {
 	m_WrapModeS = wrapMode;
-	glBindTexture(GL_TEXTURE_2D, m_ID);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
+	bind(m_ID);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, wrapMode);
 }
 
 const Texture::WrapMode &Texture::GetWrapModeT() const
@@ -124,8 +251,8 @@ const Texture::WrapMode &Texture::GetWrapModeT() const
 void Texture::SetWrapModeT(const WrapMode &wrapMode)
 {
 	m_WrapModeT = wrapMode;
-	glBindTexture(GL_TEXTURE_2D, m_ID);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapMode);
+	bind(m_ID);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, wrapMode);
 }
 
 const Texture::FilterMode &Texture::GetFilterModeMin() const
@@ -136,8 +263,8 @@ const Texture::FilterMode &Texture::GetFilterModeMin() const
 void Texture::SetFilterModeMin(const FilterMode &filterMode)
 {
 	m_FilterModeMin = filterMode;
-	glBindTexture(GL_TEXTURE_2D, m_ID);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filterMode);
+	bind(m_ID);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, filterMode);
 }
 
 const Texture::FilterMode &Texture::GetFilterModeMag() const
@@ -148,6 +275,28 @@ const Texture::FilterMode &Texture::GetFilterModeMag() const
 void Texture::SetFilterModeMag(const FilterMode &filterMode)
 {
 	m_FilterModeMag = filterMode;
-	glBindTexture(GL_TEXTURE_2D, m_ID);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filterMode);
+	bind(m_ID);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, filterMode);
+}
+
+float Texture::GetAnisotropy() const
+{
+	return m_Anisotropy;
+}
+
+void Texture::SetAnisotropy(float anisotropy)
+{
+	m_Anisotropy = (std::min)((std::max)(anisotropy, 1.0f), GetMaxAnisotropy());
+	bind(m_ID);
+	applyAnisotropy();
+}
+
+float Texture::GetMaxAnisotropy()
+{
+	if (!GLEW_EXT_texture_filter_anisotropic)
+		return 1.0f;
+
+	GLfloat maxAnisotropy;
+	glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
+	return maxAnisotropy;
 }
\ No newline at end of file
@@ -6,6 +6,11 @@
 
 DEFINE_EXCEPTION(TextureNotLockedException);
 
+#ifndef TEXTURE_EDIT_UNIT
+#define TEXTURE_EDIT_UNIT 12 // Bound while textures are created or changed, keeps the units of materials intact
+#endif
+
+// Every texture is a 2D array, plain textures have a single layer so all samplers share one type
 class Texture
 {
 public:
@@ -18,8 +23,11 @@ public:
 		kFormat_RGB = GL_RGB,
 		kFormat_RGBA = GL_RGBA,
 		kFormat_BGR = GL_BGR,
-		kFormat_BGRA = GL_BGRA
+		kFormat_BGRA = GL_BGRA,
 
+		// Block compressed, internal and upload format
+		kFormat_BC1 = GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+		kFormat_BC3 = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
 	};
 
 	enum WrapMode
@@ -44,9 +52,15 @@ public:
 
 private:
 	GLuint m_ID;
+	GLuint m_StreamID; // Receives a streamed image until it replaces the texture
 
 	unsigned int m_Width;
 	unsigned int m_Height;
+	unsigned int m_LayerCount;
+	size_t m_MemorySize; // Estimated video memory, including mip levels and layers
+
+	unsigned int m_StreamLevelCount;
+	unsigned int m_StreamedLayers; // Ended streams, the texture is replaced once every layer ended
 
 	std::mutex m_Lock;
 	
@@ -55,9 +69,16 @@ private:
 	WrapMode m_WrapModeT;
 	FilterMode m_FilterModeMin;
 	FilterMode m_FilterModeMag;
+	float m_Anisotropy;
+
+	void applyAnisotropy();
+	static void bind(GLuint id); // To the edit unit
 
 public:
-	Texture(unsigned int width, unsigned int height, Format format = kFormat_RGBA, const void *data = nullptr);
+	// Mip levels are generated by the driver if requested, streamed images bring their own.
+	// Data holds every layer one after another
+	Texture(unsigned int width, unsigned int height, Format format = kFormat_RGBA, const void *data = nullptr, bool mipmaps = false,
+		unsigned int layerCount = 1);
 	~Texture();
 	
 	Texture(const Texture &) = delete;
@@ -70,9 +91,24 @@ public:
 	
 	unsigned int GetWidth() const;
 	unsigned int GetHeight() const;
+	unsigned int GetLayerCount() const;
+	size_t GetMemorySize() const;
+
+	static bool IsCompressed(Format format);
+	static unsigned int GetBlockSize(Format format); // Bytes per 4x4 block, zero if uncompressed
 	
 	void GetData(const void *buffer, unsigned int size, unsigned int x = 0, unsigned int y = 0, unsigned int width = 0, unsigned int height = 0);
-	void SetData(unsigned int x, unsigned int y, unsigned int width, unsigned int height, const void *data);
+	void SetData(unsigned int x, unsigned int y, unsigned int width, unsigned int height, const void *data, unsigned int layer = 0);
+
+	// Streams an image into a second texture, the current image stays visible until EndStream
+	// was called for every layer. Every level must be streamed, a single level leaves the texture
+	// without mip levels. Layers join the stream begun by the first one and must match its size,
+	// format and level count, BeginStream returns false otherwise. With an unpack buffer bound,
+	// data is an offset into it. Rows are tightly packed, compressed rows start and end on block
+	// boundaries or the edge of the level
+	bool BeginStream(unsigned int width, unsigned int height, Format format, unsigned int levelCount = 1);
+	void StreamRows(unsigned int layer, unsigned int level, unsigned int y, unsigned int count, const void *data, size_t size);
+	void EndStream(); // Once per layer, also for layers that failed to load
 
 	void Bind();
 	void Activate(uint8_t index = 0);
@@ -91,4 +127,9 @@ public:
 	void SetFilterModeMin(const FilterMode &filterMode);
 	const FilterMode &GetFilterModeMag() const;
 	void SetFilterModeMag(const FilterMode &filterMode);
+
+	// Clamped to what the driver supports, one if anisotropic filtering is unavailable
+	float GetAnisotropy() const;
+	void SetAnisotropy(float anisotropy);
+	static float GetMaxAnisotropy();
 };
\ No newline at end of file
@@ -0,0 +1,37 @@
+#include "TextureBuffer.h"
+
+TextureBuffer::TextureBuffer(Format format, size_t size)
+	: Buffer(kTarget_TextureBuffer, kUsage_DynamicDraw, size), m_TextureID(0), m_Format(format)
+{
+	// Create texture viewing the buffer
+	glGenTextures(1, &m_TextureID);
+	glBindTexture(GL_TEXTURE_BUFFER, m_TextureID);
+	glTexBuffer(GL_TEXTURE_BUFFER, m_Format, m_ID);
+}
+
+TextureBuffer::~TextureBuffer()
+{
+	glDeleteTextures(1, &m_TextureID);
+}
+
+void TextureBuffer::SetData(size_t size, const void *data)
+{
+	if (m_Mapped)
+		THROW_EXCEPTION(BufferMapException, "Cannot set data of buffer that is currently mapped");
+
+	// Grow by doubling so sizes that change every frame settle quickly
+	while (m_Size < size)
+		m_Size = m_Size ? m_Size * 2 : size;
+
+	// Orphan the old storage, the texture keeps referring to the same buffer name
+	glBindBuffer(m_Target, m_ID);
+	glBufferData(m_Target, m_Size, nullptr, m_Usage);
+	if (size)
+		glBufferSubData(m_Target, 0, size, data);
+}
+
+void TextureBuffer::Activate(unsigned int index)
+{
+	glActiveTexture(GL_TEXTURE0 + index);
+	glBindTexture(GL_TEXTURE_BUFFER, m_TextureID);
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Buffer.h"
+
+// Buffer read by shaders through a samplerBuffer, for data too large for a uniform block
+class TextureBuffer : public Buffer
+{
+public:
+	enum Format
+	{
+		kFormat_R32UI = GL_R32UI,
+		kFormat_RG32UI = GL_RG32UI,
+		kFormat_RGBA32F = GL_RGBA32F
+	};
+
+private:
+	GLuint m_TextureID;
+	Format m_Format;
+
+public:
+	TextureBuffer(Format format, size_t size);
+	~TextureBuffer();
+
+	// No copying/moving
+	TextureBuffer(const TextureBuffer &) = delete;
+	TextureBuffer &operator=(const TextureBuffer &) = delete;
+
+	TextureBuffer(const TextureBuffer &&) = delete;
+	TextureBuffer &operator=(const TextureBuffer &&) = delete;
+
+	// Replaces the contents, storage is orphaned and grows when needed
+	void SetData(size_t size, const void *data);
+
+	void Activate(unsigned int index);
+};
\ No newline at end of file
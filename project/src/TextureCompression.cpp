@@ -0,0 +1,715 @@
+#include "TextureCompression.h"
+#include "JobSystem.h"
+#include "Utility/FileUtil.h"
+#include "Utility/Hash.h"
+#include <rapidjson/document.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef TEXTURE_MIP_SIMD
+#include <emmintrin.h>
+#endif
+
+#define DDS_MAGIC 0x20534444u // "DDS "
+#define DDS_FOURCC_DXT1 0x31545844u // "DXT1"
+#define DDS_FOURCC_DXT5 0x35545844u // "DXT5"
+#define DDS_BAKER_TAG 0x454B4142u // "BAKE", marks containers carrying a source hash
+
+#define DDS_FLAGS 0x00021007u // Caps, height, width, pixel format, mip map count
+#define DDS_FLAG_PITCH 0x8u
+#define DDS_FLAG_LINEAR_SIZE 0x80000u
+#define DDS_PIXEL_FORMAT_FOURCC 0x4u
+#define DDS_PIXEL_FORMAT_RGBA 0x41u // RGB with alpha, described by the masks
+#define DDS_CAPS 0x00401008u // Complex, texture, mip map
+
+struct DDSPixelFormat
+{
+	uint32_t Size;
+	uint32_t Flags;
+	uint32_t FourCC;
+	uint32_t RGBBitCount;
+	uint32_t Masks[4];
+};
+
+struct DDSHeader
+{
+	uint32_t Magic;
+	uint32_t Size;
+	uint32_t Flags;
+	uint32_t Height;
+	uint32_t Width;
+	uint32_t LinearSize;
+	uint32_t Depth;
+	uint32_t MipMapCount;
+	uint32_t Reserved1[11]; // Baker tag, then the source hash
+	DDSPixelFormat PixelFormat;
+	uint32_t Caps[4];
+	uint32_t Reserved2;
+};
+
+static uint16_t packColor(const float *color)
+{
+	const auto r = static_cast<uint16_t>(std::lround((std::min)((std::max)(color[0], 0.0f), 255.0f) * 31.0f / 255.0f));
+	const auto g = static_cast<uint16_t>(std::lround((std::min)((std::max)(color[1], 0.0f), 255.0f) * 63.0f / 255.0f));
+	const auto b = static_cast<uint16_t>(std::lround((std::min)((std::max)(color[2], 0.0f), 255.0f) * 31.0f / 255.0f));
+	return static_cast<uint16_t>(r << 11 | g << 5 | b);
+}
+
+static void unpackColor(uint16_t packed, float *color)
+{
+	color[0] = static_cast<float>((packed >> 11) & 31) * 255.0f / 31.0f;
+	color[1] = static_cast<float>((packed >> 5) & 63) * 255.0f / 63.0f;
+	color[2] = static_cast<float>(packed & 31) * 255.0f / 31.0f;
+}
+
+// Four color mode, the first endpoint is always the larger one
+static void compressColorBlock(const uint8_t texels[16][4], uint8_t *block)
+{
+	float mean[3] = {};
+	for (auto i = 0; i < 16; i++)
+	{
+		for (auto c = 0; c < 3; c++)
+			mean[c] += texels[i][c] / 16.0f;
+	}
+
+	float covariance[6] = {};
+	for (auto i = 0; i < 16; i++)
+	{
+		const float d[3] = { texels[i][0] - mean[0], texels[i][1] - mean[1], texels[i][2] - mean[2] };
+		covariance[0] += d[0] * d[0];
+		covariance[1] += d[0] * d[1];
+		covariance[2] += d[0] * d[2];
+		covariance[3] += d[1] * d[1];
+		covariance[4] += d[1] * d[2];
+		covariance[5] += d[2] * d[2];
+	}
+
+	// Principal axis by power iteration, starting along the luminance
+	float axis[3] = { 0.3f, 0.6f, 0.1f };
+	for (auto iteration = 0; iteration < 8; iteration++)
+	{
+		const float next[3] = {
+			covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+			covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+			covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]
+		};
+		const auto length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+		if (length < 1e-6f)
+			break;
+
+		for (auto c = 0; c < 3; c++)
+			axis[c] = next[c] / length;
+	}
+
+	auto minProjection = 0.0f, maxProjection = 0.0f;
+	for (auto i = 0; i < 16; i++)
+	{
+		const auto projection = (texels[i][0] - mean[0]) * axis[0] + (texels[i][1] - mean[1]) * axis[1] 
+			+ (texels[i][2] - mean[2]) * axis[2];
+		minProjection = (std::min)(minProjection, projection);
+		maxProjection = (std::max)(maxProjection, projection);
+	}
+
+	// Inset the endpoints slightly, the extremes are rarely hit exactly
+	const auto inset = (maxProjection - minProjection) / 16.0f;
+	minProjection += inset;
+	maxProjection -= inset;
+
+	float endpoints[2][3];
+	for (auto c = 0; c < 3; c++)
+	{
+		endpoints[0][c] = mean[c] + axis[c] * maxProjection;
+		endpoints[1][c] = mean[c] + axis[c] * minProjection;
+	}
+
+	auto color0 = packColor(endpoints[0]);
+	auto color1 = packColor(endpoints[1]);
+	if (color0 < color1)
+		std::swap(color0, color1);
+
+	uint32_t indices = 0;
+	if (color0 != color1)
+	{
+		float palette[4][3];
+		unpackColor(color0, palette[0]);
+		unpackColor(color1, palette[1]);
+		for (auto c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+			palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+		}
+
+		for (auto i = 0; i < 16; i++)
+		{
+			auto best = 0u;
+			auto bestDistance = 0.0f;
+			for (auto p = 0u; p < 4; p++)
+			{
+				auto distance = 0.0f;
+				for (auto c = 0; c < 3; c++)
+					distance += (texels[i][c] - palette[p][c]) * (texels[i][c] - palette[p][c]);
+
+				if (p == 0 || distance < bestDistance)
+				{
+					best = p;
+					bestDistance = distance;
+				}
+			}
+
+			indices |= best << (2 * i);
+		}
+	}
+
+	memcpy(block, &color0, 2);
+	memcpy(block + 2, &color1, 2);
+	memcpy(block + 4, &indices, 4);
+}
+
+// Eight value mode, the first endpoint is always the larger one
+static void compressAlphaBlock(const uint8_t texels[16][4], uint8_t *block)
+{
+	uint8_t alpha0 = 0, alpha1 = 255;
+	for (auto i = 0; i < 16; i++)
+	{
+		alpha0 = (std::max)(alpha0, texels[i][3]);
+		alpha1 = (std::min)(alpha1, texels[i][3]);
+	}
+
+	uint64_t indices = 0;
+	if (alpha0 != alpha1)
+	{
+		float palette[8];
+		palette[0] = alpha0;
+		palette[1] = alpha1;
+		for (auto p = 1; p < 7; p++)
+			palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7.0f;
+
+		for (auto i = 0; i < 16; i++)
+		{
+			auto best = 0ull;
+			auto bestDistance = 256.0f;
+			for (auto p = 0ull; p < 8; p++)
+			{
+				const auto distance = std::abs(texels[i][3] - palette[p]);
+				if (distance < bestDistance)
+				{
+					best = p;
+					bestDistance = distance;
+				}
+			}
+
+			indices |= best << (3 * i);
+		}
+	}
+
+	block[0] = alpha0;
+	block[1] = alpha1;
+	for (auto i = 0; i < 6; i++)
+		block[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+}
+
+bool ParseTextureCompression(const std::string &name, TextureCompression &compression)
+{
+	if (name == "none")
+		compression = kTextureCompression_None;
+	else if (name == "bc1")
+		compression = kTextureCompression_BC1;
+	else if (name == "bc3")
+		compression = kTextureCompression_BC3;
+	else return false;
+
+	return true;
+}
+
+TextureMeta::TextureMeta()
+	: Format(kTextureFormat_RGB), Compression(kTextureCompression_None), Mipmaps(true), MipFilter(kTextureMipFilter_Kaiser), 
+	Anisotropy(1.0f)
+{
+}
+
+bool ParseTextureMeta(const std::string &source, TextureMeta &meta, std::string &outError)
+{
+	rapidjson::Document document;
+	document.Parse<rapidjson::kParseCommentsFlag>(source.c_str());
+	if (document.HasParseError() || !document.IsObject())
+	{
+		outError = "parse error";
+		return false;
+	}
+
+	// Get file name
+	if (!document.HasMember("name") || !document["name"].IsString())
+	{
+		outError = "invalid name";
+		return false;
+	}
+
+	meta.Name = document["name"].GetString();
+
+	// Get file extension
+	if (!document.HasMember("extension") || !document["extension"].IsString())
+	{
+		outError = "invalid extension";
+		return false;
+	}
+
+	meta.Extension = document["extension"].GetString();
+
+	// Get format
+	if (!document.HasMember("format") || !document["format"].IsInt() || document["format"].GetInt() < kTextureFormat_RGB
+		|| document["format"].GetInt() > kTextureFormat_BGRA)
+	{
+		outError = "invalid format";
+		return false;
+	}
+
+	meta.Format = static_cast<TextureFormat>(document["format"].GetInt());
+
+	// Get compression, none by default
+	meta.Compression = kTextureCompression_None;
+	if (document.HasMember("compression") && (!document["compression"].IsString()
+		|| !ParseTextureCompression(document["compression"].GetString(), meta.Compression)))
+	{
+		outError = "invalid compression";
+		return false;
+	}
+
+	// Get mipmapping, on by default
+	meta.Mipmaps = true;
+	if (document.HasMember("mipmaps"))
+	{
+		if (!document["mipmaps"].IsBool())
+		{
+			outError = "invalid mipmaps";
+			return false;
+		}
+
+		meta.Mipmaps = document["mipmaps"].GetBool();
+	}
+
+	// Get mip filter, Kaiser by default
+	meta.MipFilter = kTextureMipFilter_Kaiser;
+	if (document.HasMember("mipFilter") && (!document["mipFilter"].IsString()
+		|| !ParseTextureMipFilter(document["mipFilter"].GetString(), meta.MipFilter)))
+	{
+		outError = "invalid mip filter";
+		return false;
+	}
+
+	// Get anisotropy, off by default
+	meta.Anisotropy = 1.0f;
+	if (document.HasMember("anisotropy"))
+	{
+		if (!document["anisotropy"].IsNumber() || document["anisotropy"].GetFloat() < 1.0f)
+		{
+			outError = "invalid anisotropy";
+			return false;
+		}
+
+		meta.Anisotropy = document["anisotropy"].GetFloat();
+	}
+
+	// Get array, none by default
+	meta.Array.clear();
+	if (document.HasMember("array"))
+	{
+		if (!document["array"].IsString())
+		{
+			outError = "invalid array";
+			return false;
+		}
+
+		meta.Array = document["array"].GetString();
+	}
+
+	return true;
+}
+
+unsigned int GetTextureBlockSize(TextureCompression compression)
+{
+	switch (compression)
+	{
+	case kTextureCompression_BC1:
+		return 8;
+	case kTextureCompression_BC3:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+bool ParseTextureMipFilter(const std::string &name, TextureMipFilter &filter)
+{
+	if (name == "box")
+		filter = kTextureMipFilter_Box;
+	else if (name == "kaiser")
+		filter = kTextureMipFilter_Kaiser;
+	else return false;
+
+	return true;
+}
+
+size_t GetTextureLevelSize(TextureCompression compression, unsigned int width, unsigned int height)
+{
+	if (compression == kTextureCompression_None)
+		return static_cast<size_t>(width) * height * 4;
+
+	return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * GetTextureBlockSize(compression);
+}
+
+uint64_t HashTextureSource(const void *data, size_t size, TextureMipFilter filter, bool mipmaps)
+{
+	const uint32_t settings[] = { TEXTURE_CONTAINER_VERSION, static_cast<uint32_t>(filter), mipmaps ? 1u : 0u };
+	return HashBytes(settings, sizeof(settings), HashBytes(data, size));
+}
+
+static void downsampleBox(const uint8_t *source, unsigned int width, unsigned int height, uint8_t *target,
+	unsigned int targetWidth, unsigned int first, unsigned int last)
+{
+	// Odd sizes drop the last row or column
+	for (auto y = first; y < last; y++)
+	{
+		const auto y0 = (std::min)(y * 2, height - 1);
+		const auto y1 = (std::min)(y * 2 + 1, height - 1);
+		for (unsigned int x = 0; x < targetWidth; x++)
+		{
+			const auto x0 = (std::min)(x * 2, width - 1);
+			const auto x1 = (std::min)(x * 2 + 1, width - 1);
+			for (auto c = 0; c < 4; c++)
+			{
+				const auto sum = source[(static_cast<size_t>(y0) * width + x0) * 4 + c] + source[(static_cast<size_t>(y0) * width + x1) * 4 + c]
+					+ source[(static_cast<size_t>(y1) * width + x0) * 4 + c] + source[(static_cast<size_t>(y1) * width + x1) * 4 + c];
+				target[(static_cast<size_t>(y) * targetWidth + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+// Modified Bessel function of the first kind, order zero
+static float besselI0(float x)
+{
+	auto sum = 1.0f, term = 1.0f;
+	for (auto k = 1; k < 32 && term > sum * 1e-7f; k++)
+	{
+		const auto half = x / (2.0f * k);
+		term *= half * half;
+		sum += term;
+	}
+
+	return sum;
+}
+
+static float kaiser(float t)
+{
+	const auto radius = TEXTURE_MIP_KAISER_RADIUS;
+	if (std::abs(t) >= radius)
+		return 0.0f;
+
+	const auto x = t / radius;
+	const auto window = besselI0(TEXTURE_MIP_KAISER_ALPHA * std::sqrt(1.0f - x * x)) / besselI0(TEXTURE_MIP_KAISER_ALPHA);
+	const auto pt = 3.14159265f * t;
+	return std::abs(t) < 1e-5f ? window : window * std::sin(pt) / pt;
+}
+
+// Taps of one axis, every target texel reads the same number of clamped source texels
+struct FilterTaps
+{
+	unsigned int Count;
+	std::vector<unsigned int> Indices;
+	std::vector<float> Weights;
+};
+
+static void buildKaiserTaps(unsigned int size, unsigned int targetSize, FilterTaps &taps)
+{
+	const auto scale = static_cast<float>(size) / targetSize;
+	taps.Count = static_cast<unsigned int>(std::ceil(2.0f * TEXTURE_MIP_KAISER_RADIUS * scale)) + 1;
+	taps.Indices.resize(static_cast<size_t>(targetSize) * taps.Count);
+	taps.Weights.resize(static_cast<size_t>(targetSize) * taps.Count);
+
+	for (unsigned int i = 0; i < targetSize; i++)
+	{
+		const auto center = (i + 0.5f) * scale;
+		const auto first = static_cast<int>(std::floor(center - TEXTURE_MIP_KAISER_RADIUS * scale));
+
+		auto total = 0.0f;
+		for (unsigned int k = 0; k < taps.Count; k++)
+		{
+			const auto index = first + static_cast<int>(k);
+			const auto weight = kaiser((index + 0.5f - center) / scale);
+			taps.Indices[i * taps.Count + k] = static_cast<unsigned int>((std::min)((std::max)(index, 0), static_cast<int>(size) - 1));
+			taps.Weights[i * taps.Count + k] = weight;
+			total += weight;
+		}
+
+		for (unsigned int k = 0; k < taps.Count; k++)
+			taps.Weights[i * taps.Count + k] /= total;
+	}
+}
+
+// Filters the rows, then the columns of the target rows [first, last). Source rows are
+// filtered again by every range that reads them, which keeps the scratch space small
+static void downsampleKaiser(const uint8_t *source, unsigned int width, uint8_t *target, unsigned int targetWidth,
+	const FilterTaps &columns, const FilterTaps &rows, unsigned int first, unsigned int last)
+{
+	auto sourceFirst = rows.Indices[first * rows.Count], sourceLast = sourceFirst;
+	for (auto i = first * rows.Count; i < last * rows.Count; i++)
+	{
+		sourceFirst = (std::min)(sourceFirst, rows.Indices[i]);
+		sourceLast = (std::max)(sourceLast, rows.Indices[i]);
+	}
+
+	std::vector<float> filtered(static_cast<size_t>(sourceLast - sourceFirst + 1) * targetWidth * 4);
+	for (auto y = sourceFirst; y <= sourceLast; y++)
+	{
+		const auto row = source + static_cast<size_t>(y) * width * 4;
+		auto out = &filtered[static_cast<size_t>(y - sourceFirst) * targetWidth * 4];
+		for (unsigned int x = 0; x < targetWidth; x++, out += 4)
+		{
+			const auto indices = &columns.Indices[x * columns.Count];
+			const auto weights = &columns.Weights[x * columns.Count];
+#ifdef TEXTURE_MIP_SIMD
+			const auto zero = _mm_setzero_si128();
+			auto sum = _mm_setzero_ps();
+			for (unsigned int k = 0; k < columns.Count; k++)
+			{
+				int texel;
+				memcpy(&texel, row + indices[k] * 4, 4);
+				const auto widened = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(texel), zero), zero);
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_cvtepi32_ps(widened), _mm_set1_ps(weights[k])));
+			}
+			_mm_storeu_ps(out, sum);
+#else
+			float sum[4] = {};
+			for (unsigned int k = 0; k < columns.Count; k++)
+			{
+				for (auto c = 0; c < 4; c++)
+					sum[c] += row[indices[k] * 4 + c] * weights[k];
+			}
+			memcpy(out, sum, sizeof(sum));
+#endif
+		}
+	}
+
+	for (auto y = first; y < last; y++)
+	{
+		const auto indices = &rows.Indices[y * rows.Count];
+		const auto weights = &rows.Weights[y * rows.Count];
+		auto out = target + static_cast<size_t>(y) * targetWidth * 4;
+		for (unsigned int x = 0; x < targetWidth; x++, out += 4)
+		{
+#ifdef TEXTURE_MIP_SIMD
+			auto sum = _mm_setzero_ps();
+			for (unsigned int k = 0; k < rows.Count; k++)
+			{
+				const auto in = _mm_loadu_ps(&filtered[(static_cast<size_t>(indices[k] - sourceFirst) * targetWidth + x) * 4]);
+				sum = _mm_add_ps(sum, _mm_mul_ps(in, _mm_set1_ps(weights[k])));
+			}
+
+			// Rounds and saturates the ringing below zero and above 255
+			const auto packed = _mm_cvtps_epi32(sum);
+			const auto texel = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(packed, packed), _mm_setzero_si128()));
+			memcpy(out, &texel, 4);
+#else
+			float sum[4] = {};
+			for (unsigned int k = 0; k < rows.Count; k++)
+			{
+				const auto in = &filtered[(static_cast<size_t>(indices[k] - sourceFirst) * targetWidth + x) * 4];
+				for (auto c = 0; c < 4; c++)
+					sum[c] += in[c] * weights[k];
+			}
+
+			for (auto c = 0; c < 4; c++)
+				out[c] = static_cast<uint8_t>((std::min)((std::max)(std::lround(sum[c]), 0l), 255l));
+#endif
+		}
+	}
+}
+
+void BuildTextureMipChain(const uint8_t *rgba, unsigned int width, unsigned int height, TextureMipFilter filter,
+	std::vector<std::vector<uint8_t>> &levels, JobSystem *jobSystem)
+{
+	levels.clear();
+	levels.emplace_back(rgba, rgba + static_cast<size_t>(width) * height * 4);
+
+	while (width > 1 || height > 1)
+	{
+		const auto levelWidth = (std::max)(width / 2, 1u);
+		const auto levelHeight = (std::max)(height / 2, 1u);
+
+		std::vector<uint8_t> level(static_cast<size_t>(levelWidth) * levelHeight * 4);
+		const auto source = levels.back().data();
+		const auto target = level.data();
+
+		FilterTaps columns, rows;
+		if (filter == kTextureMipFilter_Kaiser)
+		{
+			buildKaiserTaps(width, levelWidth, columns);
+			buildKaiserTaps(height, levelHeight, rows);
+		}
+
+		const auto downsample = [&](unsigned int first, unsigned int last)
+		{
+			if (filter == kTextureMipFilter_Kaiser)
+				downsampleKaiser(source, width, target, levelWidth, columns, rows, first, last);
+			else downsampleBox(source, width, height, target, levelWidth, first, last);
+		};
+
+		if (jobSystem)
+			jobSystem->ParallelFor(levelHeight, TEXTURE_MIP_ROWS_PER_JOB, downsample);
+		else downsample(0, levelHeight);
+
+		levels.push_back(std::move(level));
+		width = levelWidth;
+		height = levelHeight;
+	}
+}
+
+void CompressTexture(TextureCompression compression, const uint8_t *rgba, unsigned int width, unsigned int height,
+	std::vector<uint8_t> &outBlocks)
+{
+	const auto blockSize = GetTextureBlockSize(compression);
+	if (!blockSize)
+	{
+		outBlocks.assign(rgba, rgba + GetTextureLevelSize(compression, width, height));
+		return;
+	}
+
+	outBlocks.assign(GetTextureLevelSize(compression, width, height), 0);
+
+	auto block = outBlocks.data();
+	for (unsigned int by = 0; by < height; by += 4)
+	{
+		for (unsigned int bx = 0; bx < width; bx += 4)
+		{
+			// Edge blocks repeat the last texels
+			uint8_t texels[16][4];
+			for (unsigned int i = 0; i < 16; i++)
+			{
+				const auto x = (std::min)(bx + i % 4, width - 1);
+				const auto y = (std::min)(by + i / 4, height - 1);
+				memcpy(texels[i], rgba + (static_cast<size_t>(y) * width + x) * 4, 4);
+			}
+
+			if (compression == kTextureCompression_BC3)
+			{
+				compressAlphaBlock(texels, block);
+				compressColorBlock(texels, block + 8);
+			}
+			else compressColorBlock(texels, block);
+
+			block += blockSize;
+		}
+	}
+}
+
+bool WriteTextureContainer(const std::string &path, TextureCompression compression, unsigned int width, unsigned int height,
+	uint64_t sourceHash, const std::vector<std::vector<uint8_t>> &levels)
+{
+	if (levels.empty())
+		return false;
+
+	DDSHeader header;
+	memset(&header, 0, sizeof(header));
+	header.Magic = DDS_MAGIC;
+	header.Size = sizeof(DDSHeader) - sizeof(uint32_t);
+	header.Height = height;
+	header.Width = width;
+	header.MipMapCount = static_cast<uint32_t>(levels.size());
+	header.Reserved1[0] = DDS_BAKER_TAG;
+	header.Reserved1[1] = static_cast<uint32_t>(sourceHash);
+	header.Reserved1[2] = static_cast<uint32_t>(sourceHash >> 32);
+	header.PixelFormat.Size = sizeof(DDSPixelFormat);
+	header.Caps[0] = DDS_CAPS;
+
+	if (compression == kTextureCompression_None)
+	{
+		header.Flags = DDS_FLAGS | DDS_FLAG_PITCH;
+		header.LinearSize = width * 4;
+		header.PixelFormat.Flags = DDS_PIXEL_FORMAT_RGBA;
+		header.PixelFormat.RGBBitCount = 32;
+		header.PixelFormat.Masks[0] = 0x000000FFu;
+		header.PixelFormat.Masks[1] = 0x0000FF00u;
+		header.PixelFormat.Masks[2] = 0x00FF0000u;
+		header.PixelFormat.Masks[3] = 0xFF000000u;
+	}
+	else
+	{
+		header.Flags = DDS_FLAGS | DDS_FLAG_LINEAR_SIZE;
+		header.LinearSize = static_cast<uint32_t>(levels[0].size());
+		header.PixelFormat.Flags = DDS_PIXEL_FORMAT_FOURCC;
+		header.PixelFormat.FourCC = compression == kTextureCompression_BC3 ? DDS_FOURCC_DXT5 : DDS_FOURCC_DXT1;
+	}
+
+	std::vector<uint8_t> data(reinterpret_cast<const uint8_t *>(&header), reinterpret_cast<const uint8_t *>(&header) + sizeof(header));
+	for (const auto &level : levels)
+		data.insert(data.end(), level.begin(), level.end());
+
+	return File::WriteAllBytes(path, data.data(), data.size());
+}
+
+bool ReadTextureContainer(const void *data, size_t size, TextureCompression &outCompression, unsigned int &outWidth,
+	unsigned int &outHeight, uint64_t &outSourceHash, std::vector<TextureLevel> &outLevels, size_t &outDataOffset)
+{
+	if (size < sizeof(DDSHeader))
+		return false;
+
+	DDSHeader header;
+	memcpy(&header, data, sizeof(header));
+	if (header.Magic != DDS_MAGIC || header.Reserved1[0] != DDS_BAKER_TAG || header.Width == 0 || header.Height == 0
+		|| header.MipMapCount == 0)
+		return false;
+
+	// Only the layouts written above
+	if (header.PixelFormat.Flags == DDS_PIXEL_FORMAT_RGBA)
+	{
+		if (header.PixelFormat.RGBBitCount != 32 || header.PixelFormat.Masks[0] != 0x000000FFu)
+			return false;
+
+		outCompression = kTextureCompression_None;
+	}
+	else if (header.PixelFormat.Flags != DDS_PIXEL_FORMAT_FOURCC)
+		return false;
+	else if (header.PixelFormat.FourCC == DDS_FOURCC_DXT1)
+		outCompression = kTextureCompression_BC1;
+	else if (header.PixelFormat.FourCC == DDS_FOURCC_DXT5)
+		outCompression = kTextureCompression_BC3;
+	else return false;
+
+	// A corrupt count would push billions of levels below
+	uint32_t maxLevelCount = 1;
+	for (auto extent = (std::max)(header.Width, header.Height); extent > 1; extent /= 2)
+		maxLevelCount++;
+	if (header.MipMapCount > maxLevelCount)
+		return false;
+
+	outWidth = header.Width;
+	outHeight = header.Height;
+	outSourceHash = static_cast<uint64_t>(header.Reserved1[2]) << 32 | header.Reserved1[1];
+	outDataOffset = sizeof(DDSHeader);
+
+	// Levels follow each other without padding
+	outLevels.clear();
+	size_t offset = 0;
+	auto width = header.Width, height = header.Height;
+	for (uint32_t i = 0; i < header.MipMapCount; i++)
+	{
+		TextureLevel level;
+		level.Width = width;
+		level.Height = height;
+		level.Offset = offset;
+		level.Size = GetTextureLevelSize(outCompression, width, height);
+
+		// Truncated, written so the sum cannot wrap
+		if (level.Size > size - outDataOffset - offset)
+			return false;
+
+		outLevels.push_back(level);
+
+		offset += level.Size;
+		width = (std::max)(width / 2, 1u);
+		height = (std::max)(height / 2, 1u);
+	}
+
+	return true;
+}
\ No newline at end of file
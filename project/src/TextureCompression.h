@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define TEXTURE_CONTAINER_EXTENSION ".dds"
+#define TEXTURE_FALLBACK_EXTENSION ".rgba.dds" // Uncompressed chain of compressed textures that are not baked
+#define TEXTURE_CONTAINER_VERSION 1 // Part of the source hash, bump whenever baking changes
+
+// SSE filter kernels, define TEXTURE_MIP_NO_SIMD to use the scalar path
+#if !defined(TEXTURE_MIP_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define TEXTURE_MIP_SIMD
+#endif
+
+#ifndef TEXTURE_MIP_KAISER_RADIUS
+#define TEXTURE_MIP_KAISER_RADIUS 3.0f // In texels of the smaller level
+#endif
+
+#ifndef TEXTURE_MIP_KAISER_ALPHA
+#define TEXTURE_MIP_KAISER_ALPHA 4.0f // Higher trades sharpness for less ringing
+#endif
+
+#ifndef TEXTURE_MIP_ROWS_PER_JOB
+#define TEXTURE_MIP_ROWS_PER_JOB 32
+#endif
+
+class JobSystem;
+
+enum TextureCompression
+{
+	kTextureCompression_None, // RGBA, 32 bits per texel
+	kTextureCompression_BC1, // RGB, 4 bits per texel
+	kTextureCompression_BC3 // RGBA, 8 bits per texel
+};
+
+enum TextureMipFilter
+{
+	kTextureMipFilter_Box, // Averages 2x2 texels, blurs less than it aliases
+	kTextureMipFilter_Kaiser // Windowed sinc, keeps detail sharper at the cost of some ringing
+};
+
+// Channel order of the source image, as numbered in texture meta data
+enum TextureFormat
+{
+	kTextureFormat_RGB,
+	kTextureFormat_RGBA,
+	kTextureFormat_BGR,
+	kTextureFormat_BGRA,
+};
+
+// Texture meta data, shared by the project and the baker so both hash the same settings
+struct TextureMeta
+{
+	std::string Name; // Of the source image
+	std::string Extension;
+	TextureFormat Format;
+	TextureCompression Compression; // None by default
+	bool Mipmaps; // On by default
+	TextureMipFilter MipFilter; // Kaiser by default
+	float Anisotropy; // Off by default
+	std::string Array; // Empty if not packed into an array
+
+	TextureMeta();
+};
+
+// One level of a mip chain, the offset is relative to the first level
+struct TextureLevel
+{
+	unsigned int Width;
+	unsigned int Height;
+	size_t Offset;
+	size_t Size;
+};
+
+// Parses "none", "bc1" or "bc3" as used in texture meta data, returns false if unknown
+bool ParseTextureCompression(const std::string &name, TextureCompression &compression);
+
+// Parses "box" or "kaiser" as used in texture meta data, returns false if unknown
+bool ParseTextureMipFilter(const std::string &name, TextureMipFilter &filter);
+
+// Parses the source of a meta.json, returns false and describes the first invalid member otherwise
+bool ParseTextureMeta(const std::string &source, TextureMeta &meta, std::string &outError);
+
+unsigned int GetTextureBlockSize(TextureCompression compression); // Bytes per 4x4 block, zero if uncompressed
+size_t GetTextureLevelSize(TextureCompression compression, unsigned int width, unsigned int height);
+
+// Identifies a source image together with the settings a container was baked with
+uint64_t HashTextureSource(const void *data, size_t size, TextureMipFilter filter, bool mipmaps);
+
+// Halves an RGBA8 image down to 1x1, level 0 is a copy of the source. Every level is filtered
+// from the one above it, split into rows run on the job system if one is given
+void BuildTextureMipChain(const uint8_t *rgba, unsigned int width, unsigned int height, TextureMipFilter filter,
+	std::vector<std::vector<uint8_t>> &levels, JobSystem *jobSystem = nullptr);
+
+// Encodes an RGBA8 image into 4x4 blocks. Endpoints are taken along the principal axis of the
+// block colors, which is far from the best encoders but fast enough to bake every texture.
+// Without compression the texels are copied
+void CompressTexture(TextureCompression compression, const uint8_t *rgba, unsigned int width, unsigned int height,
+	std::vector<uint8_t> &outBlocks);
+
+// DDS holding a chain of compressed or RGBA8 levels. The source hash is kept in the
+// reserved header fields so stale containers are detected. Rows are stored bottom up like the
+// textures are uploaded, other viewers show them flipped
+bool WriteTextureContainer(const std::string &path, TextureCompression compression, unsigned int width, unsigned int height,
+	uint64_t sourceHash, const std::vector<std::vector<uint8_t>> &levels);
+
+// Returns false if the data is no container written above, outDataOffset is where the first level starts
+bool ReadTextureContainer(const void *data, size_t size, TextureCompression &outCompression, unsigned int &outWidth,
+	unsigned int &outHeight, uint64_t &outSourceHash, std::vector<TextureLevel> &outLevels, size_t &outDataOffset);
\ No newline at end of file
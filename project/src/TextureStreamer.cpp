@@ -0,0 +1,192 @@
+#include "TextureStreamer.h"
+#include "Log.h"
+#include "Memory.h"
+#include <algorithm>
+#include <cstring>
+
+static unsigned int getChannelCount(Texture::Format format)
+{
+	switch (format)
+	{
+	case Texture::kFormat_RGB:
+	case Texture::kFormat_BGR:
+		return 3;
+	default:
+		return 4;
+	}
+}
+
+TextureStreamer::TextureStreamer(size_t budget)
+	: m_NextSlot(0), m_Budget(budget), m_UploadedBytes(0)
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	for (auto &upload : m_Uploads)
+		Delete(upload.Image);
+	m_Uploads.clear();
+
+	for (auto &slot : m_Slots)
+	{
+		if (slot.Fence)
+			glDeleteSync(slot.Fence);
+		Delete(slot.PixelBuffer);
+	}
+	m_Slots.clear();
+}
+
+bool TextureStreamer::acquireSlot(Slot &slot)
+{
+	if (!slot.Fence)
+		return true;
+
+	// Never wait, the rows go out next frame instead
+	const auto status = glClientWaitSync(slot.Fence, 0, 0);
+	if (status == GL_TIMEOUT_EXPIRED)
+		return false;
+
+	glDeleteSync(slot.Fence);
+	slot.Fence = nullptr;
+	return true;
+}
+
+void TextureStreamer::beginLevel(Upload &upload, unsigned int level)
+{
+	const auto &image = *upload.Image;
+	const auto blockSize = Texture::GetBlockSize(image.Format);
+
+	upload.Level = level;
+	upload.RowSize = blockSize ? (image.Levels[level].Width + 3) / 4 * blockSize
+		: image.Levels[level].Width * getChannelCount(image.Format);
+	upload.RowHeight = blockSize ? 4 : 1;
+	upload.NextRow = 0;
+}
+
+void TextureStreamer::Add(Texture *texture, TextureImage *image, const std::string &name, unsigned int layer)
+{
+	Upload upload;
+	upload.Target = texture;
+	upload.Image = image;
+	upload.Name = name;
+	upload.Layer = layer;
+	beginLevel(upload, 0);
+
+	m_Uploads.push_back(upload);
+}
+
+void TextureStreamer::Remove(Texture *texture)
+{
+	for (auto it = m_Uploads.begin(); it != m_Uploads.end();)
+	{
+		if (it->Target == texture)
+		{
+			Delete(it->Image);
+			it = m_Uploads.erase(it);
+		}
+		else ++it;
+	}
+}
+
+void TextureStreamer::Update()
+{
+	m_UploadedBytes = 0;
+	if (m_Uploads.empty())
+		return;
+
+	if (m_Slots.empty())
+	{
+		for (unsigned int i = 0; i < TEXTURE_STREAM_BUFFERS; i++)
+			m_Slots.push_back({ New<Buffer>(Buffer::kTarget_PixelUnpackBuffer, Buffer::kUsage_StreamDraw, 
+				static_cast<size_t>(TEXTURE_STREAM_BUFFER_SIZE)), nullptr });
+	}
+
+	while (!m_Uploads.empty())
+	{
+		auto &upload = m_Uploads.front();
+		auto &slot = m_Slots[m_NextSlot];
+
+		// Budget spent, except for the first rows of the frame
+		const auto remaining = m_Budget > m_UploadedBytes ? m_Budget - m_UploadedBytes : 0;
+		if (m_UploadedBytes > 0 && remaining < upload.RowSize)
+			break;
+
+		if (!acquireSlot(slot))
+			break;
+
+		if (slot.PixelBuffer->GetSize() < upload.RowSize)
+			slot.PixelBuffer->SetSize(upload.RowSize);
+
+		const auto &image = *upload.Image;
+		const auto &level = image.Levels[upload.Level];
+		if (upload.Level == 0 && upload.NextRow == 0)
+		{
+			upload.Target->SetAnisotropy(image.Anisotropy);
+			if (!upload.Target->BeginStream(image.Width, image.Height, image.Format, static_cast<unsigned int>(image.Levels.size())))
+			{
+				LOG_ERROR("Graphics", "Texture %s does not match the other layers of its array in size, format or mip levels", 
+					upload.Name.c_str());
+
+				upload.Target->EndStream();
+				Delete(upload.Image);
+				m_Uploads.pop_front();
+				continue;
+			}
+		}
+
+		// Fill the buffer with as many rows as the budget and the buffer allow
+		const auto rowCount = (level.Height + upload.RowHeight - 1) / upload.RowHeight;
+		const auto firstRow = upload.NextRow / upload.RowHeight;
+		const auto bytes = (std::min)((std::max)(remaining, static_cast<size_t>(upload.RowSize)), slot.PixelBuffer->GetSize());
+		const auto rows = (std::min)(static_cast<unsigned int>(bytes / upload.RowSize), rowCount - firstRow);
+		const auto size = static_cast<size_t>(rows) * upload.RowSize;
+		const auto height = (std::min)(rows * upload.RowHeight, level.Height - upload.NextRow);
+
+		const auto target = const_cast<void *>(slot.PixelBuffer->Map(0, size, Buffer::kAccess_Write));
+		memcpy(target, image.Data + level.Offset + static_cast<size_t>(firstRow) * upload.RowSize, size);
+		slot.PixelBuffer->Unmap(0, size);
+
+		// Reads from the bound buffer at offset zero
+		slot.PixelBuffer->Bind();
+		upload.Target->StreamRows(upload.Layer, upload.Level, upload.NextRow, height, nullptr, size);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		slot.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_NextSlot = (m_NextSlot + 1) % m_Slots.size();
+
+		m_UploadedBytes += size;
+		upload.NextRow += height;
+
+		if (upload.NextRow < level.Height)
+			continue;
+
+		if (upload.Level + 1 < image.Levels.size())
+			beginLevel(upload, upload.Level + 1);
+		else
+		{
+			upload.Target->EndStream();
+			Delete(upload.Image);
+			m_Uploads.pop_front();
+		}
+	}
+}
+
+size_t TextureStreamer::GetBudget() const
+{
+	return m_Budget;
+}
+
+void TextureStreamer::SetBudget(size_t budget)
+{
+	m_Budget = budget;
+}
+
+size_t TextureStreamer::GetUploadedBytes() const
+{
+	return m_UploadedBytes;
+}
+
+unsigned int TextureStreamer::GetPendingCount() const
+{
+	return static_cast<unsigned int>(m_Uploads.size());
+}
\ No newline at end of file
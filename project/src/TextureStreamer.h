@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Buffer.h"
+#include "Texture.h"
+#include "TextureUtil.h"
+#include <deque>
+#include <string>
+#include <vector>
+
+#ifndef TEXTURE_STREAM_BUDGET
+#define TEXTURE_STREAM_BUDGET (2 * 1024 * 1024) // Bytes uploaded per frame
+#endif
+
+#ifndef TEXTURE_STREAM_BUFFERS
+#define TEXTURE_STREAM_BUFFERS 3 // Pixel buffers in the ring, one can be filled while the others are read
+#endif
+
+#ifndef TEXTURE_STREAM_BUFFER_SIZE
+#define TEXTURE_STREAM_BUFFER_SIZE (1024 * 1024) // Grown to fit a row if needed
+#endif
+
+// Uploads decoded images a few rows per frame through a ring of pixel unpack buffers,
+// so large textures never stall a frame. A texture keeps its previous image until all
+// rows of every level and layer arrived. Compressed images go in rows of blocks. Buffers still
+// read by the GPU are skipped until their fence passed
+class TextureStreamer
+{
+	struct Upload
+	{
+		Texture *Target;
+		TextureImage *Image; // Owned
+		std::string Name; // For the log
+		unsigned int Layer;
+		unsigned int Level;
+		unsigned int RowSize; // Bytes per row of texels or blocks in the current level
+		unsigned int RowHeight; // Texels per row, four for blocks
+		unsigned int NextRow; // In texels
+	};
+
+	struct Slot
+	{
+		Buffer *PixelBuffer;
+		GLsync Fence; // Signaled once the GPU finished reading the buffer
+	};
+
+	std::deque<Upload> m_Uploads;
+	std::vector<Slot> m_Slots; // Created on first use
+	unsigned int m_NextSlot;
+	size_t m_Budget;
+	size_t m_UploadedBytes; // During the last update
+
+	bool acquireSlot(Slot &slot);
+	static void beginLevel(Upload &upload, unsigned int level);
+
+public:
+	explicit TextureStreamer(size_t budget = TEXTURE_STREAM_BUDGET);
+	~TextureStreamer();
+
+	// No copying/moving
+	TextureStreamer(const TextureStreamer &) = delete;
+	TextureStreamer &operator=(const TextureStreamer &) = delete;
+
+	TextureStreamer(const TextureStreamer &&) = delete;
+	TextureStreamer &operator=(const TextureStreamer &&) = delete;
+
+	// Takes the image, it is deleted once uploaded. Remove the uploads of a texture before destroying it.
+	// Images not matching the layers streamed before them are dropped
+	void Add(Texture *texture, TextureImage *image, const std::string &name, unsigned int layer = 0);
+	void Remove(Texture *texture);
+
+	// Uploads up to the budget, call once per frame on the GL thread
+	void Update();
+
+	size_t GetBudget() const;
+	void SetBudget(size_t budget); // At least one row is uploaded per frame
+	size_t GetUploadedBytes() const;
+	unsigned int GetPendingCount() const;
+};
\ No newline at end of file
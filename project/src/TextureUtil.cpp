@@ -1,47 +1,131 @@
 #include "TextureUtil.h"
+#include "Log.h"
 #include "Memory.h"
 #include "Utility/FileUtil.h"
-#include <rapidjson/document.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
-enum TextureFormat
+TextureImage::TextureImage()
+	: Width(0), Height(0), Format(Texture::kFormat_RGBA), Data(nullptr), Anisotropy(1.0f)
 {
-	kTextureFormat_RGB,
-	kTextureFormat_RGBA,
-	kTextureFormat_BGR,
-	kTextureFormat_BGRA,
-};
+}
 
-Texture *LoadTextureFromFile(const std::string &path, const std::string &name)
+TextureImage::~TextureImage()
+{
+	if (Data && Storage.empty())
+		stbi_image_free(Data);
+}
+
+static Texture::Format getContainerFormat(TextureCompression compression)
+{
+	switch (compression)
+	{
+	case kTextureCompression_BC1:
+		return Texture::kFormat_BC1;
+	case kTextureCompression_BC3:
+		return Texture::kFormat_BC3;
+	default:
+		return Texture::kFormat_RGBA;
+	}
+}
+
+// Returns false if the container is missing, stale or not the requested compression
+static bool readTextureContainer(const std::string &path, uint64_t hash, TextureCompression compression, TextureImage &image)
+{
+	if (!File::Exists(path))
+		return false;
+
+	auto storage = File::ReadAllBytes(path);
+
+	TextureCompression containerCompression;
+	unsigned int width, height;
+	uint64_t sourceHash;
+	std::vector<TextureLevel> levels;
+	size_t dataOffset;
+	if (!ReadTextureContainer(storage.data(), storage.size(), containerCompression, width, height, sourceHash, levels, dataOffset)
+		|| containerCompression != compression || sourceHash != hash)
+		return false;
+
+	image.Width = width;
+	image.Height = height;
+	image.Format = getContainerFormat(compression);
+	image.Levels = std::move(levels);
+	image.Storage = std::move(storage);
+	image.Data = reinterpret_cast<unsigned char *>(image.Storage.data()) + dataOffset;
+	return true;
+}
+
+static bool isSameLayout(const TextureImage &image, const TextureImage &other)
+{
+	return image.Width == other.Width && image.Height == other.Height && image.Format == other.Format 
+		&& image.Levels.size() == other.Levels.size();
+}
+
+// Grey like the placeholder, in the layout of an uncompressed image
+static void fillTextureImage(TextureImage &image, const TextureImage &layout)
+{
+	const auto channels = layout.Format == Texture::kFormat_RGB || layout.Format == Texture::kFormat_BGR ? 3u : 4u;
+	const auto size = layout.Levels.back().Offset + layout.Levels.back().Size;
+
+	image.Width = layout.Width;
+	image.Height = layout.Height;
+	image.Format = layout.Format;
+	image.Levels = layout.Levels;
+	image.Anisotropy = layout.Anisotropy;
+	image.Storage.resize(size);
+	for (size_t i = 0; i < size; i++)
+		image.Storage[i] = static_cast<char>(i % channels == 3 ? 255 : 128);
+
+	image.Data = reinterpret_cast<unsigned char *>(image.Storage.data());
+}
+
+void DecodeTextureFromFile(const std::string &path, const std::string &name, TextureImage &image, JobSystem *jobSystem, 
+	bool allowCompression)
 {
 	// Read texture meta data
 	const auto metaLines = File::ReadAllLines(path + "/" + name + "/meta.json");
 	const auto metaSource = String::Join(metaLines, "\n");
 
-	rapidjson::Document meta;
-	meta.Parse<rapidjson::kParseCommentsFlag>(metaSource.c_str());
-	if (meta.HasParseError())
-		THROW_EXCEPTION(InvalidTextureException, "Meta data parse error: %d", meta.GetParseError());
+	TextureMeta meta;
+	std::string error;
+	if (!ParseTextureMeta(metaSource, meta, error))
+		THROW_EXCEPTION(InvalidTextureException, "Meta data %s", error.c_str());
 
-	// Get file name
-	if (!meta.HasMember("name") || !meta["name"].IsString())
-		THROW_EXCEPTION(InvalidTextureException, "Meta data invalid name");
+	const auto compression = meta.Compression;
+	const auto mipmaps = meta.Mipmaps;
+	const auto mipFilter = meta.MipFilter;
+	image.Anisotropy = meta.Anisotropy;
 
-	// Get file extension
-	if (!meta.HasMember("extension") || !meta["extension"].IsString())
-		THROW_EXCEPTION(InvalidTextureException, "Meta data invalid extension");
+	// Build paths
+	const auto basePath = path + "/" + name + "/" + meta.Name;
+	const auto filePath = basePath + "." + meta.Extension;
+	const auto containerPath = basePath + TEXTURE_CONTAINER_EXTENSION;
+	const auto cachePath = compression == kTextureCompression_None ? containerPath : basePath + TEXTURE_FALLBACK_EXTENSION;
 
-	// Get format
-	if (!meta.HasMember("format") || !meta["format"].IsInt())
-		THROW_EXCEPTION(InvalidTextureException, "Meta data invalid format");
+	const auto source = File::ReadAllBytes(filePath);
+	const auto hash = HashTextureSource(source.data(), source.size(), mipFilter, mipmaps);
+
+	// Baked containers already hold every level, drivers without S3TC decode the source instead
+	if (compression != kTextureCompression_None && allowCompression)
+	{
+		if (!GLEW_EXT_texture_compression_s3tc)
+			LOG_WARN("Graphics", "Texture %s is compressed but S3TC is not supported, decoding the source", name.c_str());
+		else if (readTextureContainer(containerPath, hash, compression, image))
+			return;
+		else
+			LOG_WARN("Graphics", "Texture %s is not baked or out of date, run the texture baker", name.c_str());
+	}
 
-	// Build path
-	const auto filePath = path + "/" + name + "/" + meta["name"].GetString() + "." + meta["extension"].GetString();
+	// Uncompressed chains are cached as well, beside the baked container for compressed textures
+	if (mipmaps && readTextureContainer(cachePath, hash, kTextureCompression_None, image))
+		return;
 
 	// Determine format
 	Texture::Format format;
-	switch (meta["format"].GetInt())
+	switch (meta.Format)
 	{
 	case kTextureFormat_RGB:
 		format = Texture::kFormat_RGB;
@@ -59,18 +143,197 @@ Texture *LoadTextureFromFile(const std::string &path, const std::string &name)
 		THROW_EXCEPTION(InvalidTextureException, "Meta data invalid unknown format");
 	}
 
+	// Global in this version of stb, every thread sets the same value
 	stbi_set_flip_vertically_on_load(true);
 
+	// Mip chains are built from RGBA texels
 	int width, height, channels;
-	const auto data = stbi_load(filePath.c_str(), &width, &height, &channels, 0);
+	const auto data = stbi_load_from_memory(reinterpret_cast<const stbi_uc *>(source.data()), static_cast<int>(source.size()),
+		&width, &height, &channels, mipmaps ? 4 : 0);
 	if (!data) THROW_EXCEPTION(InvalidTextureException, "Unable to load texture");
-	const auto texture = New<Texture>(width, height, format, data);
 
+	image.Width = width;
+	image.Height = height;
+	image.Format = format;
+	image.Data = data;
+
+	if (!mipmaps)
+	{
+		image.Levels.push_back({ image.Width, image.Height, 0, static_cast<size_t>(width) * height * channels });
+		return;
+	}
+
+	if (format == Texture::kFormat_BGR || format == Texture::kFormat_BGRA)
+	{
+		for (size_t i = 0; i < static_cast<size_t>(width) * height; i++)
+			std::swap(data[i * 4], data[i * 4 + 2]);
+	}
+
+	const auto startTime = std::chrono::steady_clock::now();
+
+	std::vector<std::vector<uint8_t>> levels;
+	BuildTextureMipChain(data, width, height, mipFilter, levels, jobSystem);
 	stbi_image_free(data);
+	image.Data = nullptr;
+
+	// Compressed textures keep their container for the baker and cache the chain beside it
+	if (!WriteTextureContainer(cachePath, kTextureCompression_None, width, height, hash, levels))
+		LOG_WARN("Graphics", "Unable to write texture cache %s", cachePath.c_str());
+
+	size_t size = 0;
+	for (const auto &level : levels)
+		size += level.size();
+
+	image.Format = Texture::kFormat_RGBA;
+	image.Storage.resize(size);
+	image.Data = reinterpret_cast<unsigned char *>(image.Storage.data());
+
+	size_t offset = 0;
+	auto levelWidth = image.Width, levelHeight = image.Height;
+	for (const auto &level : levels)
+	{
+		memcpy(image.Data + offset, level.data(), level.size());
+		image.Levels.push_back({ levelWidth, levelHeight, offset, level.size() });
+
+		offset += level.size();
+		levelWidth = (std::max)(levelWidth / 2, 1u);
+		levelHeight = (std::max)(levelHeight / 2, 1u);
+	}
+
+	LOG_INFO("Graphics", "Built %u mip levels for %s in %.2f ms", static_cast<unsigned int>(levels.size()), name.c_str(),
+		std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count());
+}
+
+void DecodeTextureArrayFromFiles(const std::string &path, const std::vector<std::string> &names, std::vector<TextureImage *> &images,
+	JobSystem *jobSystem)
+{
+	images.assign(names.size(), nullptr);
+
+	// Compressed layers are decoded again without compression unless every layer matches them
+	for (auto allowCompression : { true, false })
+	{
+		const TextureImage *layout = nullptr;
+		auto compressed = false, matching = true;
+		for (size_t i = 0; i < names.size(); i++)
+		{
+			if (allowCompression || (images[i] && Texture::IsCompressed(images[i]->Format)))
+			{
+				if (images[i])
+					Delete(images[i]);
+
+				images[i] = New<TextureImage>();
+				try
+				{
+					DecodeTextureFromFile(path, names[i], *images[i], jobSystem, allowCompression);
+				}
+				catch (std::exception &ex)
+				{
+					LOG_ERROR("Graphics", "Unable to load texture %s: %s", names[i].c_str(), ex.what());
+					Delete(images[i]);
+					images[i] = nullptr;
+				}
+			}
+
+			if (!images[i])
+			{
+				matching = false;
+				continue;
+			}
+
+			compressed |= Texture::IsCompressed(images[i]->Format);
+			if (!layout)
+				layout = images[i];
+			else if (!isSameLayout(*layout, *images[i]))
+				matching = false;
+		}
+
+		if (!compressed || matching)
+			break;
+	}
+
+	// Uncompressed by now if any layer has to be filled
+	const auto first = std::find_if(images.begin(), images.end(), [](const TextureImage *image) { return image != nullptr; });
+	if (first == images.end())
+		return;
+
+	const auto layout = *first;
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		if (images[i] && isSameLayout(*layout, *images[i]))
+			continue;
+
+		if (images[i])
+		{
+			LOG_ERROR("Graphics", "Texture %s does not match the other layers of its array in size or mip levels", names[i].c_str());
+			Delete(images[i]);
+		}
+
+		images[i] = New<TextureImage>();
+		fillTextureImage(*images[i], *layout);
+	}
+}
+
+std::map<std::string, std::vector<std::string>> FindTextureArrays(const std::string &path)
+{
+	std::map<std::string, std::vector<std::string>> arrays;
+	for (const auto &name : File::ListDirectories(path))
+	{
+		const auto metaPath = path + "/" + name + "/meta.json";
+		if (!File::Exists(metaPath))
+			continue;
+
+		// Invalid meta data is reported once the texture is loaded
+		TextureMeta meta;
+		std::string error;
+		if (!ParseTextureMeta(String::Join(File::ReadAllLines(metaPath), "\n"), meta, error) || meta.Array.empty())
+			continue;
+
+		arrays[meta.Array].push_back(name);
+	}
+
+	for (auto &pair : arrays)
+		std::sort(pair.second.begin(), pair.second.end());
+
+	return arrays;
+}
+
+Texture *LoadTextureFromFile(const std::string &path, const std::string &name)
+{
+	TextureImage image;
+	DecodeTextureFromFile(path, name, image);
+
+	const auto texture = CreatePlaceholderTexture();
+	UploadTextureImage(texture, image);
 
 	return texture;
 }
 
+void UploadTextureImage(Texture *texture, const TextureImage &image, unsigned int layer)
+{
+	texture->SetAnisotropy(image.Anisotropy);
+	if (!texture->BeginStream(image.Width, image.Height, image.Format, static_cast<unsigned int>(image.Levels.size())))
+	{
+		texture->EndStream();
+		THROW_EXCEPTION(InvalidTextureException, "Texture layer %u does not match the other layers", layer);
+	}
+
+	for (size_t i = 0; i < image.Levels.size(); i++)
+	{
+		const auto &level = image.Levels[i];
+		texture->StreamRows(layer, static_cast<unsigned int>(i), 0, level.Height, image.Data + level.Offset, level.Size);
+	}
+	texture->EndStream();
+}
+
+Texture *CreatePlaceholderTexture(unsigned int layerCount)
+{
+	std::vector<unsigned char> texels;
+	for (unsigned int i = 0; i < layerCount; i++)
+		texels.insert(texels.end(), { 128, 128, 128, 255 });
+
+	return New<Texture>(1, 1, Texture::kFormat_RGBA, texels.data(), false, layerCount);
+}
+
 void DestroyTexture(Texture *t)
 {
 	Delete(t);
@@ -1,10 +1,56 @@
 #pragma once
 
+#include "JobSystem.h"
 #include "Texture.h"
+#include "TextureCompression.h"
 #include "Utility/Exception.h"
+#include <map>
 #include <string>
+#include <vector>
 
 DEFINE_EXCEPTION(InvalidTextureException);
 
+// Decoded pixels of a texture, not yet uploaded
+struct TextureImage
+{
+	unsigned int Width;
+	unsigned int Height;
+	Texture::Format Format;
+	unsigned char *Data; // Decoded by stb, or pointing into the storage
+	std::vector<TextureLevel> Levels; // Offsets into the data
+	std::vector<char> Storage; // Baked container or built mip chain, empty for decoded images
+	float Anisotropy;
+
+	TextureImage();
+	~TextureImage();
+
+	// No copying/moving
+	TextureImage(const TextureImage &) = delete;
+	TextureImage &operator=(const TextureImage &) = delete;
+
+	TextureImage(const TextureImage &&) = delete;
+	TextureImage &operator=(const TextureImage &&) = delete;
+};
+
+// Reads and decodes without touching GL, safe to call from any thread. Mip chains are built
+// once on the CPU and cached in a container next to the source image, on the job system if
+// one is given. Textures with a compression in their meta data are read from the container
+// baked by the texture baker, a missing or stale one falls back to the uncompressed chain, as
+// does turning compression off
+void DecodeTextureFromFile(const std::string &path, const std::string &name, TextureImage &image, JobSystem *jobSystem = nullptr,
+	bool allowCompression = true);
+
+// Decodes every layer of an array, one owned image per layer. Layers are only compressed if all
+// of them are, layers that fail to load or do not match the others in size or mip levels are
+// filled with grey so none is left undefined. All images are null if no layer loaded
+void DecodeTextureArrayFromFiles(const std::string &path, const std::vector<std::string> &names, std::vector<TextureImage *> &images,
+	JobSystem *jobSystem = nullptr);
+
+// Textures naming an array in their meta data, by array and sorted by name. Members share
+// one texture with a layer each, so materials using them can be drawn without rebinding
+std::map<std::string, std::vector<std::string>> FindTextureArrays(const std::string &path);
+
 Texture *LoadTextureFromFile(const std::string &path, const std::string &name);
+void UploadTextureImage(Texture *texture, const TextureImage &image, unsigned int layer = 0); // Every level at once
+Texture *CreatePlaceholderTexture(unsigned int layerCount = 1); // Single grey texel per layer, shown until the images are loaded
 void DestroyTexture(Texture *t);
\ No newline at end of file
@@ -1,87 +1,60 @@
 #include "Transform.h"
+#include <atomic>
+#include <cassert>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/matrix_decompose.hpp>
 #include <glm/gtx/quaternion.hpp>
 
-void Transform::applyOperation(const Transform *transform, glm::mat4 &matrix, Operation operation)
-{
-	if (transform->m_Parent)
-		applyOperation(transform->m_Parent, matrix, operation);
+static std::atomic<unsigned int> g_TransformParallelUpdates(0);
 
-	switch (operation)
-	{
-	case kOperation_Position:
-		matrix = glm::translate(matrix, transform->m_Position);
-		break;
-	case kOperation_Rotation:
-		matrix *= glm::toMat4(transform->m_Rotation);
-		break;
-	}
+void Transform::invalidate()
+{
+	m_LocalVersion++;
 }
 
-void AccumulateTransforms(const Transform *transform, glm::mat4 &m)
+void Transform::resolve() const
 {
-	if (transform == nullptr)
+	// Resolving a stale parent would write it from several jobs at once
+	assert(g_TransformParallelUpdates == 0 || !m_Parent || m_Parent->isResolved());
+
+	// Parents resolve first so their world version is current
+	if (m_Parent)
+		m_Parent->resolve();
+
+	const auto parentVersion = m_Parent ? m_Parent->m_WorldVersion : 0;
+	if (m_ResolvedLocalVersion == m_LocalVersion && m_ResolvedParentVersion == parentVersion)
 		return;
 
-	AccumulateTransforms(transform->GetParent(), m);
+	// Rotations accumulate down the chain, positions are offsets from the parent position
+	m_WorldRotation = glm::mat3_cast(m_Rotation);
+	m_WorldPosition = m_Position;
+	if (m_Parent)
+	{
+		m_WorldRotation = m_Parent->m_WorldRotation * m_WorldRotation;
+		m_WorldPosition += m_Parent->m_WorldPosition;
+	}
 
-	glm::mat4 matrix(1.0f);
-	matrix = glm::scale(matrix, transform->GetScale());
-	matrix = matrix * glm::toMat4(transform->GetRotation());
-	matrix = glm::translate(matrix, transform->GetPosition());
+	// Build transform matrix, scale is not inherited
+	m_Matrix = glm::mat4(m_WorldRotation);
+	m_Matrix[3] = glm::vec4(m_WorldPosition, 1.0f);
+	m_Matrix = glm::scale(m_Matrix, m_Scale);
 
-	m = m * matrix;
+	m_ResolvedLocalVersion = m_LocalVersion;
+	m_ResolvedParentVersion = parentVersion;
+	m_WorldVersion++;
 }
 
-void Transform::update()
+bool Transform::isResolved() const
 {
-	// Use basic transformations
-	m_Matrix = glm::mat4(1.0f);
-
-	//m_Matrix = m_Matrix * glm::toMat4(m_Rotation);
-	//m_Matrix = m_Matrix * glm::translate(glm::mat4(1.0f), m_Position);
-	//m_Matrix = glm::scale(m_Matrix, m_Scale);
-
-	//m_Matrix = glm::scale(m_Matrix, m_Scale);
-	//m_Matrix = m_Matrix * glm::toMat4(m_Rotation);
-	//m_Matrix = m_Matrix * glm::translate(glm::mat4(1.0f), m_Position);
-	
-	// correct order
-	//m_Matrix = glm::scale(m_Matrix, m_Scale);
-	//m_Matrix = m_Matrix * glm::toMat4(m_Rotation);
-	//m_Matrix = glm::translate(m_Matrix, m_Position);
-
-	/*
-	// Get translations
-	glm::mat4 transforms(1.0f);
-	AccumulateTransforms(GetParent(), transforms);
+	if (m_Parent && !m_Parent->isResolved())
+		return false;
 
-	// Decompose total matrix
-	const auto translation = glm::vec3(transforms[3]);
-
-	m_Matrix = glm::scale(m_Matrix, m_Scale);
-	m_Matrix = m_Matrix * glm::toMat4(m_Rotation);
-	m_Matrix = glm::translate(m_Matrix, translation);
-	m_Matrix = glm::translate(m_Matrix, m_Position);
-	*/
-
-	// Get total rotation
-	glm::mat4 rotationTransform(1.0f);
-	applyOperation(this, rotationTransform, kOperation_Rotation);
-
-	// Get total position
-	glm::mat4 positionTransform(1.0f);
-	applyOperation(this, positionTransform, kOperation_Position);
-
-	// Build transform matrix
-	m_Matrix = rotationTransform;
-	m_Matrix[3] = positionTransform[3];
-	m_Matrix = glm::scale(m_Matrix, m_Scale);
+	return m_ResolvedLocalVersion == m_LocalVersion && m_ResolvedParentVersion == (m_Parent ? m_Parent->m_WorldVersion : 0);
 }
 
 Transform::Transform(Transform *parent)
-	: m_Position(0.0f), m_Rotation(0.0f, 0.0f, 0.0f, 0.0f), m_Scale(1.0f), m_Matrix(1.0f), m_Parent(parent)
+	: m_Position(0.0f), m_Rotation(0.0f, 0.0f, 0.0f, 0.0f), m_Scale(1.0f), m_Parent(parent), m_LocalVersion(1), m_WorldRotation(1.0f), 
+	m_WorldPosition(0.0f), m_Matrix(1.0f), m_WorldVersion(0), m_ResolvedLocalVersion(0), m_ResolvedParentVersion(0)
 {
 }
 
@@ -93,7 +66,7 @@ Transform *Transform::GetParent() const
 void Transform::SetParent(Transform *parent)
 {
 	m_Parent = parent;
-	update();
+	invalidate();
 }
 
 const glm::vec3 &Transform::GetPosition() const
@@ -104,13 +77,13 @@ const glm::vec3 &Transform::GetPosition() const
 void Transform::SetPosition(const glm::vec3 &position)
 {
 	m_Position = position;
-	update();
+	invalidate();
 }
 
 void Transform::OffsetPosition(const glm::vec3 &offset)
 {
 	m_Position += offset;
-	update();
+	invalidate();
 }
 
 const glm::vec3 &Transform::GetScale() const
@@ -121,7 +94,7 @@ const glm::vec3 &Transform::GetScale() const
 void Transform::SetScale(const glm::vec3 &scale)
 {
 	m_Scale = scale;
-	update();
+	invalidate();
 }
 
 const glm::quat &Transform::GetRotation() const
@@ -132,7 +105,7 @@ const glm::quat &Transform::GetRotation() const
 void Transform::SetRotation(const glm::quat &rotation)
 {
 	m_Rotation = rotation;
-	update();
+	invalidate();
 }
 
 void Transform::SetRotation(const glm::vec3 &v, float radians)
@@ -140,7 +113,7 @@ void Transform::SetRotation(const glm::vec3 &v, float radians)
 	glm::mat4 rotationMatrix(1.0f);
 	rotationMatrix = glm::rotate(rotationMatrix, radians, v);
 	m_Rotation = glm::toQuat(rotationMatrix);
-	update();
+	invalidate();
 }
 
 void Transform::OffsetRotation(const glm::vec3 &v, float radians)
@@ -148,7 +121,7 @@ void Transform::OffsetRotation(const glm::vec3 &v, float radians)
 	auto rotationMatrix = glm::toMat4(m_Rotation);
 	rotationMatrix = glm::rotate(rotationMatrix, radians, v);
 	m_Rotation = glm::toQuat(rotationMatrix);
-	update();
+	invalidate();
 }
 
 void Transform::LookAt(const glm::vec3 &pos)
@@ -158,30 +131,50 @@ void Transform::LookAt(const glm::vec3 &pos)
 
 	// Update transform
 	m_Rotation = glm::toQuat(viewMat);
-	update();
+	invalidate();
 }
 
 glm::vec3 Transform::Up() const
 {
-	return -m_Matrix[1];
+	return -GetMatrix()[1];
 }
 
 glm::vec3 Transform::Forward() const
 {
-	return -m_Matrix[2];
+	return -GetMatrix()[2];
 }
 
 glm::vec3 Transform::Right() const
 {
-	return -m_Matrix[0];
+	return -GetMatrix()[0];
 }
 
 const glm::mat4 &Transform::GetMatrix() const
 {
+	resolve();
 	return m_Matrix;
 }
 
 void Transform::SetMatrix(const glm::mat4 &mat)
 {
+	// Resolve first so pending changes do not replace the matrix later
+	resolve();
 	m_Matrix = mat;
+	m_WorldVersion++;
+}
+
+unsigned int Transform::GetVersion() const
+{
+	resolve();
+	return m_WorldVersion;
+}
+
+void Transform::BeginParallelUpdate()
+{
+	g_TransformParallelUpdates++;
+}
+
+void Transform::EndParallelUpdate()
+{
+	g_TransformParallelUpdates--;
 }
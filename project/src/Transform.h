@@ -3,25 +3,28 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 
+// World matrices are resolved lazily, setters only bump the local version and
+// children notice parent changes by comparing the parent's world version
 class Transform
 {
-	enum Operation
-	{
-		kOperation_Position,
-		kOperation_Rotation
-	};
-
 	glm::vec3 m_Position;
 	glm::quat m_Rotation;
 	glm::vec3 m_Scale;
 
-	glm::mat4 m_Matrix;
-
 	Transform *m_Parent;
+	unsigned int m_LocalVersion;
 
-	static void applyOperation(const Transform *transform, glm::mat4 &matrix, Operation operation);
+	// Resolved on demand
+	mutable glm::mat3 m_WorldRotation; // Rotations of the parent chain
+	mutable glm::vec3 m_WorldPosition; // Positions of the parent chain
+	mutable glm::mat4 m_Matrix;
+	mutable unsigned int m_WorldVersion;
+	mutable unsigned int m_ResolvedLocalVersion;
+	mutable unsigned int m_ResolvedParentVersion;
 
-	void update();
+	void invalidate();
+	void resolve() const;
+	bool isResolved() const;
 	
 public:
 	Transform(Transform *parent = nullptr);
@@ -48,6 +51,15 @@ public:
 	glm::vec3 Right() const;
 
 	const glm::mat4 &GetMatrix() const;
+
+	// Overrides the world matrix until this transform or its parents change
 	void SetMatrix(const glm::mat4 &mat);
 
+	// Changes whenever the world matrix is recomputed
+	unsigned int GetVersion() const;
+
+	// Brackets updates writing transforms from several jobs. Each job may only write and resolve its
+	// own transforms, their parents are shared and must be resolved before, debug builds assert it
+	static void BeginParallelUpdate();
+	static void EndParallelUpdate();
 };
\ No newline at end of file
@@ -0,0 +1,439 @@
+#include "TransformSystem.h"
+#include <algorithm>
+#include <type_traits>
+
+#ifdef TRANSFORM_SYSTEM_SIMD
+#include <xmmintrin.h>
+#endif
+
+#define TRANSFORM_SLOT_INVALID 0xFFFFFFFFu
+
+TransformSystem::TransformSystem(size_t capacity)
+	: m_HierarchyChanged(false)
+{
+	m_HandleSlots.reserve(capacity);
+	m_HandleParents.reserve(capacity);
+
+	// Identity root
+	resize(1);
+	m_SlotHandles[0] = TRANSFORM_HANDLE_INVALID;
+}
+
+unsigned int TransformSystem::getSlot(TransformHandle handle) const
+{
+	if (handle >= m_HandleSlots.size() || m_HandleSlots[handle] == TRANSFORM_SLOT_INVALID)
+		THROW_EXCEPTION(TransformHandleException, "Invalid transform handle %u", handle);
+
+	return m_HandleSlots[handle];
+}
+
+void TransformSystem::resize(size_t count)
+{
+	const auto first = m_SlotHandles.size();
+
+	m_PositionX.resize(count, 0.0f);
+	m_PositionY.resize(count, 0.0f);
+	m_PositionZ.resize(count, 0.0f);
+	m_RotationX.resize(count, 0.0f);
+	m_RotationY.resize(count, 0.0f);
+	m_RotationZ.resize(count, 0.0f);
+	m_RotationW.resize(count, 1.0f);
+	m_ScaleX.resize(count, 1.0f);
+	m_ScaleY.resize(count, 1.0f);
+	m_ScaleZ.resize(count, 1.0f);
+	m_Parent.resize(count, 0);
+
+	for (auto &c : m_WorldRotation)
+		c.resize(count, 0.0f);
+	for (auto &c : m_WorldPosition)
+		c.resize(count, 0.0f);
+
+	// Diagonal of new world rotations
+	for (auto i = first; i < count; i++)
+	{
+		m_WorldRotation[0][i] = 1.0f;
+		m_WorldRotation[4][i] = 1.0f;
+		m_WorldRotation[8][i] = 1.0f;
+	}
+
+	m_Matrices.resize(count, glm::mat4(1.0f));
+	m_SlotHandles.resize(count, TRANSFORM_HANDLE_INVALID);
+}
+
+void TransformSystem::sort()
+{
+	// Depth of every live handle, top level transforms are depth 1
+	std::vector<unsigned int> depths(m_HandleSlots.size(), 0);
+	unsigned int maxDepth = 0;
+	for (TransformHandle h = 0; h < m_HandleSlots.size(); h++)
+	{
+		if (m_HandleSlots[h] == TRANSFORM_SLOT_INVALID || depths[h])
+			continue;
+
+		// Walk up to the first known depth
+		unsigned int depth = 0;
+		for (auto p = h; p != TRANSFORM_HANDLE_INVALID && !depths[p]; p = m_HandleParents[p])
+			depth++;
+
+		auto top = h;
+		for (unsigned int i = 0; i < depth; i++)
+			top = m_HandleParents[top];
+		const auto base = top == TRANSFORM_HANDLE_INVALID ? 0 : depths[top];
+
+		// Fill in the walked chain
+		auto d = base + depth;
+		for (auto p = h; p != top; p = m_HandleParents[p])
+			depths[p] = d--;
+
+		maxDepth = std::max(maxDepth, base + depth);
+	}
+
+	// Transforms with children come first in their level
+	std::vector<bool> parents(m_HandleSlots.size(), false);
+	for (TransformHandle h = 0; h < m_HandleSlots.size(); h++)
+	{
+		if (m_HandleSlots[h] != TRANSFORM_SLOT_INVALID && m_HandleParents[h] != TRANSFORM_HANDLE_INVALID)
+			parents[m_HandleParents[h]] = true;
+	}
+
+	// Counting sort by depth and parent/leaf, stable so siblings keep their relative order
+	const auto getBucket = [&](TransformHandle h) { return (depths[h] - 1) * 2 + (parents[h] ? 0 : 1); };
+
+	std::vector<unsigned int> bucketStarts(maxDepth * 2 + 1, 0);
+	for (TransformHandle h = 0; h < m_HandleSlots.size(); h++)
+	{
+		if (m_HandleSlots[h] != TRANSFORM_SLOT_INVALID)
+			bucketStarts[getBucket(h) + 1]++;
+	}
+
+	bucketStarts[0] = 1; // After the root
+	for (size_t i = 1; i < bucketStarts.size(); i++)
+		bucketStarts[i] += bucketStarts[i - 1];
+
+	m_Levels.clear();
+	for (size_t i = 0; i + 1 < bucketStarts.size(); i++)
+	{
+		if (bucketStarts[i] != bucketStarts[i + 1])
+			m_Levels.push_back({ bucketStarts[i], bucketStarts[i + 1], i % 2 == 0 });
+	}
+
+	std::vector<unsigned int> sources(bucketStarts.back()); // Old slot of each new slot
+	std::vector<unsigned int> newSlots(m_HandleSlots.size(), TRANSFORM_SLOT_INVALID);
+	sources[0] = 0;
+	for (TransformHandle h = 0; h < m_HandleSlots.size(); h++)
+	{
+		if (m_HandleSlots[h] == TRANSFORM_SLOT_INVALID)
+			continue;
+
+		const auto slot = bucketStarts[getBucket(h)]++;
+		sources[slot] = m_HandleSlots[h];
+		newSlots[h] = slot;
+	}
+
+	const auto permute = [&sources](auto &values)
+	{
+		std::remove_reference_t<decltype(values)> sorted(sources.size());
+		for (size_t i = 0; i < sources.size(); i++)
+			sorted[i] = values[sources[i]];
+		values.swap(sorted);
+	};
+
+	permute(m_PositionX);
+	permute(m_PositionY);
+	permute(m_PositionZ);
+	permute(m_RotationX);
+	permute(m_RotationY);
+	permute(m_RotationZ);
+	permute(m_RotationW);
+	permute(m_ScaleX);
+	permute(m_ScaleY);
+	permute(m_ScaleZ);
+	for (auto &c : m_WorldRotation)
+		permute(c);
+	for (auto &c : m_WorldPosition)
+		permute(c);
+	permute(m_Matrices);
+
+	// Rebuild slot links
+	m_Parent.assign(sources.size(), 0);
+	m_SlotHandles.assign(sources.size(), TRANSFORM_HANDLE_INVALID);
+	for (TransformHandle h = 0; h < m_HandleSlots.size(); h++)
+	{
+		if (newSlots[h] == TRANSFORM_SLOT_INVALID)
+			continue;
+
+		const auto parent = m_HandleParents[h];
+		m_Parent[newSlots[h]] = parent == TRANSFORM_HANDLE_INVALID ? 0 : newSlots[parent];
+		m_SlotHandles[newSlots[h]] = h;
+	}
+
+	m_HandleSlots.swap(newSlots);
+	m_HierarchyChanged = false;
+}
+
+void TransformSystem::updateRange(const LevelRange &range)
+{
+	const auto last = range.Last;
+	auto i = range.First;
+
+#ifdef TRANSFORM_SYSTEM_SIMD
+	const auto two = _mm_set1_ps(2.0f);
+	const auto one = _mm_set1_ps(1.0f);
+	const auto zero = _mm_setzero_ps();
+
+	for (; i + 4 <= last; i += 4)
+	{
+		// Local rotation from the quaternions, same layout as glm::mat3_cast
+		const auto x = _mm_loadu_ps(&m_RotationX[i]);
+		const auto y = _mm_loadu_ps(&m_RotationY[i]);
+		const auto z = _mm_loadu_ps(&m_RotationZ[i]);
+		const auto w = _mm_loadu_ps(&m_RotationW[i]);
+
+		const auto xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+		const auto xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+		const auto wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+		__m128 local[9];
+		local[0] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+		local[1] = _mm_mul_ps(two, _mm_add_ps(xy, wz));
+		local[2] = _mm_mul_ps(two, _mm_sub_ps(xz, wy));
+		local[3] = _mm_mul_ps(two, _mm_sub_ps(xy, wz));
+		local[4] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+		local[5] = _mm_mul_ps(two, _mm_add_ps(yz, wx));
+		local[6] = _mm_mul_ps(two, _mm_add_ps(xz, wy));
+		local[7] = _mm_mul_ps(two, _mm_sub_ps(yz, wx));
+		local[8] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+
+		// Gather parents, they were written by an earlier level. Siblings are
+		// usually adjacent, so a shared parent is loaded once
+		const auto p0 = m_Parent[i], p1 = m_Parent[i + 1], p2 = m_Parent[i + 2], p3 = m_Parent[i + 3];
+		const auto shared = p0 == p1 && p1 == p2 && p2 == p3;
+
+		__m128 parent[12];
+		for (unsigned int k = 0; k < 12; k++)
+		{
+			const auto &c = k < 9 ? m_WorldRotation[k] : m_WorldPosition[k - 9];
+			parent[k] = shared ? _mm_set1_ps(c[p0]) : _mm_setr_ps(c[p0], c[p1], c[p2], c[p3]);
+		}
+
+		// World = parent * local
+		__m128 world[9];
+		for (unsigned int c = 0; c < 3; c++)
+		{
+			for (unsigned int r = 0; r < 3; r++)
+			{
+				world[c * 3 + r] = _mm_add_ps(_mm_add_ps(
+					_mm_mul_ps(parent[0 * 3 + r], local[c * 3 + 0]),
+					_mm_mul_ps(parent[1 * 3 + r], local[c * 3 + 1])),
+					_mm_mul_ps(parent[2 * 3 + r], local[c * 3 + 2]));
+
+			}
+		}
+
+		const __m128 position[3] = {
+			_mm_add_ps(_mm_loadu_ps(&m_PositionX[i]), parent[9]),
+			_mm_add_ps(_mm_loadu_ps(&m_PositionY[i]), parent[10]),
+			_mm_add_ps(_mm_loadu_ps(&m_PositionZ[i]), parent[11])
+		};
+
+		// Only read by children
+		if (range.Parents)
+		{
+			for (unsigned int k = 0; k < 9; k++)
+				_mm_storeu_ps(&m_WorldRotation[k][i], world[k]);
+			for (unsigned int k = 0; k < 3; k++)
+				_mm_storeu_ps(&m_WorldPosition[k][i], position[k]);
+		}
+
+		// Transpose to one column per matrix
+		const __m128 scale[3] = { _mm_loadu_ps(&m_ScaleX[i]), _mm_loadu_ps(&m_ScaleY[i]), _mm_loadu_ps(&m_ScaleZ[i]) };
+		const auto matrices = reinterpret_cast<float *>(&m_Matrices[i]);
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			__m128 r0, r1, r2, r3;
+			if (c < 3)
+			{
+				r0 = _mm_mul_ps(world[c * 3 + 0], scale[c]);
+				r1 = _mm_mul_ps(world[c * 3 + 1], scale[c]);
+				r2 = _mm_mul_ps(world[c * 3 + 2], scale[c]);
+				r3 = zero;
+			}
+			else
+			{
+				r0 = position[0];
+				r1 = position[1];
+				r2 = position[2];
+				r3 = one;
+			}
+
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_storeu_ps(matrices + 0 * 16 + c * 4, r0);
+			_mm_storeu_ps(matrices + 1 * 16 + c * 4, r1);
+			_mm_storeu_ps(matrices + 2 * 16 + c * 4, r2);
+			_mm_storeu_ps(matrices + 3 * 16 + c * 4, r3);
+		}
+	}
+#endif
+
+	for (; i < last; i++)
+	{
+		const glm::quat rotation(m_RotationW[i], m_RotationX[i], m_RotationY[i], m_RotationZ[i]);
+		const auto local = glm::mat3_cast(rotation);
+
+		const auto p = m_Parent[i];
+		glm::mat3 parent;
+		for (unsigned int k = 0; k < 9; k++)
+			parent[k / 3][k % 3] = m_WorldRotation[k][p];
+
+		const auto world = parent * local;
+		const glm::vec3 position(m_PositionX[i] + m_WorldPosition[0][p], m_PositionY[i] + m_WorldPosition[1][p],
+			m_PositionZ[i] + m_WorldPosition[2][p]);
+
+		if (range.Parents)
+		{
+			for (unsigned int k = 0; k < 9; k++)
+				m_WorldRotation[k][i] = world[k / 3][k % 3];
+
+			m_WorldPosition[0][i] = position.x;
+			m_WorldPosition[1][i] = position.y;
+			m_WorldPosition[2][i] = position.z;
+		}
+
+		auto &matrix = m_Matrices[i];
+		matrix[0] = glm::vec4(world[0] * m_ScaleX[i], 0.0f);
+		matrix[1] = glm::vec4(world[1] * m_ScaleY[i], 0.0f);
+		matrix[2] = glm::vec4(world[2] * m_ScaleZ[i], 0.0f);
+		matrix[3] = glm::vec4(position, 1.0f);
+	}
+}
+
+TransformHandle TransformSystem::Create(TransformHandle parent)
+{
+	if (parent != TRANSFORM_HANDLE_INVALID)
+		getSlot(parent);
+
+	TransformHandle handle;
+	if (!m_FreeHandles.empty())
+	{
+		handle = m_FreeHandles.back();
+		m_FreeHandles.pop_back();
+	}
+	else
+	{
+		handle = m_HandleSlots.size();
+		m_HandleSlots.push_back(TRANSFORM_SLOT_INVALID);
+		m_HandleParents.push_back(TRANSFORM_HANDLE_INVALID);
+	}
+
+	// Append, the next update sorts it into its level
+	const auto slot = static_cast<unsigned int>(m_SlotHandles.size());
+	resize(slot + 1);
+	m_SlotHandles[slot] = handle;
+	m_HandleSlots[handle] = slot;
+	m_HandleParents[handle] = parent;
+	m_HierarchyChanged = true;
+
+	return handle;
+}
+
+void TransformSystem::Destroy(TransformHandle handle)
+{
+	const auto slot = getSlot(handle);
+
+	for (auto &parent : m_HandleParents)
+	{
+		if (parent == handle)
+			parent = TRANSFORM_HANDLE_INVALID;
+	}
+
+	// The slot is dropped by the next sort
+	m_SlotHandles[slot] = TRANSFORM_HANDLE_INVALID;
+	m_HandleSlots[handle] = TRANSFORM_SLOT_INVALID;
+	m_HandleParents[handle] = TRANSFORM_HANDLE_INVALID;
+	m_FreeHandles.push_back(handle);
+	m_HierarchyChanged = true;
+}
+
+TransformHandle TransformSystem::GetParent(TransformHandle handle) const
+{
+	getSlot(handle);
+	return m_HandleParents[handle];
+}
+
+void TransformSystem::SetParent(TransformHandle handle, TransformHandle parent)
+{
+	getSlot(handle);
+
+	// Reject cycles
+	for (auto p = parent; p != TRANSFORM_HANDLE_INVALID; p = m_HandleParents[p])
+	{
+		getSlot(p);
+		if (p == handle)
+			THROW_EXCEPTION(TransformHandleException, "Transform %u cannot be parented to its own child", handle);
+	}
+
+	m_HandleParents[handle] = parent;
+	m_HierarchyChanged = true;
+}
+
+glm::vec3 TransformSystem::GetPosition(TransformHandle handle) const
+{
+	const auto slot = getSlot(handle);
+	return glm::vec3(m_PositionX[slot], m_PositionY[slot], m_PositionZ[slot]);
+}
+
+void TransformSystem::SetPosition(TransformHandle handle, const glm::vec3 &position)
+{
+	const auto slot = getSlot(handle);
+	m_PositionX[slot] = position.x;
+	m_PositionY[slot] = position.y;
+	m_PositionZ[slot] = position.z;
+}
+
+glm::quat TransformSystem::GetRotation(TransformHandle handle) const
+{
+	const auto slot = getSlot(handle);
+	return glm::quat(m_RotationW[slot], m_RotationX[slot], m_RotationY[slot], m_RotationZ[slot]);
+}
+
+void TransformSystem::SetRotation(TransformHandle handle, const glm::quat &rotation)
+{
+	const auto slot = getSlot(handle);
+	m_RotationX[slot] = rotation.x;
+	m_RotationY[slot] = rotation.y;
+	m_RotationZ[slot] = rotation.z;
+	m_RotationW[slot] = rotation.w;
+}
+
+glm::vec3 TransformSystem::GetScale(TransformHandle handle) const
+{
+	const auto slot = getSlot(handle);
+	return glm::vec3(m_ScaleX[slot], m_ScaleY[slot], m_ScaleZ[slot]);
+}
+
+void TransformSystem::SetScale(TransformHandle handle, const glm::vec3 &scale)
+{
+	const auto slot = getSlot(handle);
+	m_ScaleX[slot] = scale.x;
+	m_ScaleY[slot] = scale.y;
+	m_ScaleZ[slot] = scale.z;
+}
+
+const glm::mat4 &TransformSystem::GetMatrix(TransformHandle handle) const
+{
+	return m_Matrices[getSlot(handle)];
+}
+
+void TransformSystem::Update()
+{
+	if (m_HierarchyChanged)
+		sort();
+
+	for (const auto &range : m_Levels)
+		updateRange(range);
+}
+
+size_t TransformSystem::GetCount() const
+{
+	return m_HandleSlots.size() - m_FreeHandles.size();
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Utility/Exception.h"
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// SSE kernels, define TRANSFORM_SYSTEM_NO_SIMD to use the scalar path
+#if !defined(TRANSFORM_SYSTEM_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define TRANSFORM_SYSTEM_SIMD
+#endif
+
+typedef unsigned int TransformHandle;
+
+#define TRANSFORM_HANDLE_INVALID 0xFFFFFFFFu
+
+DEFINE_EXCEPTION(TransformHandleException);
+
+// Transforms stored as structure of arrays, sorted by depth so parents come before their
+// children and every level is updated in one linear pass. Composition matches Transform:
+// rotations accumulate, positions are offsets from the parent and scale is local.
+// Not thread safe
+class TransformSystem
+{
+	// Slot 0 is an identity root every top level transform is parented to
+	std::vector<float> m_PositionX;
+	std::vector<float> m_PositionY;
+	std::vector<float> m_PositionZ;
+	std::vector<float> m_RotationX;
+	std::vector<float> m_RotationY;
+	std::vector<float> m_RotationZ;
+	std::vector<float> m_RotationW;
+	std::vector<float> m_ScaleX;
+	std::vector<float> m_ScaleY;
+	std::vector<float> m_ScaleZ;
+	std::vector<unsigned int> m_Parent; // Slot of the parent
+
+	// Accumulated rotation (column major) and position of each slot, read by children
+	std::vector<float> m_WorldRotation[9];
+	std::vector<float> m_WorldPosition[3];
+
+	std::vector<glm::mat4> m_Matrices;
+
+	// Sorted slot ranges, [First, Last), every range only reads earlier ranges.
+	// Each level is split into transforms with children and leaves, leaves skip the world arrays
+	struct LevelRange
+	{
+		unsigned int First;
+		unsigned int Last;
+		bool Parents;
+	};
+
+	std::vector<LevelRange> m_Levels;
+
+	// Handle indirection, slots move when the hierarchy is sorted
+	std::vector<unsigned int> m_HandleSlots;
+	std::vector<TransformHandle> m_HandleParents;
+	std::vector<TransformHandle> m_SlotHandles;
+	std::vector<TransformHandle> m_FreeHandles;
+	bool m_HierarchyChanged;
+
+	unsigned int getSlot(TransformHandle handle) const;
+	void resize(size_t count);
+	void sort();
+	void updateRange(const LevelRange &range);
+
+public:
+	TransformSystem(size_t capacity = 0);
+
+	// No copying/moving
+	TransformSystem(const TransformSystem &) = delete;
+	TransformSystem &operator=(const TransformSystem &) = delete;
+
+	TransformSystem(const TransformSystem &&) = delete;
+	TransformSystem &operator=(const TransformSystem &&) = delete;
+
+	TransformHandle Create(TransformHandle parent = TRANSFORM_HANDLE_INVALID);
+
+	// Children of the transform are moved to the top level
+	void Destroy(TransformHandle handle);
+
+	TransformHandle GetParent(TransformHandle handle) const;
+	void SetParent(TransformHandle handle, TransformHandle parent);
+
+	glm::vec3 GetPosition(TransformHandle handle) const;
+	void SetPosition(TransformHandle handle, const glm::vec3 &position);
+
+	glm::quat GetRotation(TransformHandle handle) const;
+	void SetRotation(TransformHandle handle, const glm::quat &rotation);
+
+	glm::vec3 GetScale(TransformHandle handle) const;
+	void SetScale(TransformHandle handle, const glm::vec3 &scale);
+
+	// World matrix as of the last update
+	const glm::mat4 &GetMatrix(TransformHandle handle) const;
+
+	// Sorts the hierarchy if it changed and recomputes every world matrix
+	void Update();
+
+	size_t GetCount() const;
+};
\ No newline at end of file
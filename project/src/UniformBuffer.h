@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Buffer.h"
+
+// Block data shared by all programs through a fixed binding point,
+// TData must follow the std140 layout of the block
+template<typename TData>
+class UniformBuffer : public Buffer
+{
+	unsigned int m_Binding;
+
+public:
+	UniformBuffer(unsigned int binding)
+		: Buffer(kTarget_UniformBuffer, kUsage_DynamicDraw, sizeof(TData)), m_Binding(binding)
+	{
+	}
+
+	~UniformBuffer() = default;
+
+	// No copying/moving
+	UniformBuffer(const UniformBuffer &) = delete;
+	UniformBuffer &operator=(const UniformBuffer &) = delete;
+
+	UniformBuffer(const UniformBuffer &&) = delete;
+	UniformBuffer &operator=(const UniformBuffer &&) = delete;
+
+	unsigned int GetBinding() const
+	{
+		return m_Binding;
+	}
+
+	// Replaces the whole block, the old storage is orphaned
+	void SetData(const TData &data)
+	{
+		Buffer::SetData(0, sizeof(TData), &data);
+	}
+
+	void Bind()
+	{
+		glBindBufferBase(kTarget_UniformBuffer, m_Binding, m_ID);
+	}
+};
\ No newline at end of file
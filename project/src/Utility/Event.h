@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../Memory.h"
 #include <mutex>
 #include <vector>
 #include <functional>
@@ -66,10 +67,9 @@ public:
 
 	void Trigger(TArgs... args)
 	{
-		std::vector<std::function<void(TArgs...)>> callbacks(m_Callbacks.size());
-
+		// Copy callbacks into frame memory so they can modify the event
 		m_Mutex.lock();
-		std::copy(m_Callbacks.begin(), m_Callbacks.end(), callbacks.begin());
+		FrameVector<std::function<void(TArgs...)>> callbacks(m_Callbacks.begin(), m_Callbacks.end());
 		m_Mutex.unlock();
 
 		for (auto iterator = callbacks.begin(); iterator != callbacks.end(); ++iterator)
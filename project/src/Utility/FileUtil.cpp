@@ -1,6 +1,18 @@
 #include "FileUtil.h"
 #include <fstream>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 bool File::Exists(const std::string &path)
 {
 	return std::ifstream(path).is_open();
@@ -19,3 +31,163 @@ std::vector<std::string> File::ReadAllLines(const std::string &path)
 	
 	return result;
 }
+
+
+std::vector<char> File::ReadAllBytes(const std::string &path)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		THROW_EXCEPTION(FileNotFoundException, "File not found: %s", path.c_str());
+
+	std::vector<char> result(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(result.data(), result.size());
+
+	return result;
+}
+
+std::vector<std::string> File::ListDirectories(const std::string &path)
+{
+	std::vector<std::string> result;
+
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	const auto find = FindFirstFileA((path + "\\*").c_str(), &data);
+	if (find == INVALID_HANDLE_VALUE)
+		return result;
+
+	do
+	{
+		const std::string name = data.cFileName;
+		if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && name != "." && name != "..")
+			result.push_back(name);
+	} while (FindNextFileA(find, &data));
+
+	FindClose(find);
+#else
+	const auto directory = opendir(path.c_str());
+	if (!directory)
+		return result;
+
+	while (const auto entry = readdir(directory))
+	{
+		const std::string name = entry->d_name;
+		struct stat info;
+		if (name != "." && name != ".." && stat((path + "/" + name).c_str(), &info) == 0 && S_ISDIR(info.st_mode))
+			result.push_back(name);
+	}
+
+	closedir(directory);
+#endif
+
+	return result;
+}
+
+bool File::WriteAllBytes(const std::string &path, const void *data, size_t size)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	file.write(static_cast<const char *>(data), size);
+	return file.good();
+}
+
+MemoryMappedFile::MemoryMappedFile()
+	: m_Data(nullptr), m_Size(0), m_File(nullptr), m_Mapping(nullptr)
+{
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+	Close();
+}
+
+bool MemoryMappedFile::Open(const std::string &path)
+{
+	Close();
+
+#ifdef _WIN32
+	const auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	const auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const auto data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!data)
+	{
+		if (mapping)
+			CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	m_File = file;
+	m_Mapping = mapping;
+	m_Size = static_cast<size_t>(size.QuadPart);
+	m_Data = data;
+#else
+	const auto file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0)
+	{
+		close(file);
+		return false;
+	}
+
+	// The mapping stays valid after the descriptor is closed
+	const auto data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED)
+		return false;
+
+	m_Size = static_cast<size_t>(info.st_size);
+	m_Data = data;
+#endif
+
+	return true;
+}
+
+void MemoryMappedFile::Close()
+{
+	if (!m_Data)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_Data);
+	CloseHandle(m_Mapping);
+	CloseHandle(m_File);
+#else
+	munmap(const_cast<void *>(m_Data), m_Size);
+#endif
+
+	m_Data = nullptr;
+	m_Size = 0;
+	m_File = nullptr;
+	m_Mapping = nullptr;
+}
+
+bool MemoryMappedFile::IsOpen() const
+{
+	return m_Data != nullptr;
+}
+
+const void *MemoryMappedFile::GetData() const
+{
+	return m_Data;
+}
+
+size_t MemoryMappedFile::GetSize() const
+{
+	return m_Size;
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Exception.h"
+#include <cstddef>
 #include <vector>
 #include <string>
 
@@ -11,4 +12,37 @@ class File
 public:
 	static bool Exists(const std::string &path);
 	static std::vector<std::string> ReadAllLines(const std::string &path);
+	static std::vector<char> ReadAllBytes(const std::string &path);
+	static std::vector<std::string> ListDirectories(const std::string &path); // Names only, empty if the path does not exist
+
+	// Returns false if the file could not be written
+	static bool WriteAllBytes(const std::string &path, const void *data, size_t size);
+};
+
+// Read only view of a whole file, pages are loaded by the OS on first access
+class MemoryMappedFile
+{
+	const void *m_Data;
+	size_t m_Size;
+	void *m_File;
+	void *m_Mapping;
+
+public:
+	MemoryMappedFile();
+	~MemoryMappedFile();
+
+	// No copying/moving
+	MemoryMappedFile(const MemoryMappedFile &) = delete;
+	MemoryMappedFile &operator=(const MemoryMappedFile &) = delete;
+
+	MemoryMappedFile(const MemoryMappedFile &&) = delete;
+	MemoryMappedFile &operator=(const MemoryMappedFile &&) = delete;
+
+	// Returns false if the file does not exist or is empty
+	bool Open(const std::string &path);
+	void Close();
+
+	bool IsOpen() const;
+	const void *GetData() const;
+	size_t GetSize() const;
 };
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#define HASH_FNV_OFFSET 2166136261u
+#define HASH_FNV_PRIME 16777619u
+#define HASH_FNV_OFFSET_64 14695981039346656037ull
+#define HASH_FNV_PRIME_64 1099511628211ull
+
+// 32 bit FNV-1a, constexpr so literal names are hashed at compile time
+constexpr uint32_t HashString(const char *str, uint32_t hash = HASH_FNV_OFFSET)
+{
+	return *str ? HashString(str + 1, (hash ^ static_cast<uint8_t>(*str)) * HASH_FNV_PRIME) : hash;
+}
+
+// 64 bit FNV-1a over raw bytes, pass the previous result to hash several buffers
+inline uint64_t HashBytes(const void *data, size_t size, uint64_t hash = HASH_FNV_OFFSET_64)
+{
+	const auto bytes = static_cast<const uint8_t *>(data);
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * HASH_FNV_PRIME_64;
+
+	return hash;
+}
\ No newline at end of file
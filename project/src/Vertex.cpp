@@ -44,31 +44,50 @@ void VertexArray::init()
 		const auto &attribute = m_Attributes[i];
 		glEnableVertexAttribArray(i);
 		glVertexAttribFormat(i, attribute.GetCount(), attribute.GetType(), attribute.IsNormalized(), position);
-		glVertexAttribBinding(i, 0); // Use binding for VBO 0
+		glVertexAttribBinding(i, VERTEX_BINDING);
 
 		// Update pointer position
 		position += attribute.GetSize() * attribute.GetCount();
 	}
+
+	// Instance attributes follow the vertex attributes
+	position = 0;
+	for (size_t i = 0; i < m_InstanceAttributes.size(); i++)
+	{
+		const auto &attribute = m_InstanceAttributes[i];
+		const auto index = m_Attributes.size() + i;
+		glEnableVertexAttribArray(index);
+		glVertexAttribFormat(index, attribute.GetCount(), attribute.GetType(), attribute.IsNormalized(), position);
+		glVertexAttribBinding(index, VERTEX_INSTANCE_BINDING);
+
+		// Update pointer position
+		position += attribute.GetSize() * attribute.GetCount();
+	}
+
+	if (!m_InstanceAttributes.empty())
+		glVertexBindingDivisor(VERTEX_INSTANCE_BINDING, 1);
 }
 
 void VertexArray::shutdown()
 {
 	// Disable attribute pointers
-	for (size_t i = 0; i < m_Attributes.size(); i++)
+	for (size_t i = 0; i < m_Attributes.size() + m_InstanceAttributes.size(); i++)
 		glDisableVertexAttribArray(i);
 
 	// Unbind
 	glDeleteVertexArrays(1, &m_ID);
 }
 
-VertexArray::VertexArray(std::vector<VertexAttribute> attributes)
-	: m_ID(0), m_Attributes(std::move(attributes)), m_Stride(0)
+VertexArray::VertexArray(std::vector<VertexAttribute> attributes, std::vector<VertexAttribute> instanceAttributes)
+	: m_ID(0), m_Attributes(std::move(attributes)), m_InstanceAttributes(std::move(instanceAttributes)), m_Stride(0), m_InstanceStride(0)
 {
 	init();
 
 	// Update stride
 	for (auto &attribute : m_Attributes)
 		m_Stride += attribute.GetSize() * attribute.GetCount();
+	for (auto &attribute : m_InstanceAttributes)
+		m_InstanceStride += attribute.GetSize() * attribute.GetCount();
 }
 
 VertexArray::~VertexArray()
@@ -76,10 +95,12 @@ VertexArray::~VertexArray()
 	shutdown();
 
 	m_Attributes.clear();
+	m_InstanceAttributes.clear();
 }
 
 VertexArray::VertexArray(const VertexArray &copy)
-	: m_ID(0), m_Attributes(copy.m_Attributes), m_Stride(copy.m_Stride)
+	: m_ID(0), m_Attributes(copy.m_Attributes), m_InstanceAttributes(copy.m_InstanceAttributes), m_Stride(copy.m_Stride), 
+	m_InstanceStride(copy.m_InstanceStride)
 {
 	init();
 }
@@ -89,9 +110,12 @@ VertexArray &VertexArray::operator=(const VertexArray &copy)
 	shutdown();
 
 	m_Attributes.clear();
+	m_InstanceAttributes.clear();
 
 	m_Attributes = copy.m_Attributes;
+	m_InstanceAttributes = copy.m_InstanceAttributes;
 	m_Stride = copy.m_Stride;
+	m_InstanceStride = copy.m_InstanceStride;
 
 	init();
 
@@ -103,11 +127,26 @@ std::vector<VertexAttribute> VertexArray::GetAttributes() const
 	return m_Attributes;
 }
 
+std::vector<VertexAttribute> VertexArray::GetInstanceAttributes() const
+{
+	return m_InstanceAttributes;
+}
+
 unsigned int VertexArray::GetStride() const
 {
 	return m_Stride;
 }
 
+unsigned int VertexArray::GetInstanceStride() const
+{
+	return m_InstanceStride;
+}
+
+GLuint VertexArray::GetID() const
+{
+	return m_ID;
+}
+
 void VertexArray::Bind()
 {
 	// Set active
@@ -34,17 +34,22 @@ public:
 	size_t GetSize() const;
 };
 
+#define VERTEX_BINDING 0
+#define VERTEX_INSTANCE_BINDING 1
+
 class VertexArray
 {
 	GLuint m_ID;
 	std::vector<VertexAttribute> m_Attributes;
+	std::vector<VertexAttribute> m_InstanceAttributes; // Advanced once per instance
 	unsigned int m_Stride;
+	unsigned int m_InstanceStride;
 
 	void init();
 	void shutdown();
 
 public:
-	VertexArray(std::vector<VertexAttribute> attributes = {});
+	VertexArray(std::vector<VertexAttribute> attributes = {}, std::vector<VertexAttribute> instanceAttributes = {});
 	~VertexArray();
 
 	VertexArray(const VertexArray &copy);
@@ -55,7 +60,11 @@ public:
 	VertexArray &operator=(const VertexArray &&) = delete;
 
 	std::vector<VertexAttribute> GetAttributes() const;
+	std::vector<VertexAttribute> GetInstanceAttributes() const;
 	unsigned int GetStride() const;
+	unsigned int GetInstanceStride() const;
+
+	GLuint GetID() const;
 
 	void Bind();
 };
@@ -116,7 +125,45 @@ public:
 
 	void Bind()
 	{
-		glBindVertexBuffer(0, m_ID, 0, m_Array->GetStride());
+		glBindVertexBuffer(VERTEX_BINDING, m_ID, 0, m_Array->GetStride());
+	}
+};
+
+// Per instance data, updated dynamically
+template<typename TInstance>
+class InstanceBuffer : public Buffer
+{
+	VertexArray *m_Array;
+	unsigned int m_Count;
+
+public:
+	InstanceBuffer(VertexArray *vertexArray, const void *data, unsigned int count, Usage usage = kUsage_DynamicDraw)
+		: Buffer(kTarget_ArrayBuffer, usage, sizeof(TInstance) * count, data), m_Array(vertexArray), m_Count(count)
+	{
+	}
+
+	~InstanceBuffer() = default;
+
+	// No copying/moving
+	InstanceBuffer(const InstanceBuffer &) = delete;
+	InstanceBuffer &operator=(const InstanceBuffer &) = delete;
+
+	InstanceBuffer(const InstanceBuffer &&) = delete;
+	InstanceBuffer &operator=(const InstanceBuffer &&) = delete;
+
+	void SetData(unsigned int index, unsigned int count, const TInstance *data)
+	{
+		Buffer::SetData(index * sizeof(TInstance), count * sizeof(TInstance), data);
+	}
+
+	unsigned int GetCount() const
+	{
+		return m_Count;
+	}
+
+	void Bind()
+	{
+		glBindVertexBuffer(VERTEX_INSTANCE_BINDING, m_ID, 0, m_Array->GetInstanceStride());
 	}
 };
 
@@ -176,20 +223,22 @@ public:
 	}
 };
 
-template<typename TVertex>
+// TInstance separates the shared vertex array of instanced and non-instanced formats
+template<typename TVertex, typename TInstance = void>
 class VertexFormat
 {
 	std::vector<VertexAttribute> m_Attributes;
+	std::vector<VertexAttribute> m_InstanceAttributes;
 
 public:
-	VertexFormat(std::vector<VertexAttribute> attributes)
-		: m_Attributes(attributes)
+	VertexFormat(std::vector<VertexAttribute> attributes, std::vector<VertexAttribute> instanceAttributes = {})
+		: m_Attributes(attributes), m_InstanceAttributes(instanceAttributes)
 	{
 	}
 
 	VertexArray *GetArray() const
 	{
-		static VertexArray instance(m_Attributes);
+		static VertexArray instance(m_Attributes, m_InstanceAttributes);
 		return &instance;
 	}
 };
\ No newline at end of file
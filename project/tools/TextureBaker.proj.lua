@@ -0,0 +1,33 @@
+project "TextureBaker"
+	kind "ConsoleApp"
+	language "C++"
+	characterset "MBCS"
+	systemversion "latest"
+	
+	includedirs {
+		"../../dependencies/RapidJSON/include",
+		"../../dependencies/STB",
+		"../src",
+	}
+	
+	files {
+		"TextureBaker/**.cpp",
+		"../src/JobSystem.cpp",
+		"../src/TextureCompression.cpp",
+		"../src/Utility/Exception.cpp",
+		"../src/Utility/FileUtil.cpp",
+		"../src/Utility/StringUtil.cpp"
+	}
+	
+	dependson {
+		"rapidjson",
+		"STB"
+	}
+	
+	filter "configurations:Debug"
+		defines { "DEBUG" }
+		symbols "On"
+
+	filter "configurations:Release"
+		defines { "NDEBUG" }
+		optimize "On"
\ No newline at end of file
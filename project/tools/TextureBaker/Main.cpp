@@ -0,0 +1,136 @@
+// Bakes the mip chain of every texture into a container, block compressed if the meta data
+// asks for it, read by the project instead of decoding the source image.
+// Usage: TextureBaker <textures directory> [texture names...]
+#include "JobSystem.h"
+#include "TextureCompression.h"
+#include "Utility/FileUtil.h"
+#include "Utility/StringUtil.h"
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Returns false on failure, skipped textures count as baked
+static bool bakeTexture(const std::string &path, const std::string &name, JobSystem *jobSystem)
+{
+	const auto metaSource = String::Join(File::ReadAllLines(path + "/" + name + "/meta.json"), "\n");
+
+	// Parsed like the project does, so both hash the same settings
+	TextureMeta meta;
+	std::string error;
+	if (!ParseTextureMeta(metaSource, meta, error))
+	{
+		printf("%s: meta data %s\n", name.c_str(), error.c_str());
+		return false;
+	}
+
+	const auto compression = meta.Compression;
+	const auto mipmaps = meta.Mipmaps;
+	const auto mipFilter = meta.MipFilter;
+
+	// Loaded straight from the source image
+	if (compression == kTextureCompression_None && !mipmaps)
+	{
+		printf("%s: no mip levels and not compressed, skipped\n", name.c_str());
+		return true;
+	}
+
+	const auto basePath = path + "/" + name + "/" + meta.Name;
+	const auto sourcePath = basePath + "." + meta.Extension;
+	const auto source = File::ReadAllBytes(sourcePath);
+
+	const auto startTime = std::chrono::steady_clock::now();
+
+	// Flipped like the project does when decoding
+	stbi_set_flip_vertically_on_load(true);
+
+	int width, height, channels;
+	const auto data = stbi_load_from_memory(reinterpret_cast<const stbi_uc *>(source.data()), static_cast<int>(source.size()),
+		&width, &height, &channels, 4);
+	if (!data)
+	{
+		printf("%s: unable to decode %s\n", name.c_str(), sourcePath.c_str());
+		return false;
+	}
+
+	// Containers always store red first
+	if (meta.Format == kTextureFormat_BGR || meta.Format == kTextureFormat_BGRA)
+	{
+		for (size_t i = 0; i < static_cast<size_t>(width) * height; i++)
+			std::swap(data[i * 4], data[i * 4 + 2]);
+	}
+
+	std::vector<std::vector<uint8_t>> levels;
+	if (mipmaps)
+		BuildTextureMipChain(data, width, height, mipFilter, levels, jobSystem);
+	else levels.emplace_back(data, data + static_cast<size_t>(width) * height * 4);
+	stbi_image_free(data);
+
+	auto levelWidth = static_cast<unsigned int>(width), levelHeight = static_cast<unsigned int>(height);
+	size_t size = 0;
+	for (auto &level : levels)
+	{
+		std::vector<uint8_t> blocks;
+		CompressTexture(compression, level.data(), levelWidth, levelHeight, blocks);
+		level = std::move(blocks);
+		size += level.size();
+
+		levelWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+		levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+	}
+
+	const auto containerPath = basePath + TEXTURE_CONTAINER_EXTENSION;
+	const auto hash = HashTextureSource(source.data(), source.size(), mipFilter, mipmaps);
+	if (!WriteTextureContainer(containerPath, compression, width, height, hash, levels))
+	{
+		printf("%s: unable to write %s\n", name.c_str(), containerPath.c_str());
+		return false;
+	}
+
+	printf("%s: %dx%d, %u levels, %.1f MB, baked in %.1f ms\n", name.c_str(), width, height, static_cast<unsigned int>(levels.size()),
+		size / (1024.0f * 1024.0f), std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count());
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2)
+	{
+		printf("Usage: %s <textures directory> [texture names...]\n", argv[0]);
+		return 1;
+	}
+
+	const std::string path = argv[1];
+
+	// Every directory holding meta data unless names were given
+	std::vector<std::string> names;
+	for (auto i = 2; i < argc; i++)
+		names.push_back(argv[i]);
+	if (names.empty())
+		names = File::ListDirectories(path);
+
+	JobSystem jobSystem;
+
+	auto failed = 0;
+	for (const auto &name : names)
+	{
+		if (!File::Exists(path + "/" + name + "/meta.json"))
+			continue;
+
+		try
+		{
+			if (!bakeTexture(path, name, &jobSystem))
+				failed++;
+		}
+		catch (const Exception &e)
+		{
+			printf("%s: %s\n", name.c_str(), e.what());
+			failed++;
+		}
+	}
+
+	return failed ? 1 : 0;
+}
\ No newline at end of file